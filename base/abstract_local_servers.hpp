@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cinttypes>
+
+#include "base/message.hpp"
+
+namespace csci5570 {
+
+/*
+ * The server threads on the node of a worker, which the worker calls directly instead of going through the
+ * sender and the mailbox. The messages are served on the calling thread under the same consistency rules as
+ * the queued ones.
+ */
+class AbstractLocalServers {
+ public:
+  virtual ~AbstractLocalServers() {}
+  // whether the server thread is on this node
+  virtual bool IsLocal(uint32_t sid) const = 0;
+  // serve a kClock, kAdd or kPush, whose replies, if any, go through the reply queue as usual
+  virtual void Serve(Message& msg) = 0;
+  // serve a kGet into reply and return true if the consistency allows it now, return false otherwise
+  virtual bool TryGet(Message& msg, Message* reply) = 0;
+};
+
+}  // namespace csci5570
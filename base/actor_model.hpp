@@ -12,7 +12,11 @@ namespace csci5570 {
 
 class Actor {
  public:
-  Actor(uint32_t actor_id) : id_(actor_id) {}
+  Actor(uint32_t actor_id)
+      : Actor(actor_id, std::unique_ptr<ThreadsafeQueue<Message>>(new ThreadsafeQueue<Message>())) {}
+  // with a work queue of another order than first in first out
+  Actor(uint32_t actor_id, std::unique_ptr<ThreadsafeQueue<Message>>&& work_queue)
+      : id_(actor_id), work_queue_(std::move(work_queue)) {}
 
   void Start() {  // start a working thread
     working_thread_ = std::thread([this] { Main(); });
@@ -22,7 +26,7 @@ class Actor {
     working_thread_.join();
   }
 
-  ThreadsafeQueue<Message>* GetWorkQueue() { return &work_queue_; }   // getter of work queue
+  ThreadsafeQueue<Message>* GetWorkQueue() { return work_queue_.get(); }   // getter of work queue
 
   uint32_t GetId() const { return id_; }                       // getter of actor thread id
  protected:
@@ -30,7 +34,7 @@ class Actor {
 
   uint32_t id_;
   std::thread working_thread_;
-  ThreadsafeQueue<Message> work_queue_;
+  std::unique_ptr<ThreadsafeQueue<Message>> work_queue_;
 };
 
 }  // namespace csci5570
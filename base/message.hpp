@@ -12,14 +12,32 @@ namespace csci5570 {
 
 struct Control {};
 
-enum class Flag : char { kExit, kBarrier, kResetWorkerInModel, kClock, kAdd, kGet, kHeartbeat };// add flag heartbeat
-static const char* FlagName[] = {"kExit", "kBarrier", "kResetWorkerInModel", "kClock", "kAdd", "kGet", "kHeartbeat"};
+// add flag heartbeat; kPush is a one-way kAdd, which the server applies without replying
+// kReplicate carries the rows of hot keys from their primary server to a replica, and kGetReplica reads them there
+// kRefresh carries the rows a worker reads from an eager SSP server to the worker, unrequested
+// kBatch carries several messages to the threads of a node, and is split by its mailbox, see comm/message_batch.hpp
+enum class Flag : char {
+  kExit,
+  kBarrier,
+  kResetWorkerInModel,
+  kClock,
+  kAdd,
+  kGet,
+  kHeartbeat,
+  kPush,
+  kReplicate,
+  kGetReplica,
+  kRefresh,
+  kBatch
+};
+static const char* FlagName[] = {"kExit", "kBarrier", "kResetWorkerInModel", "kClock", "kAdd", "kGet", "kHeartbeat",
+                                 "kPush", "kReplicate", "kGetReplica", "kRefresh", "kBatch"};
 
 struct Meta {
   int sender;
   int recver;
   int model_id;
-  Flag flag;  // {kExit, kBarrier, kResetWorkerInModel, kClock, kAdd, kGet}
+  Flag flag;  // see Flag
   int round; // for kGet Msg, indicate the round of iterations of the key
   time_t timestamp;
 
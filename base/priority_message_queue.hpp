@@ -0,0 +1,133 @@
+#pragma once
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/message.hpp"
+#include "base/threadsafe_queue.hpp"
+
+namespace csci5570 {
+
+/*
+ * A work queue popping the messages by urgency rather than by arrival, so a burst of large Adds does not hold back
+ * the Gets blocking the workers or the Clocks gating the other workers:
+ * - control: kClock, kResetWorkerInModel, kBarrier
+ * - reads: kGet, kGetReplica, and kReplicate, which serves the waiting kGetReplica
+ * - updates: kAdd, kPush
+ * - the others, kExit among them, last
+ *
+ * The messages of a sender are popped in the order they were pushed, so a worker still reads its own Pushes and
+ * its Adds still land before its Clock. Only the messages of different senders, which are concurrent anyway, are
+ * reordered. A message still waiting after max_age later messages were pushed is popped before any other, so a
+ * steady stream of urgent messages does not starve the updates.
+ */
+class PriorityMessageQueue : public ThreadsafeQueue<Message> {
+ public:
+  static const uint64_t kDefaultMaxAge = 1024;
+  static const int kNumClasses = 4;
+
+  /**
+   * @param max_age   the messages pushed after a message before it is popped first whatever its class
+   */
+  explicit PriorityMessageQueue(uint64_t max_age = kDefaultMaxAge) : max_age_(max_age) {}
+
+  // the class of a message, 0 being the most urgent
+  static int ClassOf(const Message& msg) {
+    switch (msg.meta.flag) {
+      case Flag::kClock:
+      case Flag::kResetWorkerInModel:
+      case Flag::kBarrier:
+        return 0;
+      case Flag::kGet:
+      case Flag::kGetReplica:
+      case Flag::kReplicate:
+        return 1;
+      case Flag::kAdd:
+      case Flag::kPush:
+        return 2;
+      default:
+        return 3;
+    }
+  }
+
+  virtual void Push(Message msg) override {
+    mu_.lock();
+    uint32_t sender = msg.meta.sender;
+    auto& lane = lanes_[sender];
+    lane.push_back(Entry{next_seq_++, std::move(msg)});
+    if (lane.size() == 1)
+      heads_[ClassOf(lane.front().msg)].insert(std::make_pair(lane.front().seq, sender));
+    size_ += 1;
+    mu_.unlock();
+    cond_.notify_all();
+  }
+
+  virtual void WaitAndPop(Message* msg) override {
+    std::unique_lock<std::mutex> lk(mu_);
+    cond_.wait(lk, [this] { return size_ > 0; });
+    *msg = PopLocked();
+  }
+
+  /**
+   * Wait until the queue is not empty and move all of its messages, in the order they would be popped one by one,
+   * to the end of msgs
+   */
+  virtual void WaitAndPopAll(std::vector<Message>* msgs) override {
+    std::unique_lock<std::mutex> lk(mu_);
+    cond_.wait(lk, [this] { return size_ > 0; });
+    while (size_ > 0) {
+      msgs->push_back(PopLocked());
+    }
+  }
+
+  virtual int Size() override {
+    std::lock_guard<std::mutex> lk(mu_);
+    return size_;
+  }
+
+ private:
+  struct Entry {
+    uint64_t seq;  // the order of the push
+    Message msg;
+  };
+  using Head = std::pair<uint64_t, uint32_t>;  // (seq, sender) of the first message of a sender
+
+  // Pop the oldest message if it aged, or else the oldest of the most urgent class
+  Message PopLocked() {
+    std::set<Head>* from = nullptr;
+    for (auto& heads : heads_) {
+      if (!heads.empty() && (from == nullptr || *heads.begin() < *from->begin()))
+        from = &heads;
+    }
+    if (next_seq_ - from->begin()->first - 1 <= max_age_) {  // not more than max_age pushed after it
+      for (auto& heads : heads_) {
+        if (!heads.empty()) {
+          from = &heads;
+          break;
+        }
+      }
+    }
+    uint32_t sender = from->begin()->second;
+    from->erase(from->begin());
+    auto lane = lanes_.find(sender);
+    Message msg = std::move(lane->second.front().msg);
+    lane->second.pop_front();
+    if (lane->second.empty())
+      lanes_.erase(lane);
+    else
+      heads_[ClassOf(lane->second.front().msg)].insert(std::make_pair(lane->second.front().seq, sender));
+    size_ -= 1;
+    return msg;
+  }
+
+  uint64_t max_age_;
+  uint64_t next_seq_ = 0;
+  int size_ = 0;
+  std::unordered_map<uint32_t, std::deque<Entry>> lanes_;  // {sender: its messages in order}
+  std::set<Head> heads_[kNumClasses];                        // the first message of each sender, by class
+};
+
+}  // namespace csci5570
@@ -0,0 +1,80 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "base/priority_message_queue.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestPriorityMessageQueue : public testing::Test {
+ public:
+  TestPriorityMessageQueue() {}
+  ~TestPriorityMessageQueue() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+Message MakeMessage(Flag flag, uint32_t sender) {
+  Message msg;
+  msg.meta.flag = flag;
+  msg.meta.sender = sender;
+  return msg;
+}
+
+std::vector<uint32_t> PopSenders(ThreadsafeQueue<Message>* queue) {
+  std::vector<uint32_t> senders;
+  while (queue->Size() > 0) {
+    Message msg;
+    queue->WaitAndPop(&msg);
+    senders.push_back(msg.meta.sender);
+  }
+  return senders;
+}
+
+TEST_F(TestPriorityMessageQueue, PopByClass) {
+  PriorityMessageQueue queue;
+  queue.Push(MakeMessage(Flag::kExit, 0));
+  queue.Push(MakeMessage(Flag::kAdd, 1));
+  queue.Push(MakeMessage(Flag::kPush, 2));
+  queue.Push(MakeMessage(Flag::kGet, 3));
+  queue.Push(MakeMessage(Flag::kClock, 4));
+  queue.Push(MakeMessage(Flag::kGetReplica, 5));
+  EXPECT_EQ(queue.Size(), 6);
+  EXPECT_EQ(PopSenders(&queue), std::vector<uint32_t>({4, 3, 5, 1, 2, 0}));
+}
+
+TEST_F(TestPriorityMessageQueue, KeepOrderOfSender) {
+  PriorityMessageQueue queue;
+  // the Clock of sender 1 waits for its Push, which waits for the Get of sender 2
+  queue.Push(MakeMessage(Flag::kPush, 1));
+  queue.Push(MakeMessage(Flag::kClock, 1));
+  queue.Push(MakeMessage(Flag::kGet, 2));
+  std::vector<Message> msgs;
+  queue.WaitAndPopAll(&msgs);
+  ASSERT_EQ(msgs.size(), 3);
+  EXPECT_EQ(msgs[0].meta.flag, Flag::kGet);
+  EXPECT_EQ(msgs[1].meta.flag, Flag::kPush);
+  EXPECT_EQ(msgs[2].meta.flag, Flag::kClock);
+  EXPECT_EQ(queue.Size(), 0);
+}
+
+TEST_F(TestPriorityMessageQueue, Aging) {
+  PriorityMessageQueue queue(2);
+  queue.Push(MakeMessage(Flag::kAdd, 1));
+  queue.Push(MakeMessage(Flag::kGet, 2));
+  queue.Push(MakeMessage(Flag::kGet, 3));
+  // the Add has seen 2 messages pushed after it
+  Message msg;
+  queue.WaitAndPop(&msg);
+  EXPECT_EQ(msg.meta.sender, 2);
+  // and now 3
+  queue.Push(MakeMessage(Flag::kGet, 4));
+  EXPECT_EQ(PopSenders(&queue), std::vector<uint32_t>({1, 3, 4}));
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -69,6 +69,9 @@ class MyFakeModel : public AbstractModel {
   virtual void ResetWorker(Message& msg) override {}
   virtual void Backup() override {}
   virtual int Recovery() override {}
+  virtual void SetCheckpointPrefix(const std::string&) override {}
+  virtual void SetReplicator(std::unique_ptr<Replicator>&&) override {}
+  virtual void Replicate(Message&) override {}
 
  private:
   std::unique_ptr<AbstractStorage> storage_;
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+namespace csci5570 {
+
+/*
+ * How the parameters of a table are kept by the servers and sent in Get replies
+ */
+enum class Precision {
+  Full,  // the value type of the table
+  FP16,  // IEEE 754 half precision
+  BF16,  // bfloat16: the upper half of a float
+  Int8   // int8 with one float scale per block of kInt8Block values
+};
+
+inline uint16_t FloatToHalf(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t abs = x & 0x7fffffff;
+  if (abs >= 0x7f800000)  // inf or nan
+    return sign | 0x7c00 | (abs > 0x7f800000 ? 0x200 : 0);
+  if (abs >= 0x477ff000)  // rounds beyond the largest half, 65504
+    return sign | 0x7c00;
+  if (abs < 0x38800000) {  // a subnormal half
+    if (abs < 0x33000000)
+      return sign;
+    uint32_t exp = abs >> 23;
+    uint32_t mant = (abs & 0x7fffff) | 0x800000;
+    int shift = 126 - exp;
+    uint32_t half = mant >> shift;
+    uint32_t rem = mant & ((1u << shift) - 1);
+    uint32_t mid = 1u << (shift - 1);
+    if (rem > mid || (rem == mid && (half & 1)))  // round to nearest even
+      half++;
+    return sign | half;
+  }
+  uint32_t half = (abs - 0x38000000) >> 13;  // rebias the exponent from 127 to 15
+  uint32_t rem = abs & 0x1fff;
+  if (rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+    half++;
+  return sign | half;
+}
+
+inline float HalfToFloat(uint16_t h) {
+  uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+  uint32_t exp = (h >> 10) & 0x1f;
+  uint32_t mant = h & 0x3ff;
+  uint32_t x;
+  if (exp == 0) {
+    float f = mant * (1.0f / 16777216);  // subnormal: mant * 2^-24
+    return sign ? -f : f;
+  } else if (exp == 31) {
+    x = sign | 0x7f800000 | (mant << 13);
+  } else {
+    x = sign | ((exp + 112) << 23) | (mant << 13);
+  }
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+inline uint16_t FloatToBFloat16(float f) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  if ((x & 0x7fffffff) > 0x7f800000)  // keep nan a (quiet) nan
+    return (x >> 16) | 0x40;
+  x += 0x7fff + ((x >> 16) & 1);  // round to nearest even
+  return x >> 16;
+}
+
+inline float BFloat16ToFloat(uint16_t b) {
+  uint32_t x = static_cast<uint32_t>(b) << 16;
+  float f;
+  std::memcpy(&f, &x, sizeof(f));
+  return f;
+}
+
+/*
+ * Round to one of the two neighbouring halves, up with a probability of the distance to the lower one over the
+ * gap, using the random bits in noise. Values below 2^-32 flush to zero, and inf, nan and values beyond the
+ * largest half round as FloatToHalf does.
+ */
+inline uint16_t FloatToHalfStochastic(float f, uint32_t noise) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  uint32_t sign = (x >> 16) & 0x8000;
+  uint32_t abs = x & 0x7fffffff;
+  if (abs >= 0x477fe000)  // 65504, the largest half
+    return FloatToHalf(f);
+  if (abs < 0x38800000) {  // a subnormal half
+    int shift = 126 - static_cast<int>(abs >> 23);
+    if (shift >= 32)
+      return sign;
+    uint32_t mant = (abs & 0x7fffff) | 0x800000;
+    uint32_t mask = (1u << shift) - 1;
+    uint32_t half = mant >> shift;
+    if ((noise & mask) < (mant & mask))
+      half++;
+    return sign | half;
+  }
+  uint32_t half = (abs - 0x38000000) >> 13;
+  if ((noise & 0x1fff) < (abs & 0x1fff))
+    half++;
+  return sign | half;
+}
+
+/*
+ * As FloatToHalfStochastic, for bfloat16
+ */
+inline uint16_t FloatToBFloat16Stochastic(float f, uint32_t noise) {
+  uint32_t x;
+  std::memcpy(&x, &f, sizeof(x));
+  if ((x & 0x7fffffff) >= 0x7f7f0000)  // nan, inf and the largest bfloat16
+    return FloatToBFloat16(f);
+  return (x + (noise & 0xffff)) >> 16;
+}
+
+/*
+ * Encodes a row of dim values to bytes in a given precision. The servers keep the rows encoded and send them
+ * as they are in Get replies, which the workers decode back to Val.
+ *
+ * Int8 rows are laid out as [one float scale per block of kInt8Block values][dim int8], where a value is
+ * its int8 times the scale of its block.
+ */
+template <typename Val>
+class RowCodec {
+ public:
+  static const size_t kInt8Block = 64;
+
+  RowCodec(Precision precision, size_t dim) : precision_(precision), dim_(dim) {}
+
+  Precision GetPrecision() const { return precision_; }
+  size_t GetDim() const { return dim_; }
+
+  /**
+   * Return the number of bytes of an encoded row
+   */
+  size_t RowBytes() const {
+    switch (precision_) {
+    case Precision::FP16:
+    case Precision::BF16:
+      return dim_ * sizeof(uint16_t);
+    case Precision::Int8:
+      return NumInt8Blocks() * sizeof(float) + dim_;
+    case Precision::Full:
+    default:
+      return dim_ * sizeof(Val);
+    }
+  }
+
+  /**
+   * Encode a row, rounding to nearest, or stochastically with the random bits of rng if given, so that the
+   * small updates applied to an encoded row add up in expectation instead of being rounded away
+   */
+  void Encode(const Val* row, char* bytes, std::mt19937* rng = nullptr) const {
+    switch (precision_) {
+    case Precision::FP16:
+      for (size_t i = 0; i < dim_; i++) {
+        float f = static_cast<float>(row[i]);
+        uint16_t h = rng == nullptr ? FloatToHalf(f) : FloatToHalfStochastic(f, (*rng)());
+        std::memcpy(bytes + i * sizeof(h), &h, sizeof(h));
+      }
+      break;
+    case Precision::BF16:
+      for (size_t i = 0; i < dim_; i++) {
+        float f = static_cast<float>(row[i]);
+        uint16_t b = rng == nullptr ? FloatToBFloat16(f) : FloatToBFloat16Stochastic(f, (*rng)());
+        std::memcpy(bytes + i * sizeof(b), &b, sizeof(b));
+      }
+      break;
+    case Precision::Int8: {
+      int8_t* quantized = reinterpret_cast<int8_t*>(bytes + NumInt8Blocks() * sizeof(float));
+      for (size_t block = 0; block < NumInt8Blocks(); block++) {
+        size_t begin = block * kInt8Block;
+        size_t end = std::min(begin + kInt8Block, dim_);
+        float max_abs = 0;
+        for (size_t i = begin; i < end; i++) {
+          max_abs = std::max(max_abs, std::abs(static_cast<float>(row[i])));
+        }
+        float scale = max_abs / 127;
+        std::memcpy(bytes + block * sizeof(float), &scale, sizeof(scale));
+        for (size_t i = begin; i < end; i++) {
+          if (scale == 0) {
+            quantized[i] = 0;
+          } else if (rng == nullptr) {
+            quantized[i] = static_cast<int8_t>(std::lround(static_cast<float>(row[i]) / scale));
+          } else {
+            float u = ((*rng)() >> 8) * (1.0f / 16777216);  // uniform in [0, 1)
+            float q = std::floor(static_cast<float>(row[i]) / scale + u);
+            quantized[i] = static_cast<int8_t>(std::max(-127.0f, std::min(127.0f, q)));
+          }
+        }
+      }
+      break;
+    }
+    case Precision::Full:
+    default:
+      std::memcpy(bytes, row, dim_ * sizeof(Val));
+    }
+  }
+
+  void Decode(const char* bytes, Val* row) const {
+    switch (precision_) {
+    case Precision::FP16:
+      for (size_t i = 0; i < dim_; i++) {
+        uint16_t h;
+        std::memcpy(&h, bytes + i * sizeof(h), sizeof(h));
+        row[i] = static_cast<Val>(HalfToFloat(h));
+      }
+      break;
+    case Precision::BF16:
+      for (size_t i = 0; i < dim_; i++) {
+        uint16_t b;
+        std::memcpy(&b, bytes + i * sizeof(b), sizeof(b));
+        row[i] = static_cast<Val>(BFloat16ToFloat(b));
+      }
+      break;
+    case Precision::Int8: {
+      const int8_t* quantized = reinterpret_cast<const int8_t*>(bytes + NumInt8Blocks() * sizeof(float));
+      for (size_t block = 0; block < NumInt8Blocks(); block++) {
+        float scale;
+        std::memcpy(&scale, bytes + block * sizeof(float), sizeof(scale));
+        size_t end = std::min((block + 1) * kInt8Block, dim_);
+        for (size_t i = block * kInt8Block; i < end; i++) {
+          row[i] = static_cast<Val>(quantized[i] * scale);
+        }
+      }
+      break;
+    }
+    case Precision::Full:
+    default:
+      std::memcpy(row, bytes, dim_ * sizeof(Val));
+    }
+  }
+
+ private:
+  size_t NumInt8Blocks() const { return (dim_ + kInt8Block - 1) / kInt8Block; }
+
+  Precision precision_;
+  size_t dim_;
+};
+
+template <typename Val>
+const size_t RowCodec<Val>::kInt8Block;
+
+}  // namespace csci5570
@@ -0,0 +1,121 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "base/row_codec.hpp"
+
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestRowCodec : public testing::Test {
+ public:
+  TestRowCodec() {}
+  ~TestRowCodec() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestRowCodec, Half) {
+  EXPECT_EQ(FloatToHalf(1.0f), 0x3c00);
+  EXPECT_EQ(FloatToHalf(-2.0f), 0xc000);
+  EXPECT_EQ(FloatToHalf(65504.0f), 0x7bff);
+  EXPECT_EQ(FloatToHalf(1e6f), 0x7c00);  // overflows to inf
+  EXPECT_EQ(FloatToHalf(std::numeric_limits<float>::infinity()), 0x7c00);
+  EXPECT_TRUE(std::isnan(HalfToFloat(FloatToHalf(std::numeric_limits<float>::quiet_NaN()))));
+  EXPECT_EQ(HalfToFloat(FloatToHalf(5.960464477539063e-8f)), 5.960464477539063e-8f);  // the smallest subnormal
+  // ties round to even: 1 + 2^-11 lies halfway between 1 and the next half
+  EXPECT_EQ(FloatToHalf(1.0f + 1.0f / 2048), 0x3c00);
+  EXPECT_EQ(FloatToHalf(1.0f + 3.0f / 2048), 0x3c02);
+  EXPECT_EQ(HalfToFloat(FloatToHalf(0.1f)), 0.0999755859375f);
+}
+
+TEST_F(TestRowCodec, BFloat16) {
+  EXPECT_EQ(FloatToBFloat16(1.0f), 0x3f80);
+  EXPECT_EQ(BFloat16ToFloat(FloatToBFloat16(-3.0f)), -3.0f);
+  EXPECT_TRUE(std::isnan(BFloat16ToFloat(FloatToBFloat16(std::numeric_limits<float>::quiet_NaN()))));
+}
+
+TEST_F(TestRowCodec, RoundTrip) {
+  std::vector<double> row(100);
+  for (int i = 0; i < row.size(); ++ i) {
+    row[i] = std::sin(i) * (i < 64 ? 1 : 100);
+  }
+  for (Precision precision : {Precision::Full, Precision::FP16, Precision::BF16, Precision::Int8}) {
+    RowCodec<double> codec(precision, row.size());
+    std::vector<char> bytes(codec.RowBytes());
+    std::vector<double> decoded(row.size());
+    codec.Encode(row.data(), bytes.data());
+    codec.Decode(bytes.data(), decoded.data());
+    for (int i = 0; i < row.size(); ++ i) {
+      double tolerance = std::abs(row[i]) / 256;
+      if (precision == Precision::Full)
+        tolerance = 0;
+      else if (precision == Precision::Int8)
+        tolerance = (i < 64 ? 1.0 : 100.0) / 254;  // half a step of the scale of the block
+      EXPECT_NEAR(decoded[i], row[i], tolerance);
+    }
+  }
+}
+
+TEST_F(TestRowCodec, RowBytes) {
+  EXPECT_EQ(RowCodec<double>(Precision::Full, 10).RowBytes(), 80);
+  EXPECT_EQ(RowCodec<double>(Precision::FP16, 10).RowBytes(), 20);
+  EXPECT_EQ(RowCodec<float>(Precision::BF16, 10).RowBytes(), 20);
+  EXPECT_EQ(RowCodec<float>(Precision::Int8, 130).RowBytes(), 3 * sizeof(float) + 130);
+}
+
+TEST_F(TestRowCodec, Int8Zeros) {
+  RowCodec<float> codec(Precision::Int8, 4);
+  std::vector<float> row(4, 0.0f);
+  std::vector<char> bytes(codec.RowBytes(), 1);
+  codec.Encode(row.data(), bytes.data());
+  std::vector<float> decoded(4, 1.0f);
+  codec.Decode(bytes.data(), decoded.data());
+  EXPECT_EQ(decoded, row);
+}
+
+TEST_F(TestRowCodec, Stochastic) {
+  std::mt19937 rng;
+  // exact values stay exact
+  EXPECT_EQ(FloatToHalfStochastic(1.0f, 0xffffffff), 0x3c00);
+  EXPECT_EQ(FloatToBFloat16Stochastic(-3.0f, 0xffffffff), FloatToBFloat16(-3.0f));
+  EXPECT_EQ(FloatToHalfStochastic(65504.0f, 0xffffffff), 0x7bff);
+  EXPECT_EQ(FloatToHalfStochastic(1e6f, 0), 0x7c00);
+  // 1 + 2^-12 lies a quarter of the way from 1 to the next half
+  EXPECT_EQ(FloatToHalfStochastic(1.0f + 1.0f / 4096, 0x7ff), 0x3c01);
+  EXPECT_EQ(FloatToHalfStochastic(1.0f + 1.0f / 4096, 0x800), 0x3c00);
+
+  // many updates smaller than half a step add up in expectation, where rounding to nearest loses all of them
+  for (Precision precision : {Precision::FP16, Precision::BF16, Precision::Int8}) {
+    RowCodec<float> codec(precision, 2);
+    std::vector<float> row{1.27f, 1.0f};  // on the int8 grid of step 0.01
+    std::vector<char> bytes(codec.RowBytes());
+    std::vector<char> nearest_bytes(codec.RowBytes());
+    codec.Encode(row.data(), bytes.data());
+    codec.Encode(row.data(), nearest_bytes.data());
+    codec.Decode(bytes.data(), row.data());
+    const float first = row[0];
+    for (int i = 0; i < 1000; ++ i) {
+      codec.Decode(bytes.data(), row.data());
+      row[1] += 1e-4;
+      codec.Encode(row.data(), bytes.data(), &rng);
+      codec.Decode(nearest_bytes.data(), row.data());
+      row[1] += 1e-4;
+      codec.Encode(row.data(), nearest_bytes.data());
+    }
+    codec.Decode(bytes.data(), row.data());
+    EXPECT_NEAR(row[0], first, 1e-6);
+    EXPECT_NEAR(row[1], 1.1f, 0.05);
+    codec.Decode(nearest_bytes.data(), row.data());
+    EXPECT_NEAR(row[1], 1.0f, 1e-6);
+  }
+}
+
+}  // namespace
+}  // namespace csci5570
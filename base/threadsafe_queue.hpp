@@ -4,6 +4,8 @@
 #include <memory>
 #include <mutex>
 #include <queue>
+#include <utility>
+#include <vector>
 
 namespace csci5570 {
 
@@ -11,35 +13,53 @@ template <typename T>
 class ThreadsafeQueue {
  public:
   ThreadsafeQueue() = default;
-  ~ThreadsafeQueue() = default;
+  virtual ~ThreadsafeQueue() = default;
   ThreadsafeQueue(const ThreadsafeQueue&) = delete;
   ThreadsafeQueue& operator=(const ThreadsafeQueue&) = delete;
   ThreadsafeQueue(ThreadsafeQueue&&) = delete;
   ThreadsafeQueue& operator=(ThreadsafeQueue&&) = delete;
 
-  void Push(T elem) {
+  virtual void Push(T elem) {
     mu_.lock();
     queue_.push(std::move(elem));
     mu_.unlock();
     cond_.notify_all();
   }
 
-  void WaitAndPop(T* elem) {
+  virtual void WaitAndPop(T* elem) {
     std::unique_lock<std::mutex> lk(mu_);
     cond_.wait(lk, [this] { return !queue_.empty(); });
     *elem = std::move(queue_.front());
     queue_.pop();
   }
 
-  int Size() {
+  /**
+   * Wait until the queue is not empty and move all of its elements, in order, to the end of elems
+   */
+  virtual void WaitAndPopAll(std::vector<T>* elems) {
+    std::queue<T> popped;
+    {
+      std::unique_lock<std::mutex> lk(mu_);
+      cond_.wait(lk, [this] { return !queue_.empty(); });
+      std::swap(popped, queue_);
+    }
+    while (!popped.empty()) {
+      elems->push_back(std::move(popped.front()));
+      popped.pop();
+    }
+  }
+
+  virtual int Size() {
     std::lock_guard<std::mutex> lk(mu_);
     return queue_.size();
   }
 
- private:
+ protected:
   std::mutex mu_;
-  std::queue<T> queue_;
   std::condition_variable cond_;
+
+ private:
+  std::queue<T> queue_;
 };
 
 }  // namespace csci5570
@@ -9,6 +9,10 @@ class AbstractMailbox {
  public:
   virtual ~AbstractMailbox() {}
   virtual int Send(const Message& msg) = 0;
+  // Return the node a message is sent to
+  virtual uint32_t GetNodeId(const Message& msg) { return 0; }
+  // Check whether a node is the one of the mailbox, whose messages are handed over without the network
+  virtual bool IsLocal(uint32_t node) { return false; }
 };
 
 }  // namespace csci5570
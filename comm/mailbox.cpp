@@ -2,6 +2,8 @@
 
 #include <algorithm>
 
+#include "comm/message_batch.hpp"
+
 #include "glog/logging.h"
 
 namespace csci5570 {
@@ -103,6 +105,8 @@ void Mailbox::Connect(const Node& node) {
     LOG(FATAL) << "connect to " + addr + " failed: " << zmq_strerror(errno);
   }
   senders_[node.id] = sender;
+  if (sender_mus_.find(node.id) == sender_mus_.end())
+    sender_mus_[node.id].reset(new std::mutex());
 }
 
 void Mailbox::Bind(const Node& node) {
@@ -130,13 +134,20 @@ void Mailbox::Receiving() {
     if (msg.meta.flag == Flag::kExit) {
       break;
     } else if (msg.meta.flag == Flag::kBarrier) {
-      std::unique_lock<std::mutex> lk(mu_);
+      std::unique_lock<std::mutex> lk(barrier_mu_);
       barrier_count_ += 1;
       if (barrier_count_ == nodes_.size()) {
         VLOG(1) << "Collected " << nodes_.size() << " barrier, Node:"
           << node_.id << " unblocking main thread";
         barrier_cond_.notify_one();
       }
+    } else if (msg.meta.flag == Flag::kBatch) {
+      std::vector<Message> msgs;
+      SplitBatch(msg, &msgs);
+      for (auto& part : msgs) {
+        CHECK(queue_map_.find(part.meta.recver) != queue_map_.end());
+        queue_map_[part.meta.recver]->Push(std::move(part));
+      }
     } else {
       CHECK(queue_map_.find(msg.meta.recver) != queue_map_.end());
       queue_map_[msg.meta.recver]->Push(std::move(msg));
@@ -144,22 +155,47 @@ void Mailbox::Receiving() {
   }
 }
 
+uint32_t Mailbox::GetNodeId(const Message& msg) {
+  if (msg.meta.flag == Flag::kBarrier || msg.meta.flag == Flag::kExit || msg.meta.flag == Flag::kBatch) {
+    // For kBarrier and kExit which are sent by the Mailbox directly, and kBatch which is sent to all the threads of
+    // a node, no need to lookup for node id.
+    return msg.meta.recver;
+  }
+  return id_mapper_->GetNodeIdForThread(msg.meta.recver);
+}
+
 int Mailbox::Send(const Message& msg) {
-  std::lock_guard<std::mutex> lk(mu_);
-  // find the socket
-  int id;
-  if (msg.meta.flag == Flag::kBarrier || msg.meta.flag == Flag::kExit) {
-    // For kBarrier and kExit which are sent by the Mailbox directly, no need to lookup for node id.
-    id = msg.meta.recver;
-  } else {
-    id = id_mapper_->GetNodeIdForThread(msg.meta.recver);
+  uint32_t id = GetNodeId(msg);
+  if (id == node_.id && msg.meta.flag == Flag::kBatch) {
+    std::vector<Message> msgs;
+    SplitBatch(msg, &msgs);
+    int send_bytes = 0;
+    for (auto& part : msgs) {
+      send_bytes += Send(part);
+    }
+    return send_bytes;
+  }
+  if (id == node_.id && msg.meta.flag != Flag::kBarrier && msg.meta.flag != Flag::kExit) {
+    // a thread of this node gets the message as Receiving would hand it over, without the round trip through the
+    // socket, the data shared rather than copied
+    auto queue = queue_map_.find(msg.meta.recver);
+    if (queue != queue_map_.end()) {
+      queue->second->Push(msg);
+      int send_bytes = sizeof(Meta);
+      for (const auto& data : msg.data) {
+        send_bytes += data.size();
+      }
+      return send_bytes;
+    }
   }
+  // find the socket
   auto it = senders_.find(id);
   if (it == senders_.end()) {
     LOG(WARNING) << "there is no socket to node " << id;
     return -1;
   }
   void* socket = it->second;
+  std::lock_guard<std::mutex> lk(*sender_mus_.at(id));
 
   // send meta
   int meta_size = sizeof(Meta);
@@ -232,11 +268,9 @@ int Mailbox::Recv(Message* msg) {
       delete zmsg;
     } else if (i == 1) {
       // Unpack the meta
-      Meta* meta = CHECK_NOTNULL((Meta*) zmq_msg_data(zmsg));
-      msg->meta.sender = meta->sender;
-      msg->meta.recver = meta->recver;
-      msg->meta.model_id = meta->model_id;
-      msg->meta.flag = meta->flag;
+      // Copy the whole meta, so that round and timestamp also reach the remote threads
+      CHECK_EQ(size, sizeof(Meta));
+      memcpy(&msg->meta, CHECK_NOTNULL(zmq_msg_data(zmsg)), sizeof(Meta));
       zmq_msg_close(zmsg);
       bool more = zmq_msg_more(zmsg);
       delete zmsg;
@@ -267,7 +301,7 @@ void Mailbox::Barrier() {
     barrier_msg.meta.flag = Flag::kBarrier;
     Send(barrier_msg);
   }
-  std::unique_lock<std::mutex> lk(mu_);
+  std::unique_lock<std::mutex> lk(barrier_mu_);
   // Very tricky. Consider to use all-one-all method instead of all-all.
   barrier_cond_.wait(lk, [this]() { return barrier_count_ >= nodes_.size(); });
   barrier_count_ -= nodes_.size();
@@ -6,6 +6,8 @@
 
 #include <atomic>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <thread>
 #include <unordered_map>
 #include <vector>
@@ -18,7 +20,11 @@ class Mailbox : public AbstractMailbox {
  public:
   Mailbox(const Node& node, const std::vector<Node>& nodes, AbstractIdMapper* id_mapper);
   void RegisterQueue(uint32_t queue_id, ThreadsafeQueue<Message>* const queue);
+  // Send a message, the sends to different nodes running in parallel; the messages to the threads registered on
+  // this node are put in their queues directly
   virtual int Send(const Message& msg) override;
+  virtual uint32_t GetNodeId(const Message& msg) override;
+  virtual bool IsLocal(uint32_t node) override { return node == node_.id; }
   int Recv(Message* msg);
   void Start();
   void Stop();
@@ -49,8 +55,10 @@ class Mailbox : public AbstractMailbox {
   // socket
   void* context_ = nullptr;
   std::unordered_map<uint32_t, void*> senders_;
+  // a zmq socket is not thread-safe, so the multipart sends to a node hold its lock; only the Barrier and the exit
+  // messages of the mailbox contend with the sender thread of the node
+  std::unordered_map<uint32_t, std::unique_ptr<std::mutex>> sender_mus_;
   void* receiver_ = nullptr;
-  std::mutex mu_;
 
   // barrier
   std::mutex barrier_mu_;
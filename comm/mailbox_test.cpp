@@ -3,6 +3,7 @@
 #include "glog/logging.h"
 
 #include "mailbox.hpp"
+#include "sender.hpp"
 
 namespace csci5570 {
 namespace {
@@ -109,6 +110,32 @@ TEST_F(TestMailbox, Receiving) {
   mailbox.Stop();
 }
 
+TEST_F(TestMailbox, SendToLocalThread) {
+  Node node{0, "localhost", 32145};
+  FakeIdMapper id_mapper;
+  Mailbox mailbox(node, {node}, &id_mapper);
+  ThreadsafeQueue<Message> queue;
+  mailbox.RegisterQueue(0, &queue);
+
+  // put in the queue without any socket
+  Message msg;
+  msg.meta.sender = 234;
+  msg.meta.recver = 0;
+  msg.meta.model_id = 45;
+  msg.meta.flag = Flag::kGet;
+  msg.meta.round = 3;
+  third_party::SArray<Key> keys{1};
+  msg.AddData(keys);
+  EXPECT_EQ(mailbox.Send(msg), sizeof(Meta) + sizeof(Key));
+  ASSERT_EQ(queue.Size(), 1);
+  Message recv_msg;
+  queue.WaitAndPop(&recv_msg);
+  EXPECT_EQ(recv_msg.meta.sender, msg.meta.sender);
+  EXPECT_EQ(recv_msg.meta.round, msg.meta.round);
+  ASSERT_EQ(recv_msg.data.size(), 1);
+  EXPECT_EQ(recv_msg.data[0].data(), msg.data[0].data());
+}
+
 TEST_F(TestMailbox, SendRecvTwoNodes) {
   Node node1{0, "localhost", 32149};
   Node node2{1, "localhost", 32148};
@@ -194,6 +221,126 @@ TEST_F(TestMailbox, ReceivingTwoNodes) {
   th2.join();
 }
 
+TEST_F(TestMailbox, ReplicateTwoNodes) {
+  Node node1{0, "localhost", 32151};
+  Node node2{1, "localhost", 32150};
+  // the replicator sends the round of the update to the remote replica in the meta
+  Message msg;
+  msg.meta.sender = 0;
+  msg.meta.recver = 1;
+  msg.meta.model_id = 45;
+  msg.meta.flag = Flag::kReplicate;
+  msg.meta.round = 7;
+  third_party::SArray<Key> keys{1};
+  third_party::SArray<float> vals{0.4};
+  msg.AddData(keys);
+  msg.AddData(vals);
+  std::thread th1([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node1, {node1, node2}, &id_mapper);
+    mailbox.ConnectAndBind();
+    mailbox.Send(msg);
+    mailbox.CloseSockets();
+  });
+  std::thread th2([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node2, {node1, node2}, &id_mapper);
+    mailbox.ConnectAndBind();
+    Message recv_msg;
+    mailbox.Recv(&recv_msg);
+    EXPECT_EQ(recv_msg.meta.sender, msg.meta.sender);
+    EXPECT_EQ(recv_msg.meta.recver, msg.meta.recver);
+    EXPECT_EQ(recv_msg.meta.model_id, msg.meta.model_id);
+    EXPECT_EQ(recv_msg.meta.flag, msg.meta.flag);
+    EXPECT_EQ(recv_msg.meta.round, msg.meta.round);
+    EXPECT_EQ(recv_msg.data.size(), 2);
+    mailbox.CloseSockets();
+  });
+  th1.join();
+  th2.join();
+}
+
+TEST_F(TestMailbox, RefreshTwoNodes) {
+  Node node1{0, "localhost", 32153};
+  Node node2{1, "localhost", 32152};
+  // an eager SSP server pushes the rows to a worker, with the clock they are valid until in the round
+  Message msg;
+  msg.meta.sender = 0;
+  msg.meta.recver = 1;
+  msg.meta.model_id = 45;
+  msg.meta.flag = Flag::kRefresh;
+  msg.meta.round = 5;
+  third_party::SArray<Key> keys{1};
+  third_party::SArray<float> vals{0.4};
+  msg.AddData(keys);
+  msg.AddData(vals);
+  std::thread th1([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node1, {node1, node2}, &id_mapper);
+    mailbox.Start();
+    mailbox.Send(msg);
+    mailbox.Stop();
+  });
+  std::thread th2([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node2, {node1, node2}, &id_mapper);
+    ThreadsafeQueue<Message> queue;
+    mailbox.RegisterQueue(1, &queue);
+    mailbox.Start();
+    Message recv_msg;
+    queue.WaitAndPop(&recv_msg);
+    EXPECT_EQ(recv_msg.meta.flag, msg.meta.flag);
+    EXPECT_EQ(recv_msg.meta.round, msg.meta.round);
+    EXPECT_EQ(recv_msg.data.size(), 2);
+    mailbox.Stop();
+  });
+  th1.join();
+  th2.join();
+}
+
+TEST_F(TestMailbox, SenderUnbatchedTwoNodes) {
+  Node node1{0, "localhost", 32155};
+  Node node2{1, "localhost", 32154};
+  // a lone message to a node is sent as it is, not in a kBatch, and must keep its meta as a batched one does
+  Message msg;
+  msg.meta.sender = 0;
+  msg.meta.recver = 1;
+  msg.meta.model_id = 45;
+  msg.meta.flag = Flag::kAdd;
+  msg.meta.round = 9;
+  msg.meta.timestamp = 1234567;
+  third_party::SArray<Key> keys{1};
+  third_party::SArray<float> vals{0.4};
+  msg.AddData(keys);
+  msg.AddData(vals);
+  std::thread th1([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node1, {node1, node2}, &id_mapper);
+    mailbox.Start();
+    Sender sender(&mailbox);
+    sender.Start();
+    sender.GetMessageQueue()->Push(msg);
+    sender.Stop();
+    mailbox.Stop();
+  });
+  std::thread th2([=]() {
+    FakeIdMapper id_mapper;
+    Mailbox mailbox(node2, {node1, node2}, &id_mapper);
+    ThreadsafeQueue<Message> queue;
+    mailbox.RegisterQueue(1, &queue);
+    mailbox.Start();
+    Message recv_msg;
+    queue.WaitAndPop(&recv_msg);
+    EXPECT_EQ(recv_msg.meta.flag, msg.meta.flag);
+    EXPECT_EQ(recv_msg.meta.round, msg.meta.round);
+    EXPECT_EQ(recv_msg.meta.timestamp, msg.meta.timestamp);
+    EXPECT_EQ(recv_msg.data.size(), 2);
+    mailbox.Stop();
+  });
+  th1.join();
+  th2.join();
+}
+
 TEST_F(TestMailbox, BarrierTwoNodes) {
   Node node1{0, "localhost", 32149};
   Node node2{1, "localhost", 32148};
@@ -0,0 +1,47 @@
+#include "comm/message_batch.hpp"
+
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+Message MakeBatch(uint32_t node, const std::vector<Message>& msgs) {
+  Message batch;
+  batch.meta.sender = -1;
+  batch.meta.recver = node;
+  batch.meta.model_id = -1;
+  batch.meta.flag = Flag::kBatch;
+  third_party::SArray<char> metas(msgs.size() * sizeof(Meta));
+  third_party::SArray<uint32_t> num_data(msgs.size());
+  for (size_t i = 0; i < msgs.size(); i++) {
+    std::memcpy(metas.data() + i * sizeof(Meta), &msgs[i].meta, sizeof(Meta));
+    num_data[i] = msgs[i].data.size();
+  }
+  batch.AddData(metas);
+  batch.AddData(num_data);
+  for (const auto& msg : msgs) {
+    batch.data.insert(batch.data.end(), msg.data.begin(), msg.data.end());
+  }
+  return batch;
+}
+
+void SplitBatch(const Message& batch, std::vector<Message>* msgs) {
+  CHECK(batch.meta.flag == Flag::kBatch);
+  CHECK_GE(batch.data.size(), 2);
+  const auto& metas = batch.data[0];  // a received frame may not be aligned for Meta
+  auto num_data = third_party::SArray<uint32_t>(batch.data[1]);
+  CHECK_EQ(metas.size(), num_data.size() * sizeof(Meta));
+  size_t next = 2;  // the first data frame of the next message
+  for (size_t i = 0; i < num_data.size(); i++) {
+    CHECK_LE(next + num_data[i], batch.data.size());
+    Message msg;
+    std::memcpy(&msg.meta, metas.data() + i * sizeof(Meta), sizeof(Meta));
+    msg.data.assign(batch.data.begin() + next, batch.data.begin() + next + num_data[i]);
+    next += num_data[i];
+    msgs->push_back(std::move(msg));
+  }
+  CHECK_EQ(next, batch.data.size());
+}
+
+}  // namespace csci5570
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "base/message.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace csci5570 {
+
+/**
+ * Frame the messages to the threads of a node in one kBatch message, sent as a single multipart message, so a
+ * burst of small messages pays the per message costs of the mailbox once. The metas of the messages are packed in
+ * the first data frame and the number of data frames of each message in the second, followed by the data frames of
+ * the messages in order, which are shared rather than copied.
+ *
+ * @param node    the node of the receivers, the receiver of the batch
+ * @param msgs    the messages
+ */
+Message MakeBatch(uint32_t node, const std::vector<Message>& msgs);
+
+/**
+ * Append the messages framed in a kBatch by MakeBatch to msgs, in order
+ */
+void SplitBatch(const Message& batch, std::vector<Message>* msgs);
+
+}  // namespace csci5570
@@ -0,0 +1,58 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "comm/message_batch.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestMessageBatch : public testing::Test {
+ public:
+  TestMessageBatch() {}
+  ~TestMessageBatch() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestMessageBatch, MakeAndSplit) {
+  std::vector<Message> msgs(3);
+  for (int i = 0; i < 3; i++) {
+    msgs[i].meta.sender = 10 + i;
+    msgs[i].meta.recver = 20 + i;
+    msgs[i].meta.model_id = 1;
+    msgs[i].meta.flag = Flag::kGet;
+    msgs[i].meta.round = i;
+  }
+  // a message without data, and one with two frames
+  msgs[1].meta.flag = Flag::kClock;
+  msgs[0].AddData(third_party::SArray<Key>({1, 2}));
+  msgs[2].AddData(third_party::SArray<Key>({3}));
+  msgs[2].AddData(third_party::SArray<float>({0.5}));
+
+  Message batch = MakeBatch(7, msgs);
+  EXPECT_EQ(batch.meta.flag, Flag::kBatch);
+  EXPECT_EQ(batch.meta.recver, 7);
+  EXPECT_EQ(batch.data.size(), 2 + 3);
+
+  std::vector<Message> split;
+  SplitBatch(batch, &split);
+  ASSERT_EQ(split.size(), 3);
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(split[i].meta.sender, 10 + i);
+    EXPECT_EQ(split[i].meta.recver, 20 + i);
+    EXPECT_EQ(split[i].meta.flag, msgs[i].meta.flag);
+    EXPECT_EQ(split[i].meta.round, i);
+    ASSERT_EQ(split[i].data.size(), msgs[i].data.size());
+    for (size_t j = 0; j < msgs[i].data.size(); j++) {
+      EXPECT_EQ(split[i].data[j].data(), msgs[i].data[j].data());  // shared, not copied
+    }
+  }
+  EXPECT_FLOAT_EQ(third_party::SArray<float>(split[2].data[1])[0], 0.5);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -1,38 +1,125 @@
 #include "comm/sender.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <map>
+
+#include "comm/message_batch.hpp"
+#include "glog/logging.h"
+
 namespace csci5570 {
-Sender::Sender(AbstractMailbox* mailbox) : mailbox_(mailbox) {}
+Sender::Sender(AbstractMailbox* mailbox, int num_threads, const BatchConfig& batch_config)
+    : batch_config_(batch_config), router_(this), mailbox_(mailbox) {
+  CHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; i++) {
+    lanes_.emplace_back(new ThreadsafeQueue<Message>());
+  }
+}
 
 void Sender::Start() {
-  sender_thread_ = std::thread([this] { Send(); });
+  for (int i = 0; i < lanes_.size(); i++) {
+    sender_threads_.push_back(std::thread([this, i] { SendLane(i); }));
+  }
 }
 
-void Sender::Send() {
-  int count = 0;
+void Sender::Send() { SendLane(0); }
+
+void Sender::SendLane(int lane) {
+  std::vector<Message> popped;
   while (true) {
-    count ++;
-    Message to_send;
-    send_message_queue_.WaitAndPop(&to_send);
-//    printf("=========================================\n");
-//    printf("sender get number %d message to send\n", count);
-//    printf("sender is %d\n",to_send.meta.sender);
-//    printf("receiver is %d\n",to_send.meta.recver);
-//    printf("model_id is %d\n",to_send.meta.model_id);
-//    printf("flag is %d\n",to_send.meta.flag);
-//    printf("=========================================\n");
-    if (to_send.meta.flag == Flag::kExit)
+    lanes_[lane]->WaitAndPopAll(&popped);
+    if (batch_config_.linger_us > 0) {
+      std::this_thread::sleep_for(std::chrono::microseconds(batch_config_.linger_us));
+      if (lanes_[lane]->Size() > 0)
+        lanes_[lane]->WaitAndPopAll(&popped);
+    }
+    // the messages before a kExit are still sent
+    auto exit = std::find_if(popped.begin(), popped.end(),
+                             [](const Message& msg) { return msg.meta.flag == Flag::kExit; });
+    bool stop = exit != popped.end();
+    popped.erase(exit, popped.end());
+    SendCoalesced(&popped);
+    popped.clear();
+    if (stop)
       break;
-    mailbox_->Send(to_send);
   }
 }
 
-ThreadsafeQueue<Message>* Sender::GetMessageQueue() { return &send_message_queue_; }
+void Sender::SendCoalesced(std::vector<Message>* msgs) {
+  if (batch_config_.max_bytes == 0 || msgs->size() == 1) {
+    for (auto& msg : *msgs) {
+      mailbox_->Send(msg);
+    }
+    return;
+  }
+  // the messages to each node in order, cut before a batch grows beyond max_bytes
+  std::map<uint32_t, std::vector<Message>> batches;
+  std::map<uint32_t, uint64_t> batch_bytes;
+  auto flush = [this, &batches, &batch_bytes](uint32_t node) {
+    auto& batch = batches[node];
+    if (batch.size() == 1)
+      mailbox_->Send(batch[0]);
+    else if (batch.size() > 1)
+      mailbox_->Send(MakeBatch(node, batch));
+    batch.clear();
+    batch_bytes[node] = 0;
+  };
+  for (auto& msg : *msgs) {
+    uint32_t node = mailbox_->GetNodeId(msg);
+    if (mailbox_->IsLocal(node)) {  // handed over to the queues of the node as they are, nothing to save by framing
+      mailbox_->Send(msg);
+      continue;
+    }
+    if (msg.meta.flag == Flag::kBarrier) {  // not framed, as the mailbox of the node counts them
+      flush(node);
+      mailbox_->Send(msg);
+      continue;
+    }
+    uint64_t bytes = sizeof(Meta);
+    for (const auto& data : msg.data) {
+      bytes += data.size();
+    }
+    if (!batches[node].empty() && batch_bytes[node] + bytes > batch_config_.max_bytes)
+      flush(node);
+    batches[node].push_back(std::move(msg));
+    batch_bytes[node] += bytes;
+  }
+  for (auto& batch : batches) {
+    flush(batch.first);
+  }
+}
+
+ThreadsafeQueue<Message>* Sender::GetMessageQueue() { return &router_; }
 
 void Sender::Stop() {
   Message stop_msg;
   stop_msg.meta.flag = Flag::kExit;
-  send_message_queue_.Push(stop_msg);
-  sender_thread_.join();
+  for (auto& lane : lanes_) {
+    lane->Push(stop_msg);
+  }
+  for (auto& thread : sender_threads_) {
+    thread.join();
+  }
+  sender_threads_.clear();
+}
+
+void Sender::Router::Push(Message msg) {
+  auto& lanes = sender_->lanes_;
+  lanes[sender_->mailbox_->GetNodeId(msg) % lanes.size()]->Push(std::move(msg));
+}
+
+void Sender::Router::WaitAndPop(Message* msg) { LOG(FATAL) << "the lanes are popped by the sender threads only"; }
+
+void Sender::Router::WaitAndPopAll(std::vector<Message>* msgs) {
+  LOG(FATAL) << "the lanes are popped by the sender threads only";
+}
+
+int Sender::Router::Size() {
+  int size = 0;
+  for (auto& lane : sender_->lanes_) {
+    size += lane->Size();
+  }
+  return size;
 }
 
 }  // namespace csci5570
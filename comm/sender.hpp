@@ -4,23 +4,74 @@
 #include "comm/abstract_sender.hpp"
 #include "comm/abstract_mailbox.hpp"
 
+#include <cstdint>
+#include <memory>
 #include <thread>
+#include <vector>
 
 namespace csci5570 {
 
+/*
+ * How a sender coalesces the messages to a node into kBatch messages. A lane coalesces the messages queued while it
+ * was sending, so a batch waits for nothing unless linger_us is set.
+ */
+struct BatchConfig {
+  uint64_t max_bytes = 1 << 20;  // the bytes of a batch, 0 to send every message on its own
+  int64_t linger_us = 0;         // the time a lane waits for more messages once it popped some
+};
+
+/**
+ * Sends the messages put in its queue through the mailbox, on a pool of sender threads.
+ *
+ * Each sender thread pops its own lane, and the messages to a node all go to the lane of the node, the node id
+ * modulo the threads. The sends to different nodes then run in parallel while those to a node keep their order,
+ * and each socket of the mailbox is used by one sender thread only. The messages popped together for a remote node
+ * are sent as batches, see MakeBatch.
+ */
 class Sender : public AbstractSender {
  public:
-  explicit Sender(AbstractMailbox* mailbox);
+  /**
+   * @param mailbox       the mailbox sending the messages
+   * @param num_threads   the sender threads, each with its lane
+   * @param batch_config  how the messages to a node are coalesced, see BatchConfig
+   */
+  explicit Sender(AbstractMailbox* mailbox, int num_threads = 1, const BatchConfig& batch_config = BatchConfig());
   virtual void Start() override;
+  // Send the messages of the first lane on the calling thread until a kExit
   virtual void Send() override;
   virtual void Stop() override;
+  /**
+   * Return the queue putting each message pushed to it in the lane of its destination. It cannot be popped.
+   */
   ThreadsafeQueue<Message>* GetMessageQueue();
 
+  int GetNumThreads() const { return lanes_.size(); }
+
  private:
-  ThreadsafeQueue<Message> send_message_queue_;
+  // the queue handed out to the senders of messages
+  class Router : public ThreadsafeQueue<Message> {
+   public:
+    explicit Router(Sender* sender) : sender_(sender) {}
+    virtual void Push(Message msg) override;
+    virtual void WaitAndPop(Message* msg) override;
+    virtual void WaitAndPopAll(std::vector<Message>* msgs) override;
+    virtual int Size() override;
+
+   private:
+    Sender* sender_;
+  };
+
+  // Send the messages of a lane until a kExit
+  void SendLane(int lane);
+  // Send the messages, coalescing those to the same node
+  void SendCoalesced(std::vector<Message>* msgs);
+
+  BatchConfig batch_config_;
+  Router router_;
+  std::vector<std::unique_ptr<ThreadsafeQueue<Message>>> lanes_;
   // Not owned
   AbstractMailbox* mailbox_;
-  std::thread sender_thread_;
+  std::vector<std::thread> sender_threads_;
 };
 
 }  // namespace csci5570
@@ -1,8 +1,10 @@
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 
+#include "comm/message_batch.hpp"
 #include "comm/sender.hpp"
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 
@@ -21,16 +23,35 @@ class TestSender : public testing::Test {
 
 class FakeMailbox : public AbstractMailbox {
  public:
+  explicit FakeMailbox(int local_node = -1) : local_node_(local_node) {}
+
   virtual int Send(const Message& msg) override {
+    if (msg.meta.flag == Flag::kBatch) {  // split as the mailbox of the node would
+      num_batches_ += 1;
+      std::vector<Message> msgs;
+      SplitBatch(msg, &msgs);
+      for (auto& part : msgs) {
+        to_send_.Push(part);
+      }
+      return -1;
+    }
     to_send_.Push(msg);
     return -1;
   }
 
+  // a node per receiver
+  virtual uint32_t GetNodeId(const Message& msg) override { return msg.meta.recver; }
+  virtual bool IsLocal(uint32_t node) override { return static_cast<int>(node) == local_node_; }
+
   void WaitAndPop(Message* msg) {
     to_send_.WaitAndPop(msg);
   }
+  int GetNumBatches() const { return num_batches_; }
+
  private:
+  int local_node_;
   ThreadsafeQueue<Message> to_send_;
+  std::atomic<int> num_batches_{0};
 };
 
 TEST_F(TestSender, StartStop) {
@@ -72,5 +93,92 @@ TEST_F(TestSender, Send) {
   sender.Stop();
 }
 
+TEST_F(TestSender, Lanes) {
+  FakeMailbox mailbox;
+  Sender sender(&mailbox, 3);
+  EXPECT_EQ(sender.GetNumThreads(), 3);
+  sender.Start();
+  auto* send_queue = sender.GetMessageQueue();
+
+  // the messages to a node are sent in order, whichever thread sends them
+  const int kNumNodes = 4;
+  const int kNumMessages = 100;
+  for (int i = 0; i < kNumMessages; i++) {
+    Message msg;
+    msg.meta.sender = i;
+    msg.meta.recver = i % kNumNodes;
+    msg.meta.flag = Flag::kGet;
+    send_queue->Push(msg);
+  }
+  std::vector<int> last(kNumNodes, -1);
+  for (int i = 0; i < kNumMessages; i++) {
+    Message res;
+    mailbox.WaitAndPop(&res);
+    EXPECT_GT(static_cast<int>(res.meta.sender), last[res.meta.recver]);
+    last[res.meta.recver] = res.meta.sender;
+  }
+  EXPECT_EQ(send_queue->Size(), 0);
+
+  sender.Stop();
+}
+
+TEST_F(TestSender, Coalesce) {
+  FakeMailbox mailbox;
+  BatchConfig config;
+  config.linger_us = 100000;  // all pushed before the lane sends
+  config.max_bytes = 4 * sizeof(Meta);
+  Sender sender(&mailbox, 1, config);
+  sender.Start();
+  auto* send_queue = sender.GetMessageQueue();
+
+  // 8 messages without data to 2 nodes, in batches of at most 4
+  for (int i = 0; i < 8; i++) {
+    Message msg;
+    msg.meta.sender = i;
+    msg.meta.recver = i % 2;
+    msg.meta.flag = Flag::kClock;
+    send_queue->Push(msg);
+  }
+  std::vector<int> last(2, -1);
+  for (int i = 0; i < 8; i++) {
+    Message res;
+    mailbox.WaitAndPop(&res);
+    EXPECT_EQ(res.meta.flag, Flag::kClock);
+    EXPECT_GT(static_cast<int>(res.meta.sender), last[res.meta.recver]);
+    last[res.meta.recver] = res.meta.sender;
+  }
+  EXPECT_EQ(mailbox.GetNumBatches(), 2);
+
+  sender.Stop();
+}
+
+TEST_F(TestSender, CoalesceRemoteOnly) {
+  FakeMailbox mailbox(0);
+  BatchConfig config;
+  config.linger_us = 100000;  // all pushed before the lane sends
+  Sender sender(&mailbox, 1, config);
+  sender.Start();
+  auto* send_queue = sender.GetMessageQueue();
+
+  // the messages to the local node 0 are sent on their own
+  for (int i = 0; i < 8; i++) {
+    Message msg;
+    msg.meta.sender = i;
+    msg.meta.recver = i % 2;
+    msg.meta.flag = Flag::kClock;
+    send_queue->Push(msg);
+  }
+  std::vector<int> last(2, -1);
+  for (int i = 0; i < 8; i++) {
+    Message res;
+    mailbox.WaitAndPop(&res);
+    EXPECT_GT(static_cast<int>(res.meta.sender), last[res.meta.recver]);
+    last[res.meta.recver] = res.meta.sender;
+  }
+  EXPECT_EQ(mailbox.GetNumBatches(), 1);
+
+  sender.Stop();
+}
+
 }  // namespace
 }  // namespace csci5570
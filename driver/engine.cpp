@@ -16,6 +16,8 @@
 
 namespace csci5570 {
 
+const uint64_t Engine::kDefaultNumKeys;
+
 /**
  * The flow of starting the engine:
  * 1. Create an id_mapper and a mailbox
@@ -25,14 +27,15 @@ namespace csci5570 {
  * 5. Start the communication threads: bind and connect to all other nodes
  *
  * @param num_server_threads_per_node the number of server threads to start on each node
+ * @param num_sender_threads          the threads sending the outgoing messages, each to its own nodes
  */
-void Engine::StartEverything(int num_server_threads_per_node) {
+void Engine::StartEverything(int num_server_threads_per_node, int num_sender_threads) {
   // 1. create an id_mapper
   CreateIdMapper(num_server_threads_per_node);
   // 2. create an mailbox
   CreateMailbox();
   // 3. start sender
-  StartSender();
+  StartSender(num_sender_threads);
   // 4. create/start server threads and register them into ThreadsafeQueue
   StartServerThreads();
   for (int i = 0; i < server_thread_group_.size(); ++i) {
@@ -59,11 +62,17 @@ void Engine::CreateMailbox() {
 }
 
 void Engine::StartServerThreads() {
+  checkpointer_.reset(new Checkpointer());
   std::vector<uint32_t> sids = id_mapper_->GetServerThreadsForId(node_.id);
   for (int i = 0; i < sids.size(); i++) {
     std::unique_ptr<ServerThread> ptr(new ServerThread(sids[i]));
     server_thread_group_.push_back(std::move(ptr));
   }
+  std::vector<ServerThread*> server_threads;
+  for (auto& server_thread : server_thread_group_) {
+    server_threads.push_back(server_thread.get());
+  }
+  local_servers_.reset(new LocalServers(server_threads));
   for (int i = 0; i < server_thread_group_.size(); i++) {
     server_thread_group_[i].get()->Start();
   }
@@ -81,8 +90,8 @@ void Engine::StartWorkerThreads() {  // ? s?
 
 void Engine::StartMailbox() { mailbox_->Start(); }
 
-void Engine::StartSender() {
-  sender_.reset(new Sender(mailbox_.get()));
+void Engine::StartSender(int num_sender_threads) {
+  sender_.reset(new Sender(mailbox_.get(), num_sender_threads));
   sender_->Start();
 }
 
@@ -112,6 +121,8 @@ void Engine::StopServerThreads() {
     server_thread_group_[i]->GetWorkQueue()->Push(msg);
     server_thread_group_[i].get()->Stop();
   }
+  // finish writing the checkpoints
+  checkpointer_.reset();
 }
 void Engine::StopWorkerThreads() {
   Message msg;
@@ -149,9 +160,11 @@ void Engine::InitTable(uint32_t table_id, const std::vector<uint32_t>& worker_id
     datas.push_back(wid);
   }
   msg.AddData(datas);
+  // reset synchronously: the local workers serve their Adds and Clocks directly and may reach
+  // the models as soon as Run starts them, before a queued reset would have been handled
   for (int i = 0; i < server_thread_group_.size(); i++) {
     msg.meta.recver = server_thread_group_[i].get()->GetId();
-    sender_.get()->GetMessageQueue()->Push(msg);
+    server_thread_group_[i]->ServeDirect(msg);
   }
 }
 
@@ -183,7 +196,10 @@ void Engine::Run(const MLTask& task) {
     info.worker_id = it->first;
     info.send_queue = sender_.get()->GetMessageQueue();
     info.partition_manager_map = tmp;
+    info.dim_map = dim_map_;
+    info.precision_map = precision_map_;
     info.callback_runner = callback_runner_.get();
+    info.local_servers = local_servers_.get();
     threads[j] = std::thread([task, info]() { task.RunLambda(info); });
   }
   for (auto& th : threads) {
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <fstream>
 #include <vector>
 
 #include "base/abstract_partition_manager.hpp"
@@ -9,6 +11,8 @@
 #include "driver/ml_task.hpp"
 #include "driver/simple_id_mapper.hpp"
 #include "driver/worker_spec.hpp"
+#include "glog/logging.h"
+#include "server/local_servers.hpp"
 #include "server/server_thread.hpp"
 #include "worker/abstract_callback_runner.hpp"
 #include "worker/worker_thread.hpp"
@@ -17,15 +21,39 @@
 #include "server/consistency/asp_model.hpp"
 #include "server/consistency/bsp_model.hpp"
 #include "server/consistency/ssp_model.hpp"
+#include "server/hash_storage.hpp"
 #include "server/map_storage.hpp"
+#include "server/tiered_storage.hpp"
+#include "server/updater.hpp"
+#include "server/util/checkpoint.hpp"
+#include "server/util/feature_filter.hpp"
+#include "server/util/replicator.hpp"
+#include "server/vector_storage.hpp"
 
 namespace csci5570 {
 
 enum class ModelType { SSP, BSP, ASP };
-enum class StorageType { Map };  // May have Vector
+enum class StorageType { Map, Vector, Hash, Tiered };
+
+/*
+ * The options of a table besides its model type, storage type and staleness, see Engine::CreateTable. By default
+ * the Adds assign one full precision value per key.
+ */
+struct TableConfig {
+  UpdaterConfig updater_config;           // how the storage applies incoming values - assign, sgd, adagrad, adam...
+  uint32_t dim = 1;                       // the number of values per key, e.g. the width of an embedding row
+  Precision precision = Precision::Full;  // how the servers keep the values and send them in Get replies
+  FeatureConfig feature_config;           // how the map and hash storages admit and evict keys
+  uint64_t max_hot_keys = 1 << 20;        // the keys a tiered storage keeps in memory per server thread
+  ReplicationConfig replication_config;   // how the server threads replicate their hot keys
+  StalenessConfig staleness_config;       // how the staleness of an ssp model adapts, and whether it pushes rows
+  QuorumConfig quorum_config;             // the workers ending a round of a bsp model, and the late updates
+};
 
 class Engine {
  public:
+  static const uint64_t kDefaultNumKeys = 110;  // the keys of tables created with the default partitioning
+
   /**
    * Engine constructor
    *
@@ -45,14 +73,15 @@ class Engine {
    * 5. Start the communication threads: bind and connect to all other nodes
    *
    * @param num_server_threads_per_node the number of server threads to start on each node
+   * @param num_sender_threads          the threads sending the outgoing messages, each to its own nodes
    */
-  void StartEverything(int num_server_threads_per_node = 1);
+  void StartEverything(int num_server_threads_per_node = 1, int num_sender_threads = 1);
   void CreateIdMapper(int num_server_threads_per_node = 1);
   void CreateMailbox();
   void StartServerThreads();
   void StartWorkerThreads();
   void StartMailbox();
-  void StartSender();
+  void StartSender(int num_sender_threads = 1);
 
   uint32_t RecoveryEngine() {
     int model_count = RecoveryModelCount();
@@ -100,117 +129,118 @@ class Engine {
    * @param model_type          the consistency of model - bsp, ssp, asp
    * @param storage_type        the storage type - map, vector...
    * @param model_staleness     the staleness for ssp model
+   * @param config              the other options of the table, see TableConfig
    * @return                    the created table(model) id
    */
   template <typename Val>
   uint32_t CreateTable(std::unique_ptr<AbstractPartitionManager> partition_manager, ModelType model_type,
-                       StorageType storage_type, int model_staleness = 0) {
+                       StorageType storage_type, int model_staleness = 0, const TableConfig& config = TableConfig()) {
     // each model corresponds to a table
     uint32_t table_id = model_count_++;
-    std::string model_type_string;
-    std::string storage_type_string;
-
+    dim_map_[table_id] = config.dim;
+    precision_map_[table_id] = config.precision;
     RegisterPartitionManager(table_id, std::move(partition_manager));
-    std::unique_ptr<AbstractStorage> storage;
-
-    switch (storage_type) {
-    case StorageType::Map:
-      storage.reset(new MapStorage<Val>());
-      storage_type_string = "Map";
-      break;
-    default:
-      storage.reset(new MapStorage<Val>());
-    }
 
     std::unique_ptr<AbstractModel> model;
     for (int i = 0; i < server_thread_group_.size(); i++) {
+      auto storage = CreateStorage<Val>(table_id, server_thread_group_[i]->GetId(), storage_type, config);
       switch (model_type) {
       case ModelType::ASP:
-        model.reset(new ASPModel(table_id, std::move(storage), sender_->GetMessageQueue()));
-        model->Backup();
-        model_type_string = "ASP";
+        model.reset(new ASPModel(table_id, std::move(storage), sender_->GetMessageQueue(), checkpointer_.get()));
         break;
       case ModelType::BSP:
-        model.reset(new BSPModel(table_id, std::move(storage), sender_->GetMessageQueue()));
-        model->Backup();
-        model_type_string = "BSP";
+        model.reset(new BSPModel(table_id, std::move(storage), sender_->GetMessageQueue(), checkpointer_.get(),
+                                 config.quorum_config));
         break;
       case ModelType::SSP:
-        model.reset(new SSPModel(table_id, std::move(storage), model_staleness, sender_->GetMessageQueue()));
-        model->Backup();
-        model_type_string = "SSP";
+        model.reset(new SSPModel(table_id, std::move(storage), model_staleness, sender_->GetMessageQueue(),
+                                 checkpointer_.get(), config.staleness_config));
         break;
       default:
         break;
       }
+      model->SetCheckpointPrefix(CheckpointPrefix(server_thread_group_[i]->GetId()));
+      EnableReplication(model.get(), table_id, server_thread_group_[i]->GetId(), config.replication_config);
+      model->Backup();
       server_thread_group_[i].get()->RegisterModel(table_id, std::move(model));
-      BackupTable(table_id, model_type_string, storage_type_string, model_staleness);
     }
+    BackupTable(table_id, model_type, storage_type, model_staleness, config);
     BackupModelConunt();
     return table_id;
   }
 
-  void BackupTable(uint32_t table_id, std::string model_type, std::string storage_type, int model_staleness = 0) {
-    std::ofstream outfile;
-    std::string path = "/data/table" + std::to_string(table_id) + ".txt";
-    outfile.open(path);
-    auto range = partition_manager_map_[table_id]->GetRanges();
-    outfile << model_type << "\n";
-    outfile << storage_type << "\n";
-    outfile << model_staleness << "\n";
-    for (int i = 0; i < range.size(); i++) {
-      outfile << range[i].begin() << " " << range[i].end() << "\n";
+  /**
+   * The table checkpoint: a TableMeta followed by the num_ranges [begin, end) pairs of the partitions
+   */
+  struct TableMeta {
+    int32_t model_type;
+    int32_t storage_type;
+    int32_t model_staleness;
+    TableConfig config;
+    uint64_t num_ranges;
+  };
+
+  void BackupTable(uint32_t table_id, ModelType model_type, StorageType storage_type, int model_staleness = 0,
+                   const TableConfig& config = TableConfig()) {
+    auto ranges = partition_manager_map_[table_id]->GetRanges();
+    TableMeta meta;
+    meta.model_type = static_cast<int32_t>(model_type);
+    meta.storage_type = static_cast<int32_t>(storage_type);
+    meta.model_staleness = model_staleness;
+    meta.config = config;
+    meta.num_ranges = ranges.size();
+    CheckpointWriter writer("/data/table" + std::to_string(table_id) + ".ckpt");
+    writer.Write(meta);
+    for (int i = 0; i < ranges.size(); i++) {
+      writer.Write(ranges[i].begin());
+      writer.Write(ranges[i].end());
     }
-    outfile.close();
+    writer.Close();
   }
 
   template <typename Val>
   int RecoveryTable(uint32_t table_id) {
-    std::ifstream ifs;
-    std::string path = "/data/table" + std::to_string(table_id) + ".txt";
-    ifs.open(path, std::ifstream::in);
-    std::string s;
-    ifs >> s;
-    std::string model_type_string = s;
-    ifs >> s;
-    std::string storage_type_string = s;
-    ifs >> s;
-    int model_staleness = std::stoi(s);
+    std::string path = "/data/table" + std::to_string(table_id) + ".ckpt";
+    CheckpointReader reader(path);
+    const TableMeta* meta = reader.Read<TableMeta>();
+    CHECK(meta != nullptr) << "cannot read table checkpoint " << path;
+    ModelType model_type = static_cast<ModelType>(meta->model_type);
+    StorageType storage_type = static_cast<StorageType>(meta->storage_type);
+    int model_staleness = meta->model_staleness;
+    const TableConfig config = meta->config;
+    dim_map_[table_id] = config.dim;
+    precision_map_[table_id] = config.precision;
     const std::vector<uint32_t> sids = GetServerThreadIds();
     // build ranges
-    int sid_size = sids.size();
     std::vector<third_party::Range> ranges;
-    int begin = 0;
-    int end = 0;
-    while (ifs >> s) {
-      begin = std::stoi(s);
-      ifs >> s;
-      end = std::stoi(s);
-      third_party::Range range(begin, end);
-      ranges.push_back(range);
+    const uint64_t* bounds = reader.Read<uint64_t>(2 * meta->num_ranges);
+    CHECK(bounds != nullptr) << "cannot read table checkpoint " << path;
+    for (uint64_t i = 0; i < meta->num_ranges; i++) {
+      ranges.push_back(third_party::Range(bounds[2 * i], bounds[2 * i + 1]));
     }
-    ifs.close();
     std::unique_ptr<AbstractPartitionManager> partition_manager(new RangePartitionManager(sids, ranges));
     RegisterPartitionManager(table_id, std::move(partition_manager));
 
     std::unique_ptr<AbstractModel> model;
-    std::unique_ptr<AbstractStorage> storage;
     int min_clock;
-    storage.reset(new MapStorage<Val>());
     for (int i = 0; i < server_thread_group_.size(); i++) {
-      if (model_type_string == "ASP") {
-        model.reset(new ASPModel(table_id, std::move(storage), sender_->GetMessageQueue()));
-        min_clock = model->Recovery();
-      } else if (model_type_string == "BSP") {
-        model.reset(new BSPModel(table_id, std::move(storage), sender_->GetMessageQueue()));
-        min_clock = model->Recovery();
+      auto storage = CreateStorage<Val>(table_id, server_thread_group_[i]->GetId(), storage_type, config);
+      if (model_type == ModelType::ASP) {
+        model.reset(new ASPModel(table_id, std::move(storage), sender_->GetMessageQueue(), checkpointer_.get()));
+      } else if (model_type == ModelType::BSP) {
+        model.reset(new BSPModel(table_id, std::move(storage), sender_->GetMessageQueue(), checkpointer_.get(),
+                                 config.quorum_config));
       } else {
-        model.reset(new SSPModel(table_id, std::move(storage), model_staleness, sender_->GetMessageQueue()));
-        min_clock = model->Recovery();
-        printf("model recovery finish\n");
+        model.reset(new SSPModel(table_id, std::move(storage), model_staleness, sender_->GetMessageQueue(),
+                                 checkpointer_.get(), config.staleness_config));
       }
+      model->SetCheckpointPrefix(CheckpointPrefix(server_thread_group_[i]->GetId()));
+      EnableReplication(model.get(), table_id, server_thread_group_[i]->GetId(), config.replication_config);
+      min_clock = model->Recovery();
+      LOG(INFO) << "recovered model " << table_id << " on server " << server_thread_group_[i]->GetId()
+                << " at min clock " << min_clock;
       server_thread_group_[i].get()->RegisterModel(table_id, std::move(model));
-      printf("Register model finish\n");
+      VLOG(1) << "registered model " << table_id << " on server " << server_thread_group_[i]->GetId();
     }
     return min_clock;
   }
@@ -240,21 +270,26 @@ class Engine {
    * @param model_type          the consistency of model - bsp, ssp, asp
    * @param storage_type        the storage type - map, vector...
    * @param model_staleness     the staleness for ssp model
+   * @param config              the other options of the table, see TableConfig
    * @return                    the created table(model) id
    */
   template <typename Val>
-  uint32_t CreateTable(ModelType model_type, StorageType storage_type, int model_staleness = 0) {
+  uint32_t CreateTable(ModelType model_type, StorageType storage_type, int model_staleness = 0,
+                       const TableConfig& config = TableConfig()) {
     // get server thread ids
     const std::vector<uint32_t> sids = GetServerThreadIds();
 
-    // build ranges
-    int count = sids.size();
-    std::vector<third_party::Range> ranges(count);
-    //  TODO... implement ranges
-    ranges = {{0, 20}, {20, 40}, {40, 60}, {60, 80}, {80, 110}};
+    // split the keys evenly over the server threads, which GetServerThreadIds lists node by node, so each node
+    // owns a contiguous range and its shards disjoint parts of it
+    std::vector<third_party::Range> ranges;
+    for (uint64_t i = 0; i < sids.size(); i++) {
+      ranges.push_back(
+          third_party::Range(kDefaultNumKeys * i / sids.size(), kDefaultNumKeys * (i + 1) / sids.size()));
+    }
     // build partition manager
     std::unique_ptr<AbstractPartitionManager> partition_manager(new RangePartitionManager(sids, ranges));
-    uint32_t table_id = CreateTable<Val>(std::move(partition_manager), model_type, storage_type, model_staleness);
+    uint32_t table_id =
+        CreateTable<Val>(std::move(partition_manager), model_type, storage_type, model_staleness, config);
     return table_id;
   }
 
@@ -278,6 +313,81 @@ class Engine {
   std::vector<uint32_t> GetServerThreadIds() { return id_mapper_->GetAllServerThreads(); }
 
  protected:
+  /**
+   * Create the storage of a model partition held by a local server thread
+   * The vector storage is sized to the key range the partition manager assigns to the server thread
+   *
+   * @param table_id            the model id
+   * @param server_id           the server thread holding the partition
+   * @param storage_type        the storage type - map, vector...
+   * @param config              the updater, dim and precision of the storage, how it admits and evicts keys (only
+   *                            supported by the map and hash storages) and the keys a tiered storage keeps in memory
+   */
+  template <typename Val>
+  std::unique_ptr<AbstractStorage> CreateStorage(uint32_t table_id, uint32_t server_id, StorageType storage_type,
+                                                 const TableConfig& config) {
+    const UpdaterConfig& updater_config = config.updater_config;
+    const FeatureConfig& feature_config = config.feature_config;
+    uint32_t dim = config.dim;
+    Precision precision = config.precision;
+    std::unique_ptr<AbstractStorage> storage;
+    switch (storage_type) {
+    case StorageType::Vector: {
+      auto& partition_manager = partition_manager_map_[table_id];
+      const auto& sids = partition_manager->GetServerThreadIds();
+      auto ranges = partition_manager->GetRanges();
+      auto pos = std::find(sids.begin(), sids.end(), server_id);
+      CHECK(pos != sids.end()) << "server " << server_id << " holds no range of table " << table_id;
+      // the vector storage preallocates its whole key range, so there is nothing to admit or evict
+      CHECK(!AdmitsOrEvicts(feature_config)) << "the vector storage of table " << table_id
+                                             << " cannot admit or evict keys";
+      storage.reset(
+          new VectorStorage<Val>(ranges[pos - sids.begin()], CreateUpdater<Val>(updater_config), dim, precision));
+      break;
+    }
+    case StorageType::Tiered:
+      CHECK(!AdmitsOrEvicts(feature_config)) << "the tiered storage of table " << table_id
+                                             << " cannot admit or evict keys";
+      storage.reset(new TieredStorage<Val>(
+          CreateUpdater<Val>(updater_config), dim, precision, config.max_hot_keys,
+          "/data/model" + std::to_string(table_id) + "_" + std::to_string(server_id) + ".blocks"));
+      break;
+    case StorageType::Hash:
+      storage.reset(new HashStorage<Val>(CreateUpdater<Val>(updater_config), dim, precision, feature_config));
+      break;
+    case StorageType::Map:
+    default:
+      storage.reset(new MapStorage<Val>(CreateUpdater<Val>(updater_config), dim, precision, feature_config));
+    }
+    return storage;
+  }
+
+  /**
+   * Let the shard of a model held by a server thread replicate its hot keys to the server threads after it, in the
+   * order of the partition manager, and serve the replicas of the shards before it
+   */
+  void EnableReplication(AbstractModel* model, uint32_t table_id, uint32_t server_id,
+                         const ReplicationConfig& replication_config) {
+    if (replication_config.num_replicas == 0)
+      return;
+    const auto& sids = partition_manager_map_[table_id]->GetServerThreadIds();
+    auto pos = std::find(sids.begin(), sids.end(), server_id);
+    CHECK(pos != sids.end()) << "server " << server_id << " holds no range of table " << table_id;
+    std::vector<uint32_t> replica_sids;
+    for (size_t i = 1; i <= replication_config.num_replicas && i < sids.size(); i++) {
+      replica_sids.push_back(sids[(pos - sids.begin() + i) % sids.size()]);
+    }
+    model->SetReplicator(std::unique_ptr<Replicator>(
+        new Replicator(replication_config, table_id, server_id, replica_sids, sender_->GetMessageQueue())));
+  }
+
+  // the checkpoints of the shard of a model held by a server thread
+  static std::string CheckpointPrefix(uint32_t server_id) { return "/data/server" + std::to_string(server_id) + "_"; }
+
+  static bool AdmitsOrEvicts(const FeatureConfig& config) {
+    return config.min_count > 1 || config.admit_probability < 1.0 || config.ttl != 0 || config.max_keys != 0;
+  }
+
   /**
    * Register partition manager for a model to the engine
    *
@@ -287,6 +397,8 @@ class Engine {
   void RegisterPartitionManager(uint32_t table_id, std::unique_ptr<AbstractPartitionManager> partition_manager);
 
   std::map<uint32_t, std::unique_ptr<AbstractPartitionManager>> partition_manager_map_;
+  std::map<uint32_t, uint32_t> dim_map_;         // {table_id: number of values per key}
+  std::map<uint32_t, Precision> precision_map_;  // {table_id: precision of the values on the servers}
   // nodes
   Node node_;
   std::vector<Node> nodes_;
@@ -299,6 +411,8 @@ class Engine {
   std::unique_ptr<AbstractWorkerThread> worker_thread_;
   // server elements
   std::vector<std::unique_ptr<ServerThread>> server_thread_group_;
+  std::unique_ptr<LocalServers> local_servers_;  // server_thread_group_, called directly by the local workers
+  std::unique_ptr<Checkpointer> checkpointer_;  // writes the checkpoints of the local models
   size_t model_count_ = 0;
 
   std::string hdfs_addr_;
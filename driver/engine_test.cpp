@@ -148,5 +148,58 @@ TEST_F(TestEngine, KVClientTableMapStorage) {
   engine.StopEverything();
 }
 
+TEST_F(TestEngine, DirectClockAfterInitTable) {
+  Node node{0, "localhost", 12354};
+  Engine engine(node, {node});
+  // start
+  engine.StartEverything();
+  const auto kTableId = engine.CreateTable<double>(ModelType::SSP, StorageType::Map);  // table 0
+  engine.Barrier();
+  MLTask task;
+  task.SetWorkerAlloc({{0, 1}});  // 1 worker on node 0
+  task.SetTables({kTableId});     // Use table 0
+  task.SetLambda([kTableId](const Info& info) {
+    // the first Add and Clock are served directly, straight after InitTable, and must not be dropped
+    ASSERT_TRUE(info.local_servers != nullptr);
+    auto table = info.CreateKVClientTable<double>(kTableId);
+    std::vector<Key> keys{1};
+    std::vector<double> vals{0.5};
+    table.Add(keys, vals);
+    table.Clock();
+    std::vector<double> ret;
+    table.Get(keys, &ret);
+    ASSERT_EQ(ret.size(), 1);
+    EXPECT_DOUBLE_EQ(ret[0], 0.5);
+  });
+  engine.Run(task);
+
+  // stop
+  engine.StopEverything();
+}
+
+TEST_F(TestEngine, CreateTableWithConfig) {
+  Node node{0, "localhost", 12355};
+  Engine engine(node, {node});
+  // start
+  engine.StartEverything();
+  TableConfig config;
+  config.updater_config.type = UpdaterType::SGD;
+  config.dim = 4;
+  config.precision = Precision::BF16;
+  const auto kTableId = engine.CreateTable<float>(ModelType::SSP, StorageType::Map, 1, config);  // table 0
+  engine.Barrier();
+  MLTask task;
+  task.SetWorkerAlloc({{0, 1}});  // 1 worker on node 0
+  task.SetTables({kTableId});     // Use table 0
+  task.SetLambda([kTableId](const Info& info) {
+    EXPECT_EQ(info.dim_map.at(kTableId), 4);
+    EXPECT_EQ(info.precision_map.at(kTableId), Precision::BF16);
+  });
+  engine.Run(task);
+
+  // stop
+  engine.StopEverything();
+}
+
 }  // namespace
 }  // namespace csci5570
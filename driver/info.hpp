@@ -2,6 +2,7 @@
 
 #include <sstream>
 
+#include "base/abstract_local_servers.hpp"
 #include "base/abstract_partition_manager.hpp"
 #include "base/threadsafe_queue.hpp"
 #include "worker/abstract_callback_runner.hpp"
@@ -19,7 +20,10 @@ struct Info {
   uint32_t worker_id;
   ThreadsafeQueue<Message>* send_queue;
   std::map<uint32_t, AbstractPartitionManager*> partition_manager_map;
+  std::map<uint32_t, uint32_t> dim_map;          // {table_id: number of values per key}, 1 if absent
+  std::map<uint32_t, Precision> precision_map;  // {table_id: precision of Get replies}, Full if absent
   AbstractCallbackRunner* callback_runner;
+  AbstractLocalServers* local_servers = nullptr;  // the server threads of this node, called directly if set
   std::string DebugString() const {
     std::stringstream ss;
     ss << "thread_id: " << thread_id << " worker_id: " << worker_id;
@@ -42,7 +46,12 @@ struct Info {
     } else {
       manager = pos->second;
     }
-    KVClientTable<Val> table(thread_id, table_id, send_queue, manager, callback_runner);
+    auto dim = dim_map.find(table_id);
+    auto precision = precision_map.find(table_id);
+    KVClientTable<Val> table(thread_id, table_id, send_queue, manager, callback_runner,
+                             dim == dim_map.end() ? 1 : dim->second,
+                             precision == precision_map.end() ? Precision::Full : precision->second,
+                             local_servers);
     return table;
   }
 };
@@ -15,21 +15,21 @@ SimpleIdMapper::SimpleIdMapper(Node node, const std::vector<Node>& nodes) {
 uint32_t SimpleIdMapper::GetNodeIdForThread(uint32_t tid) { return tid / kMaxThreadsPerNode; }
 
 void SimpleIdMapper::Init(int num_server_threads_per_node) {
-  if (num_server_threads_per_node >= 1 && num_server_threads_per_node <= kWorkerHelperThreadId - 1) {
+  if (num_server_threads_per_node >= 1 && num_server_threads_per_node <= kHeartBeatThreadId) {
     for (auto node : nodes_) {
+      // one shard per server thread
+      std::vector<uint32_t> serverThreads;
       for (int i = 0; i < num_server_threads_per_node; i++) {
-        // node2server_.insert(std::make_pair(node.id,node.id*kMaxThreadsPerNode+i));
-        std::vector<uint32_t> serverThreads;
         serverThreads.push_back(node.id * kMaxThreadsPerNode + i);
-        node2server_[node.id] = serverThreads;
       }
+      node2server_[node.id] = serverThreads;
       std::vector<uint32_t> workerHelperThread;
       workerHelperThread.push_back(kWorkerHelperThreadId + node.id * kMaxThreadsPerNode);
       node2worker_helper_.insert(std::make_pair(node.id, workerHelperThread));
 
       std::set<uint32_t> workerThreads;
       // workerThreads.insert(node_.id*kMaxThreadsPerNode+kWorkerHelperThreadId+1);
-      node2worker_.insert(std::make_pair(node_.id, workerThreads));
+      node2worker_.insert(std::make_pair(node.id, workerThreads));
     };
   }
 }
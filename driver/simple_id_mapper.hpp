@@ -30,9 +30,9 @@ class SimpleIdMapper : public AbstractIdMapper {
 
   /**
    * Initiate the id mapper with the global information of worker and server threads
-   * 1. Do some checking on the <num_server_threads_per_node>, which should be in [1, kWorkerThreadId]
+   * 1. Do some checking on the <num_server_threads_per_node>, which should be in [1, kHeartBeatThreadId]
    * 2. For each node of all available nodes
-   *    a. update node2server_
+   *    a. update node2server_ with the <num_server_threads_per_node> server threads, the shards of the node
    *    b. update node2worker_ (for simplication, only one worker thread on each process for now)
    */
   void Init(int num_server_threads_per_node);
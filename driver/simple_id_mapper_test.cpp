@@ -42,6 +42,19 @@ TEST_F(TestSimpleIdMapper, Init) {
   EXPECT_EQ(id_mapper.GetNodeIdForThread(0), 0);
 }
 
+TEST_F(TestSimpleIdMapper, MultipleServerThreads) {
+  Node n1{0, "worker1", 12352};
+  Node n2{1, "worker1", 12353};
+  SimpleIdMapper id_mapper(n1, {n1, n2});
+  id_mapper.Init(4);
+  std::vector<uint32_t> expected{0, 1, 2, 3};
+  EXPECT_EQ(id_mapper.GetServerThreadsForId(0), expected);
+  expected = {1000, 1001, 1002, 1003};
+  EXPECT_EQ(id_mapper.GetServerThreadsForId(1), expected);
+  EXPECT_EQ(id_mapper.GetAllServerThreads().size(), 8);
+  EXPECT_EQ(id_mapper.GetNodeIdForThread(1003), 1);
+}
+
 TEST_F(TestSimpleIdMapper, AllocateDeallocateThread) {
   Node n1{0, "worker1", 12352};
   Node n2{1, "worker1", 12353};
@@ -0,0 +1,44 @@
+#include "server/abstract_model.hpp"
+
+#include "server/abstract_storage.hpp"
+#include "server/util/checkpointer.hpp"
+#include "server/util/progress_tracker.hpp"
+#include "server/util/replicator.hpp"
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+AbstractModel::AbstractModel() {}
+
+void AbstractModel::SetReplicator(std::unique_ptr<Replicator>&& replicator) { replicator_ = std::move(replicator); }
+
+AbstractModel::~AbstractModel() {}
+
+void AbstractModel::Checkpoint(uint32_t model_id, AbstractStorage* storage, ProgressTracker* progress_tracker,
+                               Checkpointer* checkpointer, std::future<void>* checkpoint) {
+  if (checkpointer == nullptr) {
+    storage->Backup(model_id);
+    progress_tracker->Backup(model_id);
+    return;
+  }
+  if (Checkpointer::IsPending(*checkpoint)) {
+    LOG(INFO) << "skip the checkpoint of model " << model_id << " as the last one is still being written";
+    return;
+  }
+  // only the snapshots are taken on the server thread
+  auto write_storage = storage->Snapshot(model_id);
+  auto write_tracker = progress_tracker->Snapshot(model_id);
+  *checkpoint = checkpointer->Submit([write_storage, write_tracker]() {
+    write_storage();
+    write_tracker();
+  });
+}
+
+void AbstractModel::SetCheckpointPrefix(const std::string& prefix, AbstractStorage* storage,
+                                        ProgressTracker* progress_tracker) {
+  storage->SetCheckpointPrefix(prefix);
+  progress_tracker->SetCheckpointPrefix(prefix);
+}
+
+}  // namespace csci5570
@@ -1,21 +1,77 @@
 #pragma once
 
 #include <cinttypes>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
 #include "base/message.hpp"
 #include "base/threadsafe_queue.hpp"
 
 namespace csci5570 {
 
+class AbstractStorage;
+class Checkpointer;
+class ProgressTracker;
+class Replicator;
+
 class AbstractModel {
  public:
+  // defined where Replicator is complete, as are the destructor and SetReplicator
+  AbstractModel();
   virtual void Clock(Message& msg) = 0;
   virtual void Add(Message& msg) = 0;
   virtual void Get(Message& msg) = 0;
+  /**
+   * Serve a run of Adds (Pushes) or Gets dequeued back to back, e.g. with one pass over the storage.
+   * By default they are served one by one.
+   */
+  virtual void AddBatch(std::vector<Message>& msgs) {
+    for (auto& msg : msgs) {
+      Add(msg);
+    }
+  }
+  virtual void GetBatch(std::vector<Message>& msgs) {
+    for (auto& msg : msgs) {
+      Get(msg);
+    }
+  }
+  /**
+   * Serve a Get into reply if the consistency allows it now, without buffering it or pushing the reply.
+   * Used by the workers on the node of the server thread. By default nothing is served this way.
+   */
+  virtual bool TryGet(Message& msg, Message* reply) { return false; }
   virtual int GetProgress(int tid) = 0;
   virtual void ResetWorker(Message& msg) = 0;
   virtual void Backup() = 0;
   virtual int Recovery() = 0;
-  virtual ~AbstractModel() {}
+  /**
+   * Write the checkpoints of the storage and the progresses under a prefix, e.g. one per shard of the model
+   */
+  virtual void SetCheckpointPrefix(const std::string& prefix) = 0;
+  /**
+   * Replicate the hot keys of the shard, and serve the replicas of the hot keys of other shards
+   */
+  virtual void SetReplicator(std::unique_ptr<Replicator>&& replicator);
+  // Serve a kReplicate from another shard or a kGetReplica from a worker
+  virtual void Replicate(Message& msg) = 0;
+  virtual ~AbstractModel();
+
+ protected:
+  /**
+   * Checkpoint the storage and the progresses of a model. With a checkpointer only the snapshots are taken on the
+   * server thread and the checkpointer writes them, unless the last checkpoint is still being written.
+   *
+   * @param checkpointer    writes the checkpoint if set, otherwise it is written right away
+   * @param checkpoint      the last checkpoint submitted to checkpointer, replaced by this one
+   */
+  static void Checkpoint(uint32_t model_id, AbstractStorage* storage, ProgressTracker* progress_tracker,
+                         Checkpointer* checkpointer, std::future<void>* checkpoint);
+  // Write the checkpoints of the storage and the progresses of a model under a prefix
+  static void SetCheckpointPrefix(const std::string& prefix, AbstractStorage* storage,
+                                  ProgressTracker* progress_tracker);
+
+  std::unique_ptr<Replicator> replicator_;  // replicates the hot keys if set
 };
 
 }  // namespace csci5570
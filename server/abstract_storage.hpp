@@ -1,6 +1,14 @@
 #pragma once
 
 #include "base/message.hpp"
+#include "server/util/update_aggregator.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
 
 #include "glog/logging.h"
 #include "gtest/gtest.h"
@@ -12,27 +20,27 @@ namespace csci5570 {
  */
 class AbstractStorage {
  public:
-  Message Add(Message& msg) {
-    CHECK(msg.data.size() == 2);
-    LOG(INFO) << "generate add message";
-    auto typed_keys = third_party::SArray<Key>(msg.data[0]);
+  // Return a reply to a request without data, e.g. the acknowledgement of an Add
+  static Message Reply(const Message& msg) {
     Message reply;
     reply.meta.recver = msg.meta.sender;
     reply.meta.sender = msg.meta.recver;
     reply.meta.flag = msg.meta.flag;
     reply.meta.model_id = msg.meta.model_id;
+    return reply;
+  }
+
+  Message Add(Message& msg) {
+    CHECK(msg.data.size() == 2);
+    auto typed_keys = third_party::SArray<Key>(msg.data[0]);
+    Message reply = Reply(msg);
     SubAdd(typed_keys, msg.data[1]);
     return reply;
   }
   Message Get(Message& msg) {
     CHECK(msg.data.size() == 1);
-    LOG(INFO) << "generate get message";
     auto typed_keys = third_party::SArray<Key>(msg.data[0]);
-    Message reply;
-    reply.meta.recver = msg.meta.sender;
-    reply.meta.sender = msg.meta.recver;
-    reply.meta.flag = msg.meta.flag;
-    reply.meta.model_id = msg.meta.model_id;
+    Message reply = Reply(msg);
     third_party::SArray<Key> reply_keys(typed_keys);
     third_party::SArray<char> reply_vals = SubGet(reply_keys);
     reply.AddData<Key>(reply_keys);
@@ -40,17 +48,145 @@ class AbstractStorage {
     return reply;
   }
 
+  /**
+   * Apply a run of Adds in one pass over the storage, sorted by key. The updates of a key are applied in the
+   * order of msgs, so the storage ends up as if the Adds were applied one by one.
+   *
+   * @return    the reply of each Add
+   */
+  std::vector<Message> AddBatch(std::vector<Message>& msgs) {
+    if (msgs.empty())
+      return {};
+    if (msgs.size() == 1)
+      return {Add(msgs[0])};
+    std::vector<Message> replies;
+    std::vector<BatchEntry> entries;
+    size_t val_bytes = 0;  // the bytes of the values of a key
+    for (uint32_t m = 0; m < msgs.size(); m++) {
+      CHECK(msgs[m].data.size() == 2);
+      auto typed_keys = third_party::SArray<Key>(msgs[m].data[0]);
+      if (!typed_keys.empty()) {
+        if (val_bytes == 0)
+          val_bytes = msgs[m].data[1].size() / typed_keys.size();
+        CHECK_EQ(msgs[m].data[1].size(), typed_keys.size() * val_bytes);
+      }
+      for (uint32_t i = 0; i < typed_keys.size(); i++) {
+        entries.push_back({typed_keys[i], m, i});
+      }
+      replies.push_back(Reply(msgs[m]));
+    }
+    std::sort(entries.begin(), entries.end());
+    third_party::SArray<Key> merged_keys(entries.size());
+    third_party::SArray<char> merged_vals(entries.size() * val_bytes);
+    for (size_t j = 0; j < entries.size(); j++) {
+      merged_keys[j] = entries[j].key;
+      std::memcpy(&merged_vals[j * val_bytes], &msgs[entries[j].msg].data[1][entries[j].pos * val_bytes], val_bytes);
+    }
+    SubAdd(merged_keys, merged_vals);
+    return replies;
+  }
+
+  /**
+   * Serve a run of Gets with one read of their distinct keys, sorted
+   *
+   * @return    the reply of each Get
+   */
+  std::vector<Message> GetBatch(std::vector<Message>& msgs) {
+    if (msgs.empty())
+      return {};
+    if (msgs.size() == 1)
+      return {Get(msgs[0])};
+    std::vector<third_party::SArray<Key>> msg_keys;
+    std::vector<BatchEntry> entries;
+    for (uint32_t m = 0; m < msgs.size(); m++) {
+      CHECK(msgs[m].data.size() == 1);
+      msg_keys.push_back(third_party::SArray<Key>(msgs[m].data[0]));
+      for (uint32_t i = 0; i < msg_keys[m].size(); i++) {
+        entries.push_back({msg_keys[m][i], m, i});
+      }
+    }
+    std::sort(entries.begin(), entries.end());
+    std::vector<Key> distinct_keys;
+    for (const auto& entry : entries) {
+      if (distinct_keys.empty() || distinct_keys.back() != entry.key)
+        distinct_keys.push_back(entry.key);
+    }
+    third_party::SArray<char> distinct_vals;
+    size_t row_bytes = 0;  // the bytes of the reply of a key
+    if (!distinct_keys.empty()) {
+      distinct_vals = SubGet(third_party::SArray<Key>(distinct_keys));
+      row_bytes = distinct_vals.size() / distinct_keys.size();
+    }
+    std::vector<third_party::SArray<char>> msg_vals;
+    for (uint32_t m = 0; m < msgs.size(); m++) {
+      msg_vals.push_back(third_party::SArray<char>(msg_keys[m].size() * row_bytes));
+    }
+    size_t row = 0;
+    for (size_t j = 0; j < entries.size(); j++) {
+      if (j > 0 && entries[j].key != entries[j - 1].key)
+        row++;
+      std::memcpy(&msg_vals[entries[j].msg][entries[j].pos * row_bytes], &distinct_vals[row * row_bytes], row_bytes);
+    }
+    std::vector<Message> replies;
+    for (uint32_t m = 0; m < msgs.size(); m++) {
+      replies.push_back(Reply(msgs[m]));
+      replies[m].AddData<Key>(msg_keys[m]);
+      replies[m].AddData<char>(msg_vals[m]);
+    }
+    return replies;
+  }
+
   // Add the typed_keys and typed_vals to kvstore
   virtual void SubAdd(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) = 0;
 
   // Retrieve the vals according to the typed_keys
   virtual third_party::SArray<char> SubGet(const third_party::SArray<Key>& typed_keys) = 0;
 
-  virtual void Backup(int model_id) = 0;
+  /**
+   * Copy the storage and return a task writing the copy to the checkpoint of the model.
+   * Copying is cheap compared with writing, so the task can run on a checkpoint thread while the storage keeps
+   * serving requests.
+   */
+  virtual std::function<void()> Snapshot(int model_id) = 0;
+
+  // Write the checkpoint of the model on the calling thread
+  virtual void Backup(int model_id) { Snapshot(model_id)(); }
 
   virtual void Recovery(int model_id) = 0;
 
+  // Called by the model each time its min clock advances
   virtual void FinishIter() = 0;
+
+  /**
+   * Return an aggregator summing the values of Adds for one SubAdd, or nullptr if the updates of the storage
+   * must be applied one by one
+   */
+  virtual std::unique_ptr<AbstractAggregator> CreateAggregator() { return nullptr; }
+
+  /**
+   * Write the checkpoints to <prefix>model<model_id>.ckpt, so the shards of a model on a node write apart
+   */
+  void SetCheckpointPrefix(const std::string& prefix) { checkpoint_prefix_ = prefix; }
+
+ protected:
+  std::string CheckpointPath(int model_id) const {
+    return checkpoint_prefix_ + "model" + std::to_string(model_id) + ".ckpt";
+  }
+
+ private:
+  // a key of a message in a batch
+  struct BatchEntry {
+    Key key;
+    uint32_t msg;  // the message in the batch
+    uint32_t pos;  // the key in the message
+    bool operator<(const BatchEntry& other) const {
+      if (key != other.key)
+        return key < other.key;
+      return msg != other.msg ? msg < other.msg : pos < other.pos;
+    }
+  };
+
+  std::string checkpoint_prefix_ = "/data/";
 };
 
 }  // namespace csci5570
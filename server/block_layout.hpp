@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "base/row_codec.hpp"
+#include "server/updater.hpp"
+#include "server/util/feature_filter.hpp"
+
+namespace csci5570 {
+
+/*
+ * The block a storage keeps per key:
+ *   [the row of dim weights encoded by a RowCodec][dim * state_size optimizer states of type Val][KeyStats]
+ * where the KeyStats are only kept by storages evicting keys. All parts start at 8-byte boundaries, so blocks
+ * packed in one byte array stay aligned.
+ *
+ * An update decodes the row, applies the updater in Val and encodes the row back. The optimizer states stay in
+ * Val, but the row itself is only as precise as its encoding between updates, so a reduced precision row is
+ * encoded back with stochastic rounding: an update smaller than half a step of the encoding, as lr * grad often
+ * is, then moves the row by a whole step with the matching probability rather than being rounded away, and the
+ * row follows the Val sum in expectation.
+ */
+template <typename Val>
+class BlockLayout {
+ public:
+  BlockLayout(std::unique_ptr<AbstractUpdater<Val>>&& updater, size_t dim, Precision precision,
+              bool with_stats = false)
+      : updater_(std::move(updater)),
+        codec_(precision, dim),
+        state_size_(updater_->GetStateSize()),
+        row_bytes_(Align(codec_.RowBytes())),
+        stats_offset_(row_bytes_ + Align(dim * state_size_ * sizeof(Val))),
+        block_bytes_(stats_offset_ + (with_stats ? Align(sizeof(KeyStats)) : 0)),
+        row_(dim) {}
+
+  size_t GetDim() const { return codec_.GetDim(); }
+  // the size of a block
+  size_t BlockBytes() const { return block_bytes_; }
+  // the size of an encoded row, as sent in Get replies
+  size_t RowBytes() const { return codec_.RowBytes(); }
+  // see AbstractUpdater::IsLinear
+  bool IsLinear() const { return updater_->IsLinear(); }
+
+  /**
+   * Apply dim incoming values to the block
+   */
+  void Update(char* block, const Val* vals) {
+    Val* states = reinterpret_cast<Val*>(block + row_bytes_);
+    codec_.Decode(block, row_.data());
+    for (size_t j = 0; j < row_.size(); j++) {
+      updater_->Update(&row_[j], states + j * state_size_, vals[j]);
+    }
+    codec_.Encode(row_.data(), block, &rng_);
+  }
+
+  /**
+   * Copy the encoded row of the block to a reply
+   */
+  void CopyRow(const char* block, char* reply) const { std::memcpy(reply, block, codec_.RowBytes()); }
+
+  // the KeyStats of a block, only for layouts with stats
+  KeyStats* Stats(char* block) const { return reinterpret_cast<KeyStats*>(block + stats_offset_); }
+
+ private:
+  static size_t Align(size_t bytes) { return (bytes + 7) / 8 * 8; }
+
+  std::unique_ptr<AbstractUpdater<Val>> updater_;
+  RowCodec<Val> codec_;
+  size_t state_size_;   // number of optimizer states per weight
+  size_t row_bytes_;    // the bytes before the states
+  size_t stats_offset_;  // the bytes before the KeyStats
+  size_t block_bytes_;
+  std::vector<Val> row_;  // the decoded row being updated
+  std::mt19937 rng_;      // for the stochastic rounding of the updated rows
+};
+
+}  // namespace csci5570
@@ -4,11 +4,12 @@
 namespace csci5570 {
 
 ASPModel::ASPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr,
-                   ThreadsafeQueue<Message>* reply_queue) {
+                   ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer) {
   // TODO
   this->model_id_ = model_id;
   this->reply_queue_ = reply_queue;
   this->storage_ = std::move(storage_ptr);
+  this->checkpointer_ = checkpointer;
 }
 
 void ASPModel::Clock(Message& msg) {
@@ -16,7 +17,12 @@ void ASPModel::Clock(Message& msg) {
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
   int tid = msg.meta.sender;
-  progress_tracker_.AdvanceAndGetChangedMinClock(tid);
+  int min_clock = progress_tracker_.AdvanceAndGetChangedMinClock(tid);
+  if (min_clock != -1) {
+    storage_->FinishIter();
+    if (replicator_)
+      replicator_->Refresh(storage_.get(), min_clock);
+  }
   if (progress_tracker_.GetMinClock() % 10 == 0){
     this->Backup();
   }
@@ -26,17 +32,55 @@ void ASPModel::Add(Message& msg) {
   // TODO
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender)) return;
   Message message = storage_->Add(msg);
-  reply_queue_->Push(message);
+  if (msg.meta.flag != Flag::kPush)  // pushes are not acknowledged
+    reply_queue_->Push(message);
 }
 
 void ASPModel::Get(Message& msg) {
   // TODO
+  Message message;
+  if (TryGet(msg, &message))
+    reply_queue_->Push(message);
+}
+
+bool ASPModel::TryGet(Message& msg, Message* reply) {
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
-    return;
-  Message message = storage_->Get(msg);
+    return false;
+  *reply = storage_->Get(msg);
   // add round info
-  message.meta.round = GetProgress(msg.meta.sender);
-  reply_queue_->Push(message);
+  reply->meta.round = GetProgress(msg.meta.sender);
+  if (replicator_)
+    replicator_->Record(msg, reply);
+  return true;
+}
+
+void ASPModel::AddBatch(std::vector<Message>& msgs) {
+  std::vector<Message> valid;
+  for (auto& msg : msgs) {
+    if (progress_tracker_.CheckThreadValid(msg.meta.sender))
+      valid.push_back(msg);
+  }
+  auto replies = storage_->AddBatch(valid);
+  for (size_t i = 0; i < valid.size(); i++) {
+    if (valid[i].meta.flag != Flag::kPush)  // pushes are not acknowledged
+      reply_queue_->Push(replies[i]);
+  }
+}
+
+void ASPModel::GetBatch(std::vector<Message>& msgs) {
+  std::vector<Message> valid;
+  for (auto& msg : msgs) {
+    if (progress_tracker_.CheckThreadValid(msg.meta.sender))
+      valid.push_back(msg);
+  }
+  auto replies = storage_->GetBatch(valid);
+  for (size_t i = 0; i < valid.size(); i++) {
+    // add round info
+    replies[i].meta.round = GetProgress(valid[i].meta.sender);
+    if (replicator_)
+      replicator_->Record(valid[i], &replies[i]);
+    reply_queue_->Push(replies[i]);
+  }
 }
 
 int ASPModel::GetProgress(int tid) {
@@ -60,10 +104,7 @@ void ASPModel::ResetWorker(Message& msg) {
   reply_queue_->Push(message);
 }
 
-void ASPModel::Backup() {
-  storage_->Backup(model_id_);
-  progress_tracker_.Backup(model_id_);
-}
+void ASPModel::Backup() { Checkpoint(model_id_, storage_.get(), &progress_tracker_, checkpointer_, &checkpoint_); }
 
 int ASPModel::Recovery() {
   storage_->Recovery(model_id_);
@@ -71,4 +112,20 @@ int ASPModel::Recovery() {
   return min_clock;
 }
 
+void ASPModel::SetCheckpointPrefix(const std::string& prefix) {
+  AbstractModel::SetCheckpointPrefix(prefix, storage_.get(), &progress_tracker_);
+}
+
+void ASPModel::Replicate(Message& msg) {
+  CHECK(replicator_ != nullptr) << "model " << model_id_ << " does not replicate hot keys";
+  if (msg.meta.flag == Flag::kReplicate) {
+    replicator_->Update(msg);
+    return;
+  }
+  if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+    return;
+  // reads are never held back, so any rows do
+  replicator_->Get(msg, 0, GetProgress(msg.meta.sender));
+}
+
 }  // namespace csci5570
@@ -6,8 +6,10 @@
 #include "base/threadsafe_queue.hpp"
 #include "server/abstract_model.hpp"
 #include "server/abstract_storage.hpp"
+#include "server/util/checkpointer.hpp"
 #include "server/util/pending_buffer.hpp"
 #include "server/util/progress_tracker.hpp"
+#include "server/util/replicator.hpp"
 
 namespace csci5570 {
 
@@ -17,15 +19,20 @@ namespace csci5570 {
 class ASPModel : public AbstractModel {
  public:
   explicit ASPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr,
-                    ThreadsafeQueue<Message>* reply_queue);
+                    ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer = nullptr);
 
   virtual void Clock(Message& msg) override;
   virtual void Add(Message& msg) override;
   virtual void Get(Message& msg) override;
+  virtual void AddBatch(std::vector<Message>& msgs) override;
+  virtual void GetBatch(std::vector<Message>& msgs) override;
+  virtual bool TryGet(Message& msg, Message* reply) override;
   virtual int GetProgress(int tid) override;
   virtual void ResetWorker(Message& msg) override;
   virtual void Backup() override;
   virtual int Recovery() override;
+  virtual void SetCheckpointPrefix(const std::string& prefix) override;
+  virtual void Replicate(Message& msg) override;
 
  private:
   uint32_t model_id_;
@@ -33,6 +40,8 @@ class ASPModel : public AbstractModel {
   ThreadsafeQueue<Message>* reply_queue_;     // not owned, the queue where reply messages are put
   std::unique_ptr<AbstractStorage> storage_;  // actual storage
   ProgressTracker progress_tracker_;          // the progresses of all worker threads interacting with the model
+  Checkpointer* checkpointer_;                // not owned, writes the checkpoints if set
+  std::future<void> checkpoint_;              // the last checkpoint submitted to checkpointer_
 };
 
 }  // namespace csci5570
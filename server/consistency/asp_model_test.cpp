@@ -8,6 +8,7 @@
 #include "server/abstract_model.hpp"
 #include "server/consistency/asp_model.hpp"
 #include "server/map_storage.hpp"
+#include "server/util/checkpointer.hpp"
 
 namespace csci5570 {
 namespace {
@@ -195,5 +196,85 @@ TEST_F(TestASPModel, CheckGetAndAdd) {
 
 }
 
+TEST_F(TestASPModel, PushWithoutReply) {
+  ThreadsafeQueue<Message> reply_queue;
+  int model_id = 0;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  std::unique_ptr<AbstractModel> model(new ASPModel(model_id, std::move(storage), &reply_queue));
+  Message reset_msg;
+  third_party::SArray<uint32_t> tids({2, 3});
+  reset_msg.AddData(tids);
+  model->ResetWorker(reset_msg);
+  Message check_msg;
+  reply_queue.WaitAndPop(&check_msg);
+
+  Message msg;
+  msg.meta.flag = Flag::kPush;
+  msg.meta.model_id = 0;
+  msg.meta.sender = 2;
+  msg.meta.recver = 0;
+  msg.AddData(third_party::SArray<int>{0});
+  msg.AddData(third_party::SArray<int>{5});
+  model->Add(msg);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  msg = Message();
+  msg.meta.flag = Flag::kGet;
+  msg.meta.model_id = 0;
+  msg.meta.sender = 2;
+  msg.meta.recver = 0;
+  msg.AddData(third_party::SArray<int>{0});
+  model->Get(msg);
+  reply_queue.WaitAndPop(&check_msg);
+  EXPECT_EQ(check_msg.meta.flag, Flag::kGet);
+  auto rep_vals = third_party::SArray<int>(check_msg.data[1]);
+  ASSERT_EQ(rep_vals.size(), 1);
+  EXPECT_EQ(rep_vals[0], 5);
+}
+
+TEST_F(TestASPModel, BackupInBackground) {
+  ThreadsafeQueue<Message> reply_queue;
+  int model_id = 57;
+  Message msg;
+  msg.meta.flag = Flag::kPush;
+  msg.meta.model_id = model_id;
+  msg.meta.sender = 2;
+  msg.meta.recver = 0;
+  msg.AddData(third_party::SArray<int>{0});
+  msg.AddData(third_party::SArray<int>{5});
+  {
+    Checkpointer checkpointer;
+    std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+    std::unique_ptr<AbstractModel> model(new ASPModel(model_id, std::move(storage), &reply_queue, &checkpointer));
+    Message reset_msg;
+    reset_msg.AddData(third_party::SArray<uint32_t>({2}));
+    model->ResetWorker(reset_msg);
+    Message check_msg;
+    reply_queue.WaitAndPop(&check_msg);
+
+    model->Add(msg);
+    model->Backup();
+    // the model keeps serving while the snapshot is written
+    msg.data[1] = third_party::SArray<char>(third_party::SArray<int>{7});
+    model->Add(msg);
+  }  // the checkpointer finishes the checkpoint
+
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  std::unique_ptr<AbstractModel> model(new ASPModel(model_id, std::move(storage), &reply_queue));
+  EXPECT_EQ(model->Recovery(), 0);
+  msg = Message();
+  msg.meta.flag = Flag::kGet;
+  msg.meta.model_id = model_id;
+  msg.meta.sender = 2;
+  msg.meta.recver = 0;
+  msg.AddData(third_party::SArray<int>{0});
+  model->Get(msg);
+  Message check_msg;
+  reply_queue.WaitAndPop(&check_msg);
+  auto rep_vals = third_party::SArray<int>(check_msg.data[1]);
+  ASSERT_EQ(rep_vals.size(), 1);
+  EXPECT_EQ(rep_vals[0], 5);  // the value at the time of the snapshot
+}
+
 }  // namespace
 }  // namespace csci5570
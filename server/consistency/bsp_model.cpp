@@ -1,13 +1,19 @@
 #include "server/consistency/bsp_model.hpp"
 #include "glog/logging.h"
 
+#include <algorithm>
+
 namespace csci5570 {
 
 BSPModel::BSPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr,
-                   ThreadsafeQueue<Message>* reply_queue) {
+                   ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer,
+                   const QuorumConfig& quorum_config) {
   this->model_id_ = model_id;
+  this->quorum_config_ = quorum_config;
   this->reply_queue_ = reply_queue;
   this->storage_ = std::move(storage_ptr);
+  this->checkpointer_ = checkpointer;
+  this->aggregator_ = storage_->CreateAggregator();
   // TODO
 }
 
@@ -16,36 +22,91 @@ void BSPModel::Clock(Message& msg) {
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
   int tid = msg.meta.sender;  // the worker that finish its iteration
-  if (progress_tracker_.CheckThreadValid(tid)) {
-    int temp = progress_tracker_.AdvanceAndGetChangedMinClock(tid);  // increase its progress
-
-    // if the slowest progress equal to the fastest progress
-    if (temp != -1) {  // the min_clock (slowest progress has been moved forward), we synchronize it every time
-
-      // handle the add/get buffer
-      for (size_t i = 0; i < add_buffer_.size(); i++) {
-        Message reply = storage_->Add(add_buffer_[i]);
-        reply_queue_->Push(reply);
-      }
-      add_buffer_.clear();
-
-      for (size_t j = 0; j < get_buffer_.size(); j++) {
-        Message reply = storage_->Get(get_buffer_[j]);
-        reply_queue_->Push(reply);
-      }
-      get_buffer_.clear();
-    }
-    if (progress_tracker_.GetMinClock() % 10 == 0) {
-      this->Backup();
+  if (progress_tracker_.GetProgress(tid) < round_) {
+    // a straggler done with a round which ended without it joins the current one
+    progress_tracker_.AdvanceToAndGetChangedMinClock(tid, round_);
+  } else {
+    progress_tracker_.AdvanceAndGetChangedMinClock(tid);  // increase its progress
+  }
+  // without a quorum, the round is the min clock and ends once the slowest worker finished it
+  while (progress_tracker_.GetNumAhead(round_) >= GetQuorum()) {
+    EndRound();
+  }
+  if (round_ % 10 == 0) {
+    this->Backup();
+  }
+}
+
+void BSPModel::EndRound() {
+  // the Adds of the iteration are applied in one pass, then the Gets are served in one read
+  if (num_aggregated_ > 0) {
+    third_party::SArray<Key> keys;
+    third_party::SArray<char> vals;
+    aggregator_->Drain(&keys, &vals);
+    storage_->SubAdd(keys, vals);
+    for (auto& reply : add_replies_) {
+      reply_queue_->Push(reply);
     }
+    add_replies_.clear();
+    num_aggregated_ = 0;
   }
+  auto add_replies = storage_->AddBatch(add_buffer_);
+  for (size_t i = 0; i < add_buffer_.size(); i++) {
+    if (add_buffer_[i].meta.flag != Flag::kPush)  // pushes are not acknowledged
+      reply_queue_->Push(add_replies[i]);
+  }
+  add_buffer_.clear();
+  round_ += 1;
+
+  // a worker more than one round ahead waits for the next rounds
+  std::vector<Message> ready;
+  std::vector<Message> waiting;
+  for (auto& get : get_buffer_) {
+    if (progress_tracker_.GetProgress(get.meta.sender) <= round_)
+      ready.push_back(std::move(get));
+    else
+      waiting.push_back(std::move(get));
+  }
+  get_buffer_.swap(waiting);
+  auto get_replies = storage_->GetBatch(ready);
+  for (size_t j = 0; j < ready.size(); j++) {
+    if (replicator_)
+      replicator_->Record(ready[j], &get_replies[j]);
+    reply_queue_->Push(get_replies[j]);
+  }
+  storage_->FinishIter();
+  if (replicator_)
+    replicator_->Refresh(storage_.get(), round_);
+}
+
+int BSPModel::GetQuorum() const {
+  int num_threads = progress_tracker_.GetNumThreads();
+  if (quorum_config_.quorum == 0)
+    return num_threads;
+  return std::min(static_cast<int>(quorum_config_.quorum), num_threads);
 }
 
 void BSPModel::Add(Message& msg) {
   // TODO
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
-  add_buffer_.push_back(msg);
+  if (progress_tracker_.GetProgress(msg.meta.sender) < round_ && !quorum_config_.apply_late_updates) {
+    // made in a round which ended without the worker, only acknowledged
+    num_dropped_++;
+    if (msg.meta.flag != Flag::kPush)  // pushes are not acknowledged
+      reply_queue_->Push(AbstractStorage::Reply(msg));
+    return;
+  }
+  if (aggregator_ == nullptr) {
+    add_buffer_.push_back(std::move(msg));
+    return;
+  }
+  // only the sums are kept, and the reply
+  CHECK(msg.data.size() == 2);
+  aggregator_->Add(third_party::SArray<Key>(msg.data[0]), msg.data[1]);
+  num_aggregated_++;
+  if (msg.meta.flag != Flag::kPush)  // pushes are not acknowledged
+    add_replies_.push_back(AbstractStorage::Reply(msg));
   // int tid = msg.meta.sender;
   // if(progress_tracker_.GetProgress(tid) == progress_tracker_.GetMinClock()){
   // 	storage_->Add(msg);
@@ -58,17 +119,29 @@ void BSPModel::Get(Message& msg) {
   // TODO
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
-  int tid = msg.meta.sender;
-  if (progress_tracker_.GetProgress(tid) == progress_tracker_.GetMinClock()) {
-    Message reply = storage_->Get(msg);
-    // add round info
-    reply.meta.round = GetProgress(msg.meta.sender);
+  Message reply;
+  if (TryGet(msg, &reply)) {
     reply_queue_->Push(reply);
   } else {
-    get_buffer_.push_back(msg);
+    get_buffer_.push_back(std::move(msg));
   }
 }
 
+bool BSPModel::TryGet(Message& msg, Message* reply) {
+  if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+    return false;
+  int tid = msg.meta.sender;
+  // a straggler reads the model of the current round
+  if (progress_tracker_.GetProgress(tid) > round_)
+    return false;
+  *reply = storage_->Get(msg);
+  // add round info
+  reply->meta.round = GetProgress(msg.meta.sender);
+  if (replicator_)
+    replicator_->Record(msg, reply);
+  return true;
+}
+
 int BSPModel::GetProgress(int tid) {
   // TODO
   return progress_tracker_.GetProgress(tid);
@@ -81,7 +154,7 @@ int BSPModel::GetGetPendingSize() {
 
 int BSPModel::GetAddPendingSize() {
   // TODO
-  return add_buffer_.size();
+  return add_buffer_.size() + num_aggregated_;
 }
 
 void BSPModel::ResetWorker(Message& msg) {
@@ -93,6 +166,7 @@ void BSPModel::ResetWorker(Message& msg) {
     tids_v.push_back(tids[i]);
   }
   progress_tracker_.Init(tids_v);
+  round_ = 0;
   Message message;
   message.meta.model_id = model_id_;
   message.meta.recver = msg.meta.sender;
@@ -101,15 +175,30 @@ void BSPModel::ResetWorker(Message& msg) {
   reply_queue_->Push(message);
 }
 
-void BSPModel::Backup() {
-  storage_->Backup(model_id_);
-  progress_tracker_.Backup(model_id_);
-}
+void BSPModel::Backup() { Checkpoint(model_id_, storage_.get(), &progress_tracker_, checkpointer_, &checkpoint_); }
 
 int BSPModel::Recovery() {
   storage_->Recovery(model_id_);
   int min_clock = progress_tracker_.Recovery(model_id_);
+  // the round is not checkpointed, so it restarts from the slowest worker
+  round_ = min_clock;
   return min_clock;
 }
 
+void BSPModel::SetCheckpointPrefix(const std::string& prefix) {
+  AbstractModel::SetCheckpointPrefix(prefix, storage_.get(), &progress_tracker_);
+}
+
+void BSPModel::Replicate(Message& msg) {
+  CHECK(replicator_ != nullptr) << "model " << model_id_ << " does not replicate hot keys";
+  if (msg.meta.flag == Flag::kReplicate) {
+    replicator_->Update(msg);
+    return;
+  }
+  if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+    return;
+  // the rows must hold every update before the clock of the worker
+  replicator_->Get(msg, GetProgress(msg.meta.sender), GetProgress(msg.meta.sender));
+}
+
 }  // namespace csci5570
@@ -3,41 +3,80 @@
 #include "base/message.hpp"
 #include "base/threadsafe_queue.hpp"
 #include "server/abstract_storage.hpp"
+#include "server/util/checkpointer.hpp"
 #include "server/util/pending_buffer.hpp"
 #include "server/util/progress_tracker.hpp"
+#include "server/util/replicator.hpp"
 
 #include <map>
 #include <vector>
 
 namespace csci5570 {
 
+/*
+ * When a round of a BSP table ends. A round ends once every worker clocked unless quorum is set, in which case the
+ * slowest workers are left behind as backup workers and their updates for the rounds ended without them are late.
+ */
+struct QuorumConfig {
+  uint32_t quorum = 0;              // the workers to clock before a round ends, 0 for all of them
+  bool apply_late_updates = false;  // apply the late updates at the end of the current round, or drop them
+};
+
 /**
  * A wrapper for model with Batch Synchronous Parallel consistency
+ *
+ * With a quorum of k, a round ends once k workers finished it, so the n - k slowest do not stall the others. A
+ * straggler reads the model of the current round at once, and joins the current round at its next Clock.
  */
 class BSPModel : public AbstractModel {
  public:
+  /**
+   * @param quorum_config   when a round ends and what becomes of the late updates, see QuorumConfig
+   */
   explicit BSPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr,
-                    ThreadsafeQueue<Message>* reply_queue);
+                    ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer = nullptr,
+                    const QuorumConfig& quorum_config = QuorumConfig());
 
   virtual void Clock(Message& msg) override;
   virtual void Add(Message& msg) override;
   virtual void Get(Message& msg) override;
+  virtual bool TryGet(Message& msg, Message* reply) override;
   virtual int GetProgress(int tid) override;
   virtual void ResetWorker(Message& msg) override;
   virtual void Backup() override;
   virtual int Recovery() override;
+  virtual void SetCheckpointPrefix(const std::string& prefix) override;
+  virtual void Replicate(Message& msg) override;
 
   int GetGetPendingSize();
   int GetAddPendingSize();
+  // the current round, the min clock unless a quorum is set
+  int GetRound() const { return round_; }
+  // the late updates dropped
+  int GetNumDropped() const { return num_dropped_; }
 
  private:
+  // Apply the Adds of the round, move to the next round and serve the Gets waiting for it
+  void EndRound();
+  // the workers to clock before a round ends
+  int GetQuorum() const;
+
   uint32_t model_id_;
+  QuorumConfig quorum_config_;
+  int round_ = 0;        // every Add before it is applied
+  int num_dropped_ = 0;
 
   ThreadsafeQueue<Message>* reply_queue_;
   std::unique_ptr<AbstractStorage> storage_;
   ProgressTracker progress_tracker_;
   std::vector<Message> get_buffer_;  // buffer of get requests
   std::vector<Message> add_buffer_;  // buffer of add requests
+  // if the storage has one, sums the add requests of the clock instead of add_buffer_
+  std::unique_ptr<AbstractAggregator> aggregator_;
+  std::vector<Message> add_replies_;  // the replies of the aggregated add requests
+  int num_aggregated_ = 0;            // the aggregated add requests, pushes included
+  Checkpointer* checkpointer_;       // not owned, writes the checkpoints if set
+  std::future<void> checkpoint_;     // the last checkpoint submitted to checkpointer_
 };
 
 }  // namespace csci5570
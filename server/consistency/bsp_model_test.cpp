@@ -130,5 +130,136 @@ TEST_F(TestBSPModel, CheckGetAndAdd) {
   EXPECT_EQ(rep_vals2[0], 100);
 }
 
+TEST_F(TestBSPModel, AggregateLinearUpdates) {
+  ThreadsafeQueue<Message> reply_queue;
+  UpdaterConfig config;
+  config.type = UpdaterType::SGD;
+  config.learning_rate = 1.0;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>(CreateUpdater<int>(config)));
+  std::unique_ptr<AbstractModel> model(new BSPModel(0, std::move(storage), &reply_queue));
+  Message reset_msg;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2, 3}));
+  model->ResetWorker(reset_msg);
+  Message reply;
+  reply_queue.WaitAndPop(&reply);
+
+  std::vector<std::pair<int, Flag>> adds{{2, Flag::kAdd}, {3, Flag::kPush}, {3, Flag::kAdd}};
+  for (int i = 0; i < adds.size(); i++) {
+    Message m;
+    m.meta.flag = adds[i].second;
+    m.meta.sender = adds[i].first;
+    m.AddData(third_party::SArray<Key>({1, 2}));
+    m.AddData(third_party::SArray<int>({i + 1, 10}));
+    model->Add(m);
+  }
+  EXPECT_EQ(dynamic_cast<BSPModel*>(model.get())->GetAddPendingSize(), 3);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  for (int tid : {2, 3}) {
+    Message clock;
+    clock.meta.flag = Flag::kClock;
+    clock.meta.sender = tid;
+    model->Clock(clock);
+  }
+  EXPECT_EQ(dynamic_cast<BSPModel*>(model.get())->GetAddPendingSize(), 0);
+  // the adds are acknowledged, the push is not
+  ASSERT_EQ(reply_queue.Size(), 2);
+  reply_queue.WaitAndPop(&reply);
+  reply_queue.WaitAndPop(&reply);
+
+  Message get;
+  get.meta.flag = Flag::kGet;
+  get.meta.sender = 2;
+  get.AddData(third_party::SArray<Key>({1, 2}));
+  model->Get(get);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  reply_queue.WaitAndPop(&reply);
+  auto rep_vals = third_party::SArray<int>(reply.data[1]);
+  ASSERT_EQ(rep_vals.size(), 2);
+  EXPECT_EQ(rep_vals[0], -6);
+  EXPECT_EQ(rep_vals[1], -30);
+}
+
+TEST_F(TestBSPModel, Quorum) {
+  ThreadsafeQueue<Message> reply_queue;
+  QuorumConfig config;
+  config.quorum = 2;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  BSPModel model(0, std::move(storage), &reply_queue, nullptr, config);
+  Message reset_msg;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2, 3, 4}));
+  model.ResetWorker(reset_msg);
+  Message reset_reply_msg;
+  reply_queue.WaitAndPop(&reset_reply_msg);
+
+  Message add;
+  add.meta.flag = Flag::kAdd;
+  add.meta.sender = 2;
+  add.AddData(third_party::SArray<Key>({1}));
+  add.AddData(third_party::SArray<int>({10}));
+  model.Add(add);
+  Message clock;
+  clock.meta.flag = Flag::kClock;
+  clock.meta.sender = 2;
+  model.Clock(clock);
+  EXPECT_EQ(model.GetRound(), 0);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  // the round ends with 2 of the 3 workers, worker 4 being left behind
+  clock.meta.sender = 3;
+  model.Clock(clock);
+  EXPECT_EQ(model.GetRound(), 1);
+  EXPECT_EQ(model.GetAddPendingSize(), 0);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  Message reply;
+  reply_queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.recver, 2);
+
+  // the straggler reads the model of the round at once, and its late update is only acknowledged
+  Message get;
+  get.meta.flag = Flag::kGet;
+  get.meta.sender = 4;
+  get.AddData(third_party::SArray<Key>({1}));
+  model.Get(get);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  reply_queue.WaitAndPop(&reply);
+  EXPECT_EQ(third_party::SArray<int>(reply.data[1])[0], 10);
+  add.meta.sender = 4;
+  model.Add(add);
+  EXPECT_EQ(model.GetNumDropped(), 1);
+  EXPECT_EQ(model.GetAddPendingSize(), 0);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  reply_queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.flag, Flag::kAdd);
+  EXPECT_EQ(reply.meta.recver, 4);
+
+  // and joins the current round at its Clock
+  clock.meta.sender = 4;
+  model.Clock(clock);
+  EXPECT_EQ(model.GetProgress(4), 1);
+  EXPECT_EQ(model.GetRound(), 1);
+  model.Get(get);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  reply_queue.WaitAndPop(&reply);
+  EXPECT_EQ(third_party::SArray<int>(reply.data[1])[0], 10);
+
+  // a worker two rounds ahead waits for both
+  get.meta.sender = 2;
+  model.Clock(clock);  // [1,1,2]
+  clock.meta.sender = 2;
+  model.Clock(clock);  // [2,1,2], round 2
+  model.Clock(clock);  // [3,1,2]
+  EXPECT_EQ(model.GetRound(), 2);
+  model.Get(get);
+  EXPECT_EQ(model.GetGetPendingSize(), 1);
+  clock.meta.sender = 3;
+  model.Clock(clock);  // [3,2,2]
+  EXPECT_EQ(model.GetGetPendingSize(), 1);
+  clock.meta.sender = 4;
+  model.Clock(clock);  // [3,2,3], round 3
+  EXPECT_EQ(model.GetRound(), 3);
+  EXPECT_EQ(model.GetGetPendingSize(), 0);
+}
+
 }  // namespace
 }  // namespace csci5570
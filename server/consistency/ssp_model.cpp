@@ -5,9 +5,19 @@
 namespace csci5570 {
 
 SSPModel::SSPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr, int staleness,
-                   ThreadsafeQueue<Message>* reply_queue)
-    : model_id_(model_id), storage_(std::move(storage_ptr)), staleness_(staleness), reply_queue_(reply_queue) {
+                   ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer,
+                   const StalenessConfig& staleness_config)
+    : model_id_(model_id),
+      staleness_controller_(staleness, staleness_config),
+      staleness_(staleness_controller_.GetStaleness()),
+      reply_queue_(reply_queue),
+      storage_(std::move(storage_ptr)),
+      progress_tracker_(staleness_controller_.GetMaxStaleness() + 2),
+      buffer_(staleness_controller_.GetMaxStaleness() + 2),
+      checkpointer_(checkpointer) {
   // TODO
+  if (staleness_config.eager)
+    refresher_.reset(new Refresher(model_id, reply_queue, staleness_config.refresh_ttl));
 }
 
 void SSPModel::Clock(Message& msg) {
@@ -15,19 +25,46 @@ void SSPModel::Clock(Message& msg) {
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
   int cur_mini_clock = progress_tracker_.AdvanceAndGetChangedMinClock(msg.meta.sender);
+  if (cur_mini_clock != -1)
+    storage_->FinishIter();
   if (cur_mini_clock != -1 &&
       GetPendingSize(cur_mini_clock) > 0) {  // min_clock changed, process pending messages if needed
-    auto pendingMsgs = buffer_.Pop(cur_mini_clock);
-    for (auto pending : pendingMsgs) {
-      if (pending.meta.flag == Flag::kAdd)
-        Add(pending);
-      if (pending.meta.flag == Flag::kGet)
-        Get(pending);
-    }
+    ServePending(cur_mini_clock);
     if(cur_mini_clock % 10 == 0){
       this->Backup();
     }
   }
+  if (cur_mini_clock != -1) {
+    int staleness = staleness_;
+    staleness_ = staleness_controller_.Update(cur_mini_clock, progress_tracker_.GetMaxClock(), buffer_.TotalSize());
+    // a wider bound lets the requests held back for the next clocks through now
+    for (int clock = cur_mini_clock + 1; clock <= cur_mini_clock + staleness_ - staleness; clock++) {
+      ServePending(clock);
+    }
+    // the rows hold every update of the clocks before the min clock, which a worker may read until min clock plus
+    // the staleness; a later narrowing of the staleness comes with an advance of the min clock, so it stays valid
+    if (refresher_)
+      refresher_->Refresh(storage_.get(), cur_mini_clock + staleness_);
+    // after the held back updates now applied, so the replicas hold every update of a worker before its clock
+    if (replicator_)
+      replicator_->Refresh(storage_.get(), cur_mini_clock);
+  }
+}
+
+void SSPModel::ServePending(int clock) {
+  buffer_.Pop(clock, &pending_);
+  for (auto& pending : pending_) {
+    if (pending.meta.flag == Flag::kAdd || pending.meta.flag == Flag::kPush)
+      Add(pending);
+    if (pending.meta.flag == Flag::kGet)
+      Get(pending);
+  }
+  pending_.clear();  // keeps the capacity for the next clock
+}
+
+void SSPModel::Defer(Message& msg) {
+  staleness_controller_.RecordDeferred();
+  buffer_.Push(GetProgress(msg.meta.sender) - staleness_, std::move(msg));
 }
 
 void SSPModel::Add(Message& msg) {
@@ -36,9 +73,14 @@ void SSPModel::Add(Message& msg) {
     return;
   if (GetProgress(msg.meta.sender) - progress_tracker_.GetMinClock() <= staleness_) {
     Message reply = storage_->Add(msg);
-    reply_queue_->Push(reply);
+    if (refresher_)
+      refresher_->CountUpdate(msg);
+    if (replicator_)
+      replicator_->CountUpdate(msg);
+    if (msg.meta.flag != Flag::kPush)  // pushes are not acknowledged
+      reply_queue_->Push(reply);
   } else {
-    buffer_.Push(GetProgress(msg.meta.sender) - staleness_, msg);
+    Defer(msg);
   }
 }
 
@@ -46,13 +88,69 @@ void SSPModel::Get(Message& msg) {
   // TODO
   if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
     return;
-  if (GetProgress(msg.meta.sender) - progress_tracker_.GetMinClock() <= staleness_) {
-    Message reply = storage_->Get(msg);
-    // add round info
-    reply.meta.round = GetProgress(msg.meta.sender);
+  Message reply;
+  if (TryGet(msg, &reply)) {
     reply_queue_->Push(reply);
   } else {
-    buffer_.Push(GetProgress(msg.meta.sender) - staleness_, msg);
+    Defer(msg);
+  }
+}
+
+bool SSPModel::TryGet(Message& msg, Message* reply) {
+  if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+    return false;
+  if (GetProgress(msg.meta.sender) - progress_tracker_.GetMinClock() > staleness_)
+    return false;
+  *reply = storage_->Get(msg);
+  // add round info
+  reply->meta.round = GetProgress(msg.meta.sender);
+  if (replicator_)
+    replicator_->Record(msg, reply);
+  if (refresher_)
+    refresher_->Subscribe(msg);
+  return true;
+}
+
+void SSPModel::AddBatch(std::vector<Message>& msgs) {
+  std::vector<Message> ready;  // the Adds within the staleness, the others wait for the min clock
+  for (auto& msg : msgs) {
+    if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+      continue;
+    if (GetProgress(msg.meta.sender) - progress_tracker_.GetMinClock() <= staleness_)
+      ready.push_back(std::move(msg));
+    else
+      Defer(msg);
+  }
+  auto replies = storage_->AddBatch(ready);
+  for (size_t i = 0; i < ready.size(); i++) {
+    if (refresher_)
+      refresher_->CountUpdate(ready[i]);
+    if (replicator_)
+      replicator_->CountUpdate(ready[i]);
+    if (ready[i].meta.flag != Flag::kPush)  // pushes are not acknowledged
+      reply_queue_->Push(replies[i]);
+  }
+}
+
+void SSPModel::GetBatch(std::vector<Message>& msgs) {
+  std::vector<Message> ready;  // the Gets within the staleness, the others wait for the min clock
+  for (auto& msg : msgs) {
+    if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+      continue;
+    if (GetProgress(msg.meta.sender) - progress_tracker_.GetMinClock() <= staleness_)
+      ready.push_back(std::move(msg));
+    else
+      Defer(msg);
+  }
+  auto replies = storage_->GetBatch(ready);
+  for (size_t i = 0; i < ready.size(); i++) {
+    // add round info
+    replies[i].meta.round = GetProgress(ready[i].meta.sender);
+    if (replicator_)
+      replicator_->Record(ready[i], &replies[i]);
+    if (refresher_)
+      refresher_->Subscribe(ready[i]);
+    reply_queue_->Push(replies[i]);
   }
 }
 
@@ -78,10 +176,7 @@ void SSPModel::ResetWorker(Message& msg) {
   reply_queue_->Push(relpy);
 }
 
-void SSPModel::Backup() {
-  storage_->Backup(model_id_);
-  progress_tracker_.Backup(model_id_);
-}
+void SSPModel::Backup() { Checkpoint(model_id_, storage_.get(), &progress_tracker_, checkpointer_, &checkpoint_); }
 
 int SSPModel::Recovery() {
   storage_->Recovery(model_id_);
@@ -89,4 +184,20 @@ int SSPModel::Recovery() {
   return min_clock;
 }
 
+void SSPModel::SetCheckpointPrefix(const std::string& prefix) {
+  AbstractModel::SetCheckpointPrefix(prefix, storage_.get(), &progress_tracker_);
+}
+
+void SSPModel::Replicate(Message& msg) {
+  CHECK(replicator_ != nullptr) << "model " << model_id_ << " does not replicate hot keys";
+  if (msg.meta.flag == Flag::kReplicate) {
+    replicator_->Update(msg);
+    return;
+  }
+  if (!progress_tracker_.CheckThreadValid(msg.meta.sender))
+    return;
+  // the rows must hold every update before the clock of the worker minus the staleness, and its own updates
+  replicator_->Get(msg, GetProgress(msg.meta.sender) - staleness_, GetProgress(msg.meta.sender), true);
+}
+
 }  // namespace csci5570
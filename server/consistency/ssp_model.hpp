@@ -3,9 +3,14 @@
 #include "base/message.hpp"
 #include "base/threadsafe_queue.hpp"
 #include "server/abstract_storage.hpp"
+#include "server/util/checkpointer.hpp"
 #include "server/util/pending_buffer.hpp"
 #include "server/util/progress_tracker.hpp"
+#include "server/util/refresher.hpp"
+#include "server/util/replicator.hpp"
+#include "server/util/staleness_controller.hpp"
 
+#include <deque>
 #include <map>
 #include <vector>
 
@@ -16,16 +21,27 @@ namespace csci5570 {
  */
 class SSPModel : public AbstractModel {
  public:
+  /**
+   * @param staleness           the staleness, or the one to start from if adaptive
+   * @param staleness_config    whether and within which limits the staleness adapts, see StalenessController,
+   *                            and whether the rows read are pushed to the workers, see Refresher
+   */
   explicit SSPModel(uint32_t model_id, std::unique_ptr<AbstractStorage>&& storage_ptr, int staleness,
-                    ThreadsafeQueue<Message>* reply_queue);
+                    ThreadsafeQueue<Message>* reply_queue, Checkpointer* checkpointer = nullptr,
+                    const StalenessConfig& staleness_config = StalenessConfig());
 
   virtual void Clock(Message& msg) override;
   virtual void Add(Message& msg) override;
   virtual void Get(Message& msg) override;
+  virtual void AddBatch(std::vector<Message>& msgs) override;
+  virtual void GetBatch(std::vector<Message>& msgs) override;
+  virtual bool TryGet(Message& msg, Message* reply) override;
   virtual int GetProgress(int tid) override;
   virtual void ResetWorker(Message& msg) override;
   virtual void Backup() override;
   virtual int Recovery() override;
+  virtual void SetCheckpointPrefix(const std::string& prefix) override;
+  virtual void Replicate(Message& msg) override;
 
   /**
    * Return the number of requests waiting at the specific progress
@@ -34,14 +50,31 @@ class SSPModel : public AbstractModel {
    */
   int GetPendingSize(int progress);
 
+  // the current staleness
+  int GetStaleness() const { return staleness_; }
+  // (min clock, staleness chosen at it) at the recent advances of the min clock, see StalenessController
+  const std::deque<std::pair<int, int>>& GetStalenessHistory() const {
+    return staleness_controller_.GetHistory();
+  }
+
  private:
+  // Serve the requests held back until the min clock reaches the clock
+  void ServePending(int clock);
+  // Hold back a request until the min clock lets it within the staleness
+  void Defer(Message& msg);
+
   uint32_t model_id_;
-  uint32_t staleness_;
+  StalenessController staleness_controller_;
+  int staleness_;  // staleness_controller_.GetStaleness()
 
   ThreadsafeQueue<Message>* reply_queue_;
   std::unique_ptr<AbstractStorage> storage_;
   ProgressTracker progress_tracker_;
   PendingBuffer buffer_;
+  std::vector<Message> pending_;  // the requests popped from buffer_ at a clock
+  Checkpointer* checkpointer_;    // not owned, writes the checkpoints if set
+  std::future<void> checkpoint_;  // the last checkpoint submitted to checkpointer_
+  std::unique_ptr<Refresher> refresher_;    // pushes the rows read to the workers if eager
 };
 
 }  // namespace csci5570
@@ -251,5 +251,137 @@ TEST_F(TestSSPModel, CheckStaleness) {
   EXPECT_EQ(dynamic_cast<SSPModel*>(model.get())->GetPendingSize(1), 0);
 }
 
+TEST_F(TestSSPModel, TryGet) {
+  ThreadsafeQueue<Message> reply_queue;
+  int staleness = 1;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  std::unique_ptr<AbstractModel> model(new SSPModel(0, std::move(storage), staleness, &reply_queue));
+  Message reset_msg;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2, 3}));
+  model->ResetWorker(reset_msg);
+  Message reset_reply_msg;
+  reply_queue.WaitAndPop(&reset_reply_msg);
+
+  Message get;
+  get.meta.flag = Flag::kGet;
+  get.meta.model_id = 0;
+  get.meta.sender = 2;
+  get.meta.recver = 0;
+  get.AddData(third_party::SArray<Key>({0}));
+  Message clock = get;
+  clock.meta.flag = Flag::kClock;
+
+  // within the staleness, served into the reply and not pushed
+  Message reply;
+  model->Clock(clock);
+  EXPECT_TRUE(model->TryGet(get, &reply));
+  EXPECT_EQ(reply.meta.round, 1);
+  EXPECT_EQ(reply.meta.recver, 2);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  // beyond the staleness, left to the caller and not buffered
+  model->Clock(clock);
+  EXPECT_FALSE(model->TryGet(get, &reply));
+  EXPECT_EQ(dynamic_cast<SSPModel*>(model.get())->GetPendingSize(1), 0);
+  EXPECT_EQ(reply_queue.Size(), 0);
+}
+
+TEST_F(TestSSPModel, AdaptiveStaleness) {
+  ThreadsafeQueue<Message> reply_queue;
+  StalenessConfig config;
+  config.adaptive = true;
+  config.max_staleness = 2;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  SSPModel model(0, std::move(storage), 0, &reply_queue, nullptr, config);
+  Message reset_msg;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2, 3}));
+  model.ResetWorker(reset_msg);
+  Message reset_reply_msg;
+  reply_queue.WaitAndPop(&reset_reply_msg);
+
+  Message clock;
+  clock.meta.flag = Flag::kClock;
+  clock.meta.sender = 2;
+  model.Clock(clock);
+  model.Clock(clock);  // [2,0]
+
+  // held back at clock 2 by the staleness 0
+  Message get;
+  get.meta.flag = Flag::kGet;
+  get.meta.sender = 2;
+  get.AddData(third_party::SArray<Key>({0}));
+  model.Get(get);
+  EXPECT_EQ(model.GetPendingSize(2), 1);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  // the min clock moves to 1 and the bound widens to 1, which lets the Get through
+  clock.meta.sender = 3;
+  model.Clock(clock);  // [2,1]
+  EXPECT_EQ(model.GetStaleness(), 1);
+  EXPECT_EQ(model.GetPendingSize(2), 0);
+  ASSERT_EQ(reply_queue.Size(), 1);
+  Message reply;
+  reply_queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.round, 2);
+  EXPECT_EQ(model.GetStalenessHistory(), (std::deque<std::pair<int, int>>({{1, 1}})));
+}
+
+TEST_F(TestSSPModel, EagerPush) {
+  ThreadsafeQueue<Message> reply_queue;
+  StalenessConfig config;
+  config.eager = true;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  SSPModel model(0, std::move(storage), 1, &reply_queue, nullptr, config);
+  Message reset_msg;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2, 3}));
+  model.ResetWorker(reset_msg);
+  Message reset_reply_msg;
+  reply_queue.WaitAndPop(&reset_reply_msg);
+
+  // worker 2 reads key 0 and pushes to key 0 and 1
+  Message get;
+  get.meta.flag = Flag::kGet;
+  get.meta.sender = 2;
+  get.meta.recver = 5;
+  get.AddData(third_party::SArray<Key>({0}));
+  model.Get(get);
+  Message reply;
+  reply_queue.WaitAndPop(&reply);
+  Message push;
+  push.meta.flag = Flag::kPush;
+  push.meta.sender = 2;
+  push.meta.recver = 5;
+  push.AddData(third_party::SArray<Key>({0, 1}));
+  push.AddData(third_party::SArray<int>({7, 8}));
+  model.Add(push);
+  EXPECT_EQ(reply_queue.Size(), 0);
+
+  // nothing is pushed until the min clock advances
+  Message clock;
+  clock.meta.flag = Flag::kClock;
+  clock.meta.sender = 2;
+  model.Clock(clock);  // [1,0]
+  EXPECT_EQ(reply_queue.Size(), 0);
+  clock.meta.sender = 3;
+  model.Clock(clock);  // [1,1]
+
+  // only the subscriber gets its keys, readable up to clock 1 + 1 and holding its one update
+  ASSERT_EQ(reply_queue.Size(), 1);
+  Message refresh;
+  reply_queue.WaitAndPop(&refresh);
+  EXPECT_EQ(refresh.meta.flag, Flag::kRefresh);
+  EXPECT_EQ(refresh.meta.sender, 5);
+  EXPECT_EQ(refresh.meta.recver, 2);
+  EXPECT_EQ(refresh.meta.round, 2);
+  ASSERT_EQ(refresh.data.size(), 3);
+  auto keys = third_party::SArray<Key>(refresh.data[0]);
+  auto vals = third_party::SArray<int>(refresh.data[1]);
+  auto num_updates = third_party::SArray<uint64_t>(refresh.data[2]);
+  EXPECT_EQ(std::vector<Key>(keys.begin(), keys.end()), std::vector<Key>({0}));
+  EXPECT_EQ(std::vector<int>(vals.begin(), vals.end()), std::vector<int>({7}));
+  ASSERT_EQ(num_updates.size(), 1);
+  EXPECT_EQ(num_updates[0], 1);
+}
+
 }  // namespace
 }  // namespace csci5570
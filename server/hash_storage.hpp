@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <string>
+#include <memory>
+#include <vector>
+#include "base/message.hpp"
+#include "server/abstract_storage.hpp"
+#include "server/block_layout.hpp"
+#include "server/updater.hpp"
+#include "server/util/checkpoint.hpp"
+#include "server/util/feature_filter.hpp"
+#include "server/util/flat_hash_map.hpp"
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+/*
+ * Storage for huge sparse tables, backed by an open-addressing hash map.
+ * Compared with MapStorage, an entry costs one control byte on top of the key and the value, and a lookup probes
+ * a group of slots with one SIMD compare instead of chasing tree nodes.
+ */
+template <typename Val>
+class HashStorage : public AbstractStorage {
+ public:
+  HashStorage() : HashStorage(std::unique_ptr<AbstractUpdater<Val>>(new AssignUpdater<Val>())) {}
+  explicit HashStorage(std::unique_ptr<AbstractUpdater<Val>>&& updater, size_t dim = 1,
+                       Precision precision = Precision::Full, const FeatureConfig& feature_config = FeatureConfig())
+      : filter_(feature_config),
+        layout_(std::move(updater), dim, precision, filter_.Evicts()),
+        dim_(dim),
+        block_bytes_(layout_.BlockBytes()),
+        storage_(block_bytes_) {}
+
+  virtual void SubAdd(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) override {
+    auto typed_vals = third_party::SArray<Val>(vals);
+    CHECK_EQ(typed_keys.size() * dim_, typed_vals.size());
+    for (int i = 0; i < typed_keys.size(); i++) {
+      char* block = storage_.Find(typed_keys[i]);
+      if (block == nullptr) {
+        // the updates of a key are dropped until it is admitted
+        if (!filter_.Admit(typed_keys[i]))
+          continue;
+        block = storage_.FindOrInsert(typed_keys[i]);
+      }
+      dirty_keys_.FindOrInsert(typed_keys[i]);
+      if (filter_.Evicts())
+        filter_.Touch(layout_.Stats(block));
+      layout_.Update(block, &typed_vals[i * dim_]);
+    }
+  }
+
+  virtual third_party::SArray<char> SubGet(const third_party::SArray<Key>& typed_keys) override {
+    size_t row_bytes = layout_.RowBytes();
+    third_party::SArray<char> reply_vals(typed_keys.size() * row_bytes);
+    for (int i = 0; i < typed_keys.size(); i++) {
+      // keys never added are read as zero
+      char* block = storage_.Find(typed_keys[i]);
+      if (block == nullptr)
+        continue;
+      if (filter_.Evicts())
+        filter_.Touch(layout_.Stats(block));
+      layout_.CopyRow(block, &reply_vals[i * row_bytes]);
+    }
+    return reply_vals;
+  }
+
+  virtual std::function<void()> Snapshot(int model_id) override {
+    // the keys are sorted by the task rather than here on the server thread
+    std::shared_ptr<KVSnapshot<Key, char>> snapshot(new KVSnapshot<Key, char>(block_bytes_));
+    bool full = schedule_.NextIsFull(dirty_keys_.Size(), storage_.Size());
+    if (full) {
+      snapshot->keys.reserve(storage_.Size());
+      snapshot->vals.reserve(storage_.Size() * block_bytes_);
+      storage_.ForEach([&snapshot](Key key, const char* block) { snapshot->Add(key, block); });
+    } else {
+      // only the keys changed since the last checkpoint
+      snapshot->keys.reserve(dirty_keys_.Size());
+      snapshot->vals.reserve(dirty_keys_.Size() * block_bytes_);
+      dirty_keys_.ForEach([this, &snapshot](Key key, const char*) { snapshot->Add(key, storage_.Find(key)); });
+    }
+    dirty_keys_ = FlatHashMap<Key, char>();
+    std::string path = schedule_.Next(CheckpointPath(model_id), full);
+    snapshot->epoch = schedule_.Epoch();
+    return [snapshot, path]() { snapshot->Write(path); };
+  }
+
+  virtual void Recovery(int model_id) override {
+    std::string path = CheckpointPath(model_id);
+    schedule_.Replay<char, Key>(path, block_bytes_, [this](const Key* keys, const char* blocks, int64_t num_keys,
+                                                           bool full) {
+      for (int64_t i = 0; i < num_keys; i++) {
+        char* block = storage_.FindOrInsert(keys[i]);
+        std::copy_n(blocks + i * block_bytes_, block_bytes_, block);
+        if (filter_.Evicts())
+          filter_.Restore(*layout_.Stats(block));
+      }
+    });
+  }
+
+  // Evict the keys selected by the feature filter
+  virtual void FinishIter() override {
+    if (!filter_.Evicts())
+      return;
+    filter_.Clock();
+    std::vector<Key> victims =
+        filter_.Evict(storage_.Size(), [this](const std::function<void(Key, KeyStats*)>& func) {
+          storage_.ForEach([this, &func](Key key, char* block) { func(key, layout_.Stats(block)); });
+        });
+    for (Key key : victims) {
+      storage_.Erase(key);
+    }
+    if (!victims.empty())
+      schedule_.RequireFull();
+  }
+
+  virtual std::unique_ptr<AbstractAggregator> CreateAggregator() override {
+    if (!layout_.IsLinear() || filter_.CountsAdds())
+      return nullptr;
+    return std::unique_ptr<AbstractAggregator>(new UpdateAggregator<Val>(dim_));
+  }
+
+  size_t Size() const { return storage_.Size(); }
+
+ private:
+  FeatureFilter filter_;
+  BlockLayout<Val> layout_;
+  size_t dim_;          // number of weights per key
+  size_t block_bytes_;  // see BlockLayout
+  FlatHashMap<Key, char> storage_;
+  FlatHashMap<Key, char> dirty_keys_;  // the keys changed since the last checkpoint, as a set
+  CheckpointSchedule schedule_;
+};
+
+}  // namespace csci5570
@@ -0,0 +1,93 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/hash_storage.hpp"
+
+namespace csci5570 {
+namespace {
+
+class TestHashStorage : public testing::Test {
+ public:
+  TestHashStorage() {}
+  ~TestHashStorage() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestHashStorage, AddGetInt) {
+  HashStorage<int> s;
+
+  Message m;
+  third_party::SArray<Key> s_keys({13, 14, 15});
+  third_party::SArray<int> s_vals({1, 2, 3});
+  m.AddData(s_keys);
+  m.AddData(s_vals);
+  s.Add(m);
+
+  Message m2;
+  m2.AddData(s_keys);
+  Message rep = s.Get(m2);
+
+  EXPECT_EQ(rep.data.size(), 2);
+  auto rep_keys = third_party::SArray<Key>(rep.data[0]);
+  auto rep_vals = third_party::SArray<int>(rep.data[1]);
+  for (int index = 0; index < s_keys.size(); index++) {
+    EXPECT_EQ(rep_keys[index], s_keys[index]);
+    EXPECT_EQ(rep_vals[index], s_vals[index]);
+  }
+}
+
+TEST_F(TestHashStorage, SubAddSubGetFloat) {
+  HashStorage<float> s;
+
+  third_party::SArray<Key> s_keys({10, 1400000, 4000000000});
+  third_party::SArray<float> s_vals({0.1, 0.2, 0.3});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_vals));
+  third_party::SArray<float> ret = third_party::SArray<float>(s.SubGet(s_keys));
+  for (int i = 0; i < s_keys.size(); ++ i) {
+    EXPECT_EQ(ret[i], s_vals[i]);
+  }
+}
+
+TEST_F(TestHashStorage, GetAbsentKey) {
+  HashStorage<double> s;
+
+  third_party::SArray<Key> s_keys({11, 12});
+  third_party::SArray<double> ret = third_party::SArray<double>(s.SubGet(s_keys));
+  EXPECT_EQ(ret[0], 0.0);
+  EXPECT_EQ(ret[1], 0.0);
+}
+
+TEST_F(TestHashStorage, AdmitAndEvict) {
+  UpdaterConfig updater_config;
+  updater_config.type = UpdaterType::SGD;
+  updater_config.learning_rate = 1.0;
+  FeatureConfig feature_config;
+  feature_config.min_count = 2;
+  feature_config.ttl = 2;
+  HashStorage<double> s(CreateUpdater<double>(updater_config), 1, Precision::Full, feature_config);
+
+  third_party::SArray<Key> s_keys({11, 12});
+  s.SubAdd(third_party::SArray<Key>({11}), third_party::SArray<char>(third_party::SArray<double>({1.0})));
+  EXPECT_EQ(s.Size(), 0);  // the first update of a key is dropped
+  s.SubAdd(s_keys, third_party::SArray<char>(third_party::SArray<double>({1.0, 1.0})));
+  s.SubAdd(s_keys, third_party::SArray<char>(third_party::SArray<double>({1.0, 1.0})));
+  EXPECT_EQ(s.Size(), 2);
+  third_party::SArray<double> ret = third_party::SArray<double>(s.SubGet(s_keys));
+  EXPECT_EQ(ret[0], -2.0);
+  EXPECT_EQ(ret[1], -1.0);
+
+  // reads keep a key alive
+  s.FinishIter();
+  s.SubGet(third_party::SArray<Key>({11}));
+  s.FinishIter();
+  EXPECT_EQ(s.Size(), 1);
+  s.FinishIter();
+  s.FinishIter();
+  EXPECT_EQ(s.Size(), 0);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "base/abstract_local_servers.hpp"
+#include "server/server_thread.hpp"
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+/*
+ * The server threads of a node, served directly to the workers of the node through the locks of the threads
+ */
+class LocalServers : public AbstractLocalServers {
+ public:
+  /**
+   * @param server_threads    the server threads of the node, not owned
+   */
+  explicit LocalServers(const std::vector<ServerThread*>& server_threads) {
+    for (auto* server_thread : server_threads) {
+      server_threads_[server_thread->GetId()] = server_thread;
+    }
+  }
+
+  virtual bool IsLocal(uint32_t sid) const override { return server_threads_.find(sid) != server_threads_.end(); }
+
+  virtual void Serve(Message& msg) override { Find(msg.meta.recver)->ServeDirect(msg); }
+
+  virtual bool TryGet(Message& msg, Message* reply) override {
+    return Find(msg.meta.recver)->TryGetDirect(msg, reply);
+  }
+
+ private:
+  ServerThread* Find(uint32_t sid) const {
+    auto it = server_threads_.find(sid);
+    CHECK(it != server_threads_.end()) << "server thread " << sid << " is not on this node";
+    return it->second;
+  }
+
+  std::unordered_map<uint32_t, ServerThread*> server_threads_;
+};
+
+}  // namespace csci5570
@@ -1,89 +1,294 @@
 #pragma once
 
-#include <fstream>
 #include <string>
 #include "base/message.hpp"
 #include "hdfs/hdfs.h"
 #include "server/abstract_storage.hpp"
+#include "server/block_layout.hpp"
+#include "server/updater.hpp"
+#include "server/util/checkpoint.hpp"
+#include "server/util/feature_filter.hpp"
 
 #include "glog/logging.h"
 
+#include <algorithm>
 #include <map>
+#include <memory>
+#include <vector>
 
 namespace csci5570 {
 
+/*
+ * Storage for sparse tables, in two parts:
+ * - a frozen part: sorted keys in a flat array, whose blocks are the first ones of blocks_ in the same order
+ * - a delta: a std::map from the keys inserted since the last freeze to their blocks
+ * Until the first freeze every key is in the delta. Once few new keys arrive per clock the delta is merged into
+ * the frozen part, and then again each time it grows past 1/kDeltaRatio of the frozen part. The sorted keys of a
+ * request are then looked up in one galloping pass over the frozen keys, with near sequential memory accesses.
+ */
 template <typename Val>
 class MapStorage : public AbstractStorage {
  public:
-  MapStorage() = default;
+  static const size_t kDeltaRatio = 16;
+
+  MapStorage() : MapStorage(std::unique_ptr<AbstractUpdater<Val>>(new AssignUpdater<Val>())) {}
+  explicit MapStorage(std::unique_ptr<AbstractUpdater<Val>>&& updater, size_t dim = 1,
+                      Precision precision = Precision::Full, const FeatureConfig& feature_config = FeatureConfig())
+      : filter_(feature_config),
+        layout_(std::move(updater), dim, precision, filter_.Evicts()),
+        dim_(dim),
+        block_bytes_(layout_.BlockBytes()) {}
 
   virtual void SubAdd(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) override {
     auto typed_vals = third_party::SArray<Val>(vals);
-    CHECK_EQ(typed_keys.size(), typed_vals.size());
-    // TODO
-    // what if there are some same keys.
+    CHECK_EQ(typed_keys.size() * dim_, typed_vals.size());
+    size_t cursor = 0;
     for (int i = 0; i < typed_keys.size(); i++) {
-      storage_[typed_keys[i]] = typed_vals[i];
+      size_t index = Find(typed_keys[i], &cursor);
+      if (index == kNone) {
+        // the updates of a key are dropped until it is admitted
+        if (!filter_.Admit(typed_keys[i]))
+          continue;
+        index = Insert(typed_keys[i]);
+      }
+      if (!dirty_[index]) {
+        dirty_[index] = true;
+        dirty_keys_.push_back(typed_keys[i]);
+      }
+      char* block = &blocks_[index * block_bytes_];
+      if (filter_.Evicts())
+        filter_.Touch(layout_.Stats(block));
+      layout_.Update(block, &typed_vals[i * dim_]);
     }
   }
 
   virtual third_party::SArray<char> SubGet(const third_party::SArray<Key>& typed_keys) override {
-    third_party::SArray<Val> reply_vals(typed_keys.size());
-    // TODO
+    size_t row_bytes = layout_.RowBytes();
+    third_party::SArray<char> reply_vals(typed_keys.size() * row_bytes);
+    size_t cursor = 0;
     for (int i = 0; i < typed_keys.size(); i++) {
-      // what if there is some keys with null value;
-      reply_vals[i] = storage_.find(typed_keys[i])->second;
+      // keys never added are read as zero
+      size_t index = Find(typed_keys[i], &cursor);
+      if (index == kNone)
+        continue;
+      char* block = &blocks_[index * block_bytes_];
+      if (filter_.Evicts())
+        filter_.Touch(layout_.Stats(block));
+      layout_.CopyRow(block, &reply_vals[i * row_bytes]);
     }
-    // TODO done.
-    return third_party::SArray<char>(reply_vals);
+    return reply_vals;
   }
 
-  virtual void Backup(int model_id) override {
-    std::ofstream outfile;
-    std::string path = "/data/model" + std::to_string(model_id) + ".txt";
-    outfile.open(path);
-    for (auto iter = storage_.begin(); iter != storage_.end(); ++iter) {
-      std::ostringstream ss;
-      ss << iter->second;
-      auto value = ss.str();
-      outfile << iter->first << " " << value << "\n";
+  virtual std::function<void()> Snapshot(int model_id) override {
+    std::shared_ptr<KVSnapshot<Key, char>> snapshot(new KVSnapshot<Key, char>(block_bytes_));
+    bool full = schedule_.NextIsFull(dirty_keys_.size(), Size());
+    if (full) {
+      snapshot->keys.reserve(Size());
+      snapshot->vals.reserve(blocks_.size());
+      ForEachSorted([this, &snapshot](Key key, size_t index) { snapshot->Add(key, &blocks_[index * block_bytes_]); });
+    } else {
+      // only the keys changed since the last checkpoint
+      std::sort(dirty_keys_.begin(), dirty_keys_.end());
+      snapshot->keys.reserve(dirty_keys_.size());
+      snapshot->vals.reserve(dirty_keys_.size() * block_bytes_);
+      size_t cursor = 0;
+      for (Key key : dirty_keys_) {
+        snapshot->Add(key, &blocks_[Find(key, &cursor) * block_bytes_]);
+      }
     }
-    outfile.close();
+    std::fill(dirty_.begin(), dirty_.end(), false);
+    dirty_keys_.clear();
+    std::string path = schedule_.Next(CheckpointPath(model_id), full);
+    snapshot->epoch = schedule_.Epoch();
+    return [snapshot, path]() { snapshot->Write(path); };
   }
 
   virtual void Recovery(int model_id) override {
-    std::ifstream ifs;
-    std::string path = "/data/model" + std::to_string(model_id) + ".txt";
-    ifs.open(path, std::ifstream::in);
-    std::string s;
-    Key key;
-    Val value;
-    int count = 0;
-    while (ifs >> s) {
-      if (count % 2 == 0)
-        key = std::stoi(s);
-      else {
-        value = std::stof(s);
-        storage_[key] = value;
+    std::string path = CheckpointPath(model_id);
+    schedule_.Replay<char, Key>(path, block_bytes_, [this](const Key* keys, const char* blocks, int64_t num_keys,
+                                                           bool full) {
+      if (full && Size() == 0) {
+        // the keys are sorted, so they are restored frozen
+        frozen_keys_.assign(keys, keys + num_keys);
+        blocks_.assign(blocks, blocks + num_keys * block_bytes_);
+        block_keys_.assign(keys, keys + num_keys);
+        dirty_.assign(num_keys, false);
+      } else {
+        size_t cursor = 0;
+        for (int64_t i = 0; i < num_keys; i++) {
+          size_t index = Find(keys[i], &cursor);
+          if (index == kNone)
+            index = Insert(keys[i]);
+          std::copy_n(blocks + i * block_bytes_, block_bytes_, &blocks_[index * block_bytes_]);
+        }
+      }
+      if (filter_.Evicts()) {
+        size_t cursor = 0;
+        for (int64_t i = 0; i < num_keys; i++) {
+          filter_.Restore(*layout_.Stats(&blocks_[Find(keys[i], &cursor) * block_bytes_]));
+        }
+      }
+    });
+  }
+
+  // Evict the keys selected by the feature filter, and merge the delta when it is due
+  virtual void FinishIter() override {
+    if (filter_.Evicts()) {
+      filter_.Clock();
+      std::vector<Key> victims =
+          filter_.Evict(Size(), [this](const std::function<void(Key, KeyStats*)>& func) {
+            for (size_t index = 0; index < block_keys_.size(); index++) {
+              func(block_keys_[index], layout_.Stats(&blocks_[index * block_bytes_]));
+            }
+          });
+      if (!victims.empty()) {
+        schedule_.RequireFull();
+        if (frozen_keys_.empty()) {
+          for (Key key : victims) {
+            Erase(key);
+          }
+        } else {
+          // erasing from the frozen part would break its order, so merge without the victims instead
+          std::sort(victims.begin(), victims.end());
+          Merge(victims);
+        }
       }
-      count++;
     }
+    // warmed up once a clock inserts few new keys
+    bool warm = num_inserted_ * kDeltaRatio < Size();
+    num_inserted_ = 0;
+    if (!delta_.empty() && (warm || !frozen_keys_.empty()) && delta_.size() * kDeltaRatio > frozen_keys_.size())
+      Freeze();
+  }
 
-    // for (auto iter = storage_.begin(); iter != storage_.end(); iter++) {
-    //   std::cout << "key:" << iter->first << " value:" << iter->second << std::endl;
-    // }
-    ifs.close();
+  virtual std::unique_ptr<AbstractAggregator> CreateAggregator() override {
+    if (!layout_.IsLinear() || filter_.CountsAdds())
+      return nullptr;
+    return std::unique_ptr<AbstractAggregator>(new UpdateAggregator<Val>(dim_));
   }
 
-  // virtual void Backup(int model_id) {
-  //   auto hdfs = hdfsWrite("hdfs:///127.0.0.1");
-  //   hdfs
-  // }
+  /**
+   * Merge the delta into the frozen part
+   */
+  void Freeze() { Merge(std::vector<Key>()); }
 
-  virtual void FinishIter() override {}
+  size_t Size() const { return block_keys_.size(); }
+  // the keys in the frozen part
+  size_t FrozenSize() const { return frozen_keys_.size(); }
 
  private:
-  std::map<Key, Val> storage_;
+  static const size_t kNone = SIZE_MAX;
+
+  /**
+   * Return the index of the block of the key, or kNone if the key is absent.
+   * The frozen keys are searched by galloping from *cursor, where the search for the previous key stopped, so a
+   * sorted batch of keys is looked up in one pass.
+   */
+  size_t Find(Key key, size_t* cursor) const {
+    if (!frozen_keys_.empty()) {
+      // every frozen key before the cursor must be smaller than the key
+      if (*cursor > 0 && frozen_keys_[*cursor - 1] >= key)
+        *cursor = 0;
+      size_t lo = *cursor;
+      size_t hi = *cursor;
+      size_t step = 1;
+      while (hi < frozen_keys_.size() && frozen_keys_[hi] < key) {
+        lo = hi + 1;
+        hi = *cursor + step;
+        step *= 2;
+      }
+      hi = std::min(hi, frozen_keys_.size());
+      *cursor = std::lower_bound(frozen_keys_.begin() + lo, frozen_keys_.begin() + hi, key) - frozen_keys_.begin();
+      if (*cursor < frozen_keys_.size() && frozen_keys_[*cursor] == key)
+        return *cursor;
+    }
+    auto iter = delta_.find(key);
+    return iter == delta_.end() ? kNone : iter->second;
+  }
+
+  // Insert a zero block for an absent key into the delta and return its index
+  size_t Insert(Key key) {
+    size_t index = block_keys_.size();
+    delta_.insert(std::make_pair(key, index));
+    blocks_.resize(blocks_.size() + block_bytes_, 0);
+    block_keys_.push_back(key);
+    dirty_.push_back(false);
+    num_inserted_++;
+    return index;
+  }
+
+  // Remove a key when nothing is frozen, moving the last block into the place of its block
+  void Erase(Key key) {
+    auto iter = delta_.find(key);
+    size_t index = iter->second;
+    size_t last = block_keys_.size() - 1;
+    if (index != last) {
+      std::copy_n(&blocks_[last * block_bytes_], block_bytes_, &blocks_[index * block_bytes_]);
+      block_keys_[index] = block_keys_[last];
+      dirty_[index] = dirty_[last];
+      delta_[block_keys_[index]] = index;
+    }
+    delta_.erase(iter);
+    blocks_.resize(last * block_bytes_);
+    block_keys_.pop_back();
+    dirty_.pop_back();
+  }
+
+  // Invoke func(key, block index) on every key in key order, merging the frozen keys with the delta
+  template <typename Func>
+  void ForEachSorted(Func func) const {
+    size_t i = 0;
+    auto iter = delta_.begin();
+    while (i < frozen_keys_.size() || iter != delta_.end()) {
+      if (iter == delta_.end() || (i < frozen_keys_.size() && frozen_keys_[i] < iter->first)) {
+        func(frozen_keys_[i], i);
+        i++;
+      } else {
+        func(iter->first, iter->second);
+        ++iter;
+      }
+    }
+  }
+
+  // Rebuild the frozen part from all keys but the sorted victims, leaving the delta empty
+  void Merge(const std::vector<Key>& victims) {
+    std::vector<Key> keys;
+    std::vector<char> blocks;
+    std::vector<bool> dirty;
+    keys.reserve(Size());
+    blocks.reserve(blocks_.size());
+    dirty.reserve(Size());
+    ForEachSorted([this, &victims, &keys, &blocks, &dirty](Key key, size_t index) {
+      if (std::binary_search(victims.begin(), victims.end(), key))
+        return;
+      keys.push_back(key);
+      blocks.insert(blocks.end(), &blocks_[index * block_bytes_], &blocks_[(index + 1) * block_bytes_]);
+      dirty.push_back(dirty_[index]);
+    });
+    frozen_keys_ = keys;
+    block_keys_.swap(keys);
+    blocks_.swap(blocks);
+    dirty_.swap(dirty);
+    delta_.clear();
+  }
+
+  FeatureFilter filter_;
+  BlockLayout<Val> layout_;
+  size_t dim_;                     // number of weights per key
+  size_t block_bytes_;             // see BlockLayout
+  std::vector<Key> frozen_keys_;   // sorted, the block of frozen_keys_[i] is block i
+  std::map<Key, size_t> delta_;    // {key: block index} of the keys inserted since the last freeze
+  std::vector<char> blocks_;
+  std::vector<Key> block_keys_;    // {block index: key}
+  std::vector<bool> dirty_;        // {block index: changed since the last checkpoint}
+  std::vector<Key> dirty_keys_;    // the keys of the dirty blocks
+  size_t num_inserted_ = 0;        // the keys inserted since the last clock
+  CheckpointSchedule schedule_;
 };
 
+template <typename Val>
+const size_t MapStorage<Val>::kDeltaRatio;
+template <typename Val>
+const size_t MapStorage<Val>::kNone;
+
 }  // namespace csci5570
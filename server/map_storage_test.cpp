@@ -74,5 +74,215 @@ TEST_F(TestMapStorage, SubAddSubGet) {
   }
 }
 
+TEST_F(TestMapStorage, SubAddWithUpdater) {
+  UpdaterConfig config;
+  config.type = UpdaterType::SGD;
+  config.learning_rate = 0.5;
+  MapStorage<double> s(CreateUpdater<double>(config));
+
+  third_party::SArray<Key> s_keys({13, 14});
+  third_party::SArray<double> s_grads({1.0, -2.0});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  third_party::SArray<double> ret = third_party::SArray<double>(s.SubGet(s_keys));
+  EXPECT_DOUBLE_EQ(ret[0], -1.0);
+  EXPECT_DOUBLE_EQ(ret[1], 2.0);
+}
+
+TEST_F(TestMapStorage, Rows) {
+  UpdaterConfig config;
+  config.type = UpdaterType::Adagrad;
+  config.learning_rate = 1.0;
+  MapStorage<double> s(CreateUpdater<double>(config), 3);
+
+  third_party::SArray<Key> s_keys({13, 14});
+  third_party::SArray<double> s_grads({1.0, 2.0, 0.0, -1.0, 0.5, 4.0});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  third_party::SArray<double> ret = third_party::SArray<double>(s.SubGet(s_keys));
+  ASSERT_EQ(ret.size(), 6);
+  // the first adagrad step moves every non-zero gradient by the learning rate
+  std::vector<double> expected{-1.0, -1.0, 0.0, 1.0, -1.0, -1.0};
+  for (int i = 0; i < expected.size(); ++ i) {
+    EXPECT_NEAR(ret[i], expected[i], 1e-6);
+  }
+}
+
+TEST_F(TestMapStorage, AddGetBatch) {
+  MapStorage<int> s;
+
+  std::vector<Message> adds(3);
+  adds[0].AddData(third_party::SArray<Key>({15, 13}));
+  adds[0].AddData(third_party::SArray<int>({1, 2}));
+  adds[1].AddData(third_party::SArray<Key>({13}));
+  adds[1].AddData(third_party::SArray<int>({3}));
+  adds[2].AddData(third_party::SArray<Key>({14, 13}));
+  adds[2].AddData(third_party::SArray<int>({4, 5}));
+  EXPECT_EQ(s.AddBatch(adds).size(), 3);
+
+  std::vector<Message> gets(2);
+  gets[0].AddData(third_party::SArray<Key>({13, 16}));
+  gets[1].AddData(third_party::SArray<Key>({14, 15, 13}));
+  std::vector<Message> reps = s.GetBatch(gets);
+  ASSERT_EQ(reps.size(), 2);
+  // the last of the updates of a key is assigned, as if the Adds came one by one
+  std::vector<std::vector<Key>> expected_keys{{13, 16}, {14, 15, 13}};
+  std::vector<std::vector<int>> expected_vals{{5, 0}, {4, 1, 5}};
+  for (int i = 0; i < reps.size(); ++ i) {
+    ASSERT_EQ(reps[i].data.size(), 2);
+    auto rep_keys = third_party::SArray<Key>(reps[i].data[0]);
+    auto rep_vals = third_party::SArray<int>(reps[i].data[1]);
+    EXPECT_EQ(std::vector<Key>(rep_keys.begin(), rep_keys.end()), expected_keys[i]);
+    EXPECT_EQ(std::vector<int>(rep_vals.begin(), rep_vals.end()), expected_vals[i]);
+  }
+}
+
+TEST_F(TestMapStorage, HalfPrecision) {
+  UpdaterConfig config;
+  config.type = UpdaterType::SGD;
+  config.learning_rate = 1.0;
+  MapStorage<float> s(CreateUpdater<float>(config), 2, Precision::FP16);
+
+  third_party::SArray<Key> s_keys({13, 14});
+  third_party::SArray<float> s_grads({-1.5, 0.25, 2.0, -0.125});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  third_party::SArray<char> ret = s.SubGet(third_party::SArray<Key>({14, 15, 13}));
+  // the reply carries two bytes per value and zeros for a missing key
+  ASSERT_EQ(ret.size(), 3 * 2 * sizeof(uint16_t));
+  RowCodec<float> codec(Precision::FP16, 2);
+  std::vector<float> rows(6);
+  for (int i = 0; i < 3; ++ i) {
+    codec.Decode(ret.data() + i * codec.RowBytes(), &rows[i * 2]);
+  }
+  std::vector<float> expected{-4.0, 0.25, 0.0, 0.0, 3.0, -0.5};
+  EXPECT_EQ(rows, expected);
+}
+
+TEST_F(TestMapStorage, SmallUpdatesBFloat16) {
+  UpdaterConfig config;
+  config.type = UpdaterType::SGD;
+  config.learning_rate = 1.0;
+  MapStorage<float> s(CreateUpdater<float>(config), 1, Precision::BF16);
+
+  // each update is far below half a step of bfloat16 at 1, 2^-8, but they still add up
+  third_party::SArray<Key> s_keys({3});
+  s.SubAdd(s_keys, third_party::SArray<char>(third_party::SArray<float>({-1.0})));
+  for (int i = 0; i < 1000; ++ i) {
+    s.SubAdd(s_keys, third_party::SArray<char>(third_party::SArray<float>({-1e-4})));
+  }
+  third_party::SArray<char> ret = s.SubGet(s_keys);
+  RowCodec<float> codec(Precision::BF16, 1);
+  float val;
+  codec.Decode(ret.data(), &val);
+  EXPECT_NEAR(val, 1.1, 0.05);
+}
+
+TEST_F(TestMapStorage, EvictLeastFrequentlyUsed) {
+  const int model_id = 59;
+  FeatureConfig feature_config;
+  feature_config.max_keys = 2;
+  MapStorage<int> s(std::unique_ptr<AbstractUpdater<int>>(new AssignUpdater<int>()), 1, Precision::Full,
+                    feature_config);
+  third_party::SArray<Key> s_keys({1, 2, 3});
+  s.SubAdd(s_keys, third_party::SArray<char>(third_party::SArray<int>({10, 20, 30})));
+  s.Backup(model_id);
+  s.SubGet(third_party::SArray<Key>({1, 3}));
+  s.FinishIter();
+  EXPECT_EQ(s.Size(), 2);
+  third_party::SArray<int> ret = third_party::SArray<int>(s.SubGet(s_keys));
+  std::vector<int> expected{10, 0, 30};
+  EXPECT_EQ(std::vector<int>(ret.begin(), ret.end()), expected);
+
+  // the next checkpoint is full, so the evicted key is not restored
+  s.Backup(model_id);
+  MapStorage<int> recovered(std::unique_ptr<AbstractUpdater<int>>(new AssignUpdater<int>()), 1, Precision::Full,
+                            feature_config);
+  recovered.Recovery(model_id);
+  EXPECT_EQ(recovered.Size(), 2);
+  ret = third_party::SArray<int>(recovered.SubGet(s_keys));
+  EXPECT_EQ(std::vector<int>(ret.begin(), ret.end()), expected);
+}
+
+TEST_F(TestMapStorage, Freeze) {
+  MapStorage<int> s;
+  third_party::SArray<Key> s_keys;
+  third_party::SArray<int> s_vals;
+  for (Key key = 0; key < 100; key++) {
+    s_keys.push_back(key * 2);
+    s_vals.push_back(key);
+  }
+  s.SubAdd(s_keys, third_party::SArray<char>(s_vals));
+  s.FinishIter();  // still warming up
+  EXPECT_EQ(s.FrozenSize(), 0);
+  s.SubAdd(third_party::SArray<Key>({1}), third_party::SArray<char>(third_party::SArray<int>({-1})));
+  s.FinishIter();
+  EXPECT_EQ(s.FrozenSize(), 101);
+
+  // new keys go to the delta until it grows past 1/16 of the frozen keys
+  s.SubAdd(third_party::SArray<Key>({3, 1000}), third_party::SArray<char>(third_party::SArray<int>({-3, 7})));
+  s.FinishIter();
+  EXPECT_EQ(s.FrozenSize(), 101);
+  EXPECT_EQ(s.Size(), 103);
+
+  // sorted and unsorted batches, mixing frozen, delta and absent keys
+  std::vector<int> expected{0, -1, 1, -3, 7, 0, 50, 99};
+  third_party::SArray<int> ret =
+      third_party::SArray<int>(s.SubGet(third_party::SArray<Key>({0, 1, 2, 3, 1000, 1001, 100, 198})));
+  EXPECT_EQ(std::vector<int>(ret.begin(), ret.end()), expected);
+  ret = third_party::SArray<int>(s.SubGet(third_party::SArray<Key>({198, 2, 1000, 0})));
+  EXPECT_EQ(std::vector<int>(ret.begin(), ret.end()), (std::vector<int>{99, 1, 7, 0}));
+
+  s.Freeze();
+  EXPECT_EQ(s.FrozenSize(), 103);
+  ret = third_party::SArray<int>(s.SubGet(third_party::SArray<Key>({0, 1, 2, 3, 1000, 1001, 100, 198})));
+  EXPECT_EQ(std::vector<int>(ret.begin(), ret.end()), expected);
+}
+
+TEST_F(TestMapStorage, DeltaCheckpoint) {
+  const int model_id = 58;
+  std::string path = "/data/model" + std::to_string(model_id) + ".ckpt";
+  MapStorage<int> s;
+  third_party::SArray<Key> s_keys({1, 2, 3, 4, 5});
+  third_party::SArray<int> s_vals({10, 20, 30, 40, 50});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_vals));
+  s.Backup(model_id);  // full
+
+  s.SubAdd(third_party::SArray<Key>({2}), third_party::SArray<char>(third_party::SArray<int>({21})));
+  s.Backup(model_id);  // delta with key 2 only
+  s.SubAdd(third_party::SArray<Key>({6}), third_party::SArray<char>(third_party::SArray<int>({60})));
+  s.Backup(model_id);  // delta with key 6 only
+  {
+    CheckpointReader reader(CheckpointSchedule::DeltaPath(path, 1));
+    const Key* keys;
+    const char* blocks;
+    ASSERT_EQ(ReadKVCheckpoint(&reader, 8, &keys, &blocks), 1);  // a block holds an int padded to 8 bytes
+    EXPECT_EQ(keys[0], 2);
+    EXPECT_EQ(*reinterpret_cast<const int*>(blocks), 21);
+  }
+
+  MapStorage<int> recovered;
+  recovered.Recovery(model_id);
+  third_party::SArray<Key> all_keys({1, 2, 3, 4, 5, 6});
+  third_party::SArray<int> ret = third_party::SArray<int>(recovered.SubGet(all_keys));
+  std::vector<int> expected{10, 21, 30, 40, 50, 60};
+  for (int i = 0; i < expected.size(); ++ i) {
+    EXPECT_EQ(ret[i], expected[i]);
+  }
+
+  // the recovered storage continues with delta3, ..., delta9, then a full checkpoint and its delta1
+  for (int i = 0; i < CheckpointSchedule::kMaxDeltas; i++) {
+    recovered.Backup(model_id);
+  }
+  recovered.SubAdd(third_party::SArray<Key>({1}), third_party::SArray<char>(third_party::SArray<int>({11})));
+  recovered.Backup(model_id);  // delta2 of the new full checkpoint; delta3 and later on disk are stale
+  MapStorage<int> recovered_again;
+  recovered_again.Recovery(model_id);
+  ret = third_party::SArray<int>(recovered_again.SubGet(all_keys));
+  expected = {11, 21, 30, 40, 50, 60};
+  for (int i = 0; i < expected.size(); ++ i) {
+    EXPECT_EQ(ret[i], expected[i]);
+  }
+}
+
 }  // namespace
 }  // namespace csci5570
@@ -1,5 +1,9 @@
 #include "server/server_thread.hpp"
 
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
 #include "glog/logging.h"
 #include "base/message.hpp"
 #include "base/threadsafe_queue.hpp"
@@ -8,6 +12,7 @@ namespace csci5570 {
     
 void ServerThread::RegisterModel(uint32_t model_id, std::unique_ptr<AbstractModel>&& model) {
     //insert the model if model_id not exist, assign new model if model_id exist
+    std::lock_guard<std::mutex> lock(mu_);
     models_.insert(std::make_pair(model_id, std::move(model)));
 }
     
@@ -23,23 +28,71 @@ AbstractModel* ServerThread::GetModel(uint32_t model_id) {
     }
 }
     
+void ServerThread::ServeDirect(Message& msg) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto* ptr = GetModel(msg.meta.model_id);
+    if (ptr == nullptr) {
+        return;
+    }
+    switch (msg.meta.flag) {
+        case Flag::kResetWorkerInModel:
+            ptr->ResetWorker(msg);
+            break;
+        case Flag::kClock:
+            ptr->Clock(msg);
+            break;
+        case Flag::kAdd:
+        case Flag::kPush:
+            ptr->Add(msg);
+            break;
+        default:
+            LOG(FATAL) << "cannot serve " << FlagName[static_cast<int>(msg.meta.flag)] << " directly";
+    }
+}
+
+bool ServerThread::TryGetDirect(Message& msg, Message* reply) {
+    std::lock_guard<std::mutex> lock(mu_);
+    auto* ptr = GetModel(msg.meta.model_id);
+    return ptr != nullptr && ptr->TryGet(msg, reply);
+}
+
 void ServerThread::Main() {
-    //We might have to know which model need to process.
     auto* work_queue = this->GetWorkQueue();
+    std::vector<Message> batch;
     while (true) {
-        Message m;
-        work_queue->WaitAndPop(&m);
-        int id = m.meta.model_id;
-        if(m.meta.flag == Flag::kExit){
-          return;
+        // drain everything queued, so the Adds and Gets piling up under load are served together, the control
+        // messages and the Gets of each model first as the work queue pops them by urgency
+        batch.clear();
+        work_queue->WaitAndPopAll(&batch);
+        // the messages after an exit are dropped
+        auto exit = std::find_if(batch.begin(), batch.end(),
+                                 [](const Message& m) { return m.meta.flag == Flag::kExit; });
+        // group the messages by model, keeping the order of the messages of each model
+        std::stable_sort(batch.begin(), exit,
+                         [](const Message& a, const Message& b) { return a.meta.model_id < b.meta.model_id; });
+        for (auto begin = batch.begin(); begin != exit;) {
+            auto end = std::find_if(begin, exit,
+                                    [begin](const Message& m) { return m.meta.model_id != begin->meta.model_id; });
+            {
+                std::lock_guard<std::mutex> lock(mu_);
+                auto* ptr = GetModel(begin->meta.model_id);
+                if (ptr != nullptr) {
+                    Serve(ptr, begin, end);
+                }
+            }
+            begin = end;
         }
-        auto* ptr = GetModel(id);
-        if(ptr == nullptr){
-          continue;
+        if (exit != batch.end()) {
+            return;
         }
+    }
+}
+
+void ServerThread::Serve(AbstractModel* ptr, std::vector<Message>::iterator begin, std::vector<Message>::iterator end) {
+    std::vector<Message> run;
+    while (begin != end) {
+        Message& m = *begin;
         switch (m.meta.flag) {
-            case Flag::kExit:
-                return;
             case Flag::kBarrier:
                 break;
             case Flag::kResetWorkerInModel:
@@ -48,16 +101,35 @@ void ServerThread::Main() {
             case Flag::kClock:
                 ptr->Clock(m);
                 break;
-            case Flag::kAdd:
-                ptr->Add(m);
-                break;
-            case Flag::kGet:
-                ptr->Get(m);
+            case Flag::kReplicate:
+            case Flag::kGetReplica:
+                ptr->Replicate(m);
                 break;
+            case Flag::kAdd:
+            case Flag::kPush:
+            case Flag::kGet: {
+                // consecutive Adds and Pushes, or consecutive Gets, are served as one run
+                bool is_get = m.meta.flag == Flag::kGet;
+                auto run_end = std::find_if(begin, end, [is_get](const Message& next) {
+                    bool next_is_get = next.meta.flag == Flag::kGet;
+                    bool next_is_add = next.meta.flag == Flag::kAdd || next.meta.flag == Flag::kPush;
+                    return is_get ? !next_is_get : !next_is_add;
+                });
+                run.assign(std::make_move_iterator(begin), std::make_move_iterator(run_end));
+                if (is_get) {
+                    ptr->GetBatch(run);
+                } else {
+                    ptr->AddBatch(run);
+                }
+                begin = run_end;
+                continue;
+            }
             default:
                 //error, no such message flags;
                 break;
         }
+        ++begin;
     }
 }
+
 }  // namespace csci5570
@@ -1,26 +1,41 @@
 #pragma once
 
 #include "base/actor_model.hpp"
+#include "base/priority_message_queue.hpp"
 #include "base/threadsafe_queue.hpp"
 #include "server/abstract_model.hpp"
 
+#include <mutex>
 #include <thread>
 #include <unordered_map>
+#include <vector>
 
 namespace csci5570 {
 
 class ServerThread : public Actor {
  public:
-  ServerThread(uint32_t server_id) : Actor(server_id) {}
+  /**
+   * @param server_id   the server thread id
+   * @param max_age     see PriorityMessageQueue, which orders the work queue
+   */
+  ServerThread(uint32_t server_id, uint64_t max_age = PriorityMessageQueue::kDefaultMaxAge)
+      : Actor(server_id, std::unique_ptr<ThreadsafeQueue<Message>>(new PriorityMessageQueue(max_age))) {}
   
   // for model maintenance
   void RegisterModel(uint32_t model_id, std::unique_ptr<AbstractModel>&& model);
   AbstractModel* GetModel(uint32_t model_id);
 
+  // for the workers on this node, which are served on their own threads, see AbstractLocalServers
+  void ServeDirect(Message& msg);
+  bool TryGetDirect(Message& msg, Message* reply);
+
  protected:
   virtual void Main() override;                                  // where the actor polls events and reacts
+  // serve the messages of a model in order, coalescing consecutive Adds and consecutive Gets into batches
+  void Serve(AbstractModel* ptr, std::vector<Message>::iterator begin, std::vector<Message>::iterator end);
 
   std::unordered_map<uint32_t, std::unique_ptr<AbstractModel>> models_;
+  std::mutex mu_;  // serializes the models between the server thread and the workers calling directly
 };
 
 }  // namespace csci5570
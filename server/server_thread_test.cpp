@@ -2,7 +2,10 @@
 #include "gtest/gtest.h"
 
 #include "base/magic.hpp"
+#include "base/threadsafe_queue.hpp"
 #include "server/abstract_model.hpp"
+#include "server/consistency/ssp_model.hpp"
+#include "server/map_storage.hpp"
 #include "server/server_thread.hpp"
 
 namespace csci5570 {
@@ -23,14 +26,31 @@ class FakeModel : public AbstractModel {
   virtual void Clock(Message&) override { clock_count_ += 1; }
   virtual void Add(Message&) override { add_count_ += 1; }
   virtual void Get(Message&) override { get_count_ += 1; }
+  virtual bool TryGet(Message&, Message* reply) override {
+    try_get_count_ += 1;
+    return try_get_count_ % 2 == 1;
+  }
   virtual int GetProgress(int tid) override { return -1; }
   virtual void ResetWorker(Message& msg) override {}
   virtual void Backup() {}
   virtual int Recovery() {}
+  virtual void SetCheckpointPrefix(const std::string&) override {}
+  virtual void SetReplicator(std::unique_ptr<Replicator>&&) override {}
+  virtual void Replicate(Message&) override {}
 
   int clock_count_ = 0;
   int add_count_ = 0;
   int get_count_ = 0;
+  int try_get_count_ = 0;
+};
+
+class BatchingFakeModel : public FakeModel {
+ public:
+  virtual void AddBatch(std::vector<Message>& msgs) override { add_batches_.push_back(msgs.size()); }
+  virtual void GetBatch(std::vector<Message>& msgs) override { get_batches_.push_back(msgs.size()); }
+
+  std::vector<int> add_batches_;
+  std::vector<int> get_batches_;
 };
 
 TEST_F(TestServerThread, Construct) { ServerThread server_thread(0); }
@@ -115,5 +135,111 @@ TEST_F(TestServerThread, Get) {
   EXPECT_EQ(p->get_count_, 3);
 }
 
+TEST_F(TestServerThread, CoalesceAddsAndGets) {
+  ServerThread server_thread(0);
+  server_thread.RegisterModel(0, std::unique_ptr<AbstractModel>(new BatchingFakeModel()));
+  server_thread.RegisterModel(1, std::unique_ptr<AbstractModel>(new BatchingFakeModel()));
+  auto* p0 = static_cast<BatchingFakeModel*>(server_thread.GetModel(0));
+  auto* p1 = static_cast<BatchingFakeModel*>(server_thread.GetModel(1));
+
+  // queued before the thread starts, so they are drained as one batch
+  auto* work_queue = server_thread.GetWorkQueue();
+  std::vector<std::pair<uint32_t, Flag>> msgs{{0, Flag::kAdd},   {1, Flag::kGet},  {0, Flag::kPush}, {0, Flag::kClock},
+                                              {0, Flag::kGet},   {1, Flag::kGet},  {0, Flag::kGet},  {0, Flag::kAdd},
+                                              {0, Flag::kExit},  {0, Flag::kAdd}};
+  for (const auto& msg : msgs) {
+    Message m;
+    m.meta.model_id = msg.first;
+    m.meta.flag = msg.second;
+    work_queue->Push(m);
+  }
+  server_thread.Start();
+  server_thread.Stop();
+
+  // the runs of a model are cut by its clocks and by the other flag, and the messages after the exit are dropped
+  EXPECT_EQ(p0->add_batches_, std::vector<int>({2, 1}));
+  EXPECT_EQ(p0->get_batches_, std::vector<int>({2}));
+  EXPECT_EQ(p0->clock_count_, 1);
+  EXPECT_EQ(p1->get_batches_, std::vector<int>({2}));
+}
+
+TEST_F(TestServerThread, ServeDirect) {
+  ServerThread server_thread(0);
+  std::unique_ptr<AbstractModel> model(new FakeModel());
+  const uint32_t model_id = 0;
+  server_thread.RegisterModel(model_id, std::move(model));
+  auto* p = static_cast<FakeModel*>(server_thread.GetModel(model_id));
+  server_thread.Start();
+
+  // served on the calling thread while the server thread serves its queue
+  Message m;
+  m.meta.model_id = model_id;
+  m.meta.flag = Flag::kClock;
+  server_thread.ServeDirect(m);
+  m.meta.flag = Flag::kPush;
+  server_thread.ServeDirect(m);
+  server_thread.ServeDirect(m);
+  m.meta.flag = Flag::kGet;
+  Message reply;
+  EXPECT_TRUE(server_thread.TryGetDirect(m, &reply));
+  EXPECT_FALSE(server_thread.TryGetDirect(m, &reply));
+  m.meta.model_id = model_id + 1;
+  EXPECT_FALSE(server_thread.TryGetDirect(m, &reply));
+
+  Message exit_msg;
+  exit_msg.meta.flag = Flag::kExit;
+  server_thread.GetWorkQueue()->Push(exit_msg);
+  server_thread.Stop();
+
+  EXPECT_EQ(p->clock_count_, 1);
+  EXPECT_EQ(p->add_count_, 2);
+  EXPECT_EQ(p->try_get_count_, 2);
+  EXPECT_EQ(p->get_count_, 0);
+}
+
+TEST_F(TestServerThread, ResetDirectBeforeClock) {
+  ThreadsafeQueue<Message> reply_queue;
+  ServerThread server_thread(0);
+  const uint32_t model_id = 0;
+  std::unique_ptr<AbstractStorage> storage(new MapStorage<int>());
+  std::unique_ptr<AbstractModel> model(new SSPModel(model_id, std::move(storage), 0, &reply_queue));
+  server_thread.RegisterModel(model_id, std::move(model));
+  auto* p = server_thread.GetModel(model_id);
+
+  // the reset is served on the calling thread, so the worker's first direct Add and Clock are valid
+  Message reset_msg;
+  reset_msg.meta.flag = Flag::kResetWorkerInModel;
+  reset_msg.meta.model_id = model_id;
+  reset_msg.AddData(third_party::SArray<uint32_t>({2}));
+  server_thread.ServeDirect(reset_msg);
+  EXPECT_EQ(reply_queue.Size(), 1);
+  EXPECT_EQ(p->GetProgress(2), 0);
+
+  Message add_msg;
+  add_msg.meta.flag = Flag::kPush;
+  add_msg.meta.model_id = model_id;
+  add_msg.meta.sender = 2;
+  add_msg.AddData(third_party::SArray<int>({0}));
+  add_msg.AddData(third_party::SArray<int>({3}));
+  server_thread.ServeDirect(add_msg);
+  Message clock_msg;
+  clock_msg.meta.flag = Flag::kClock;
+  clock_msg.meta.model_id = model_id;
+  clock_msg.meta.sender = 2;
+  server_thread.ServeDirect(clock_msg);
+  EXPECT_EQ(p->GetProgress(2), 1);
+
+  Message get_msg;
+  get_msg.meta.flag = Flag::kGet;
+  get_msg.meta.model_id = model_id;
+  get_msg.meta.sender = 2;
+  get_msg.AddData(third_party::SArray<int>({0}));
+  Message reply;
+  ASSERT_TRUE(server_thread.TryGetDirect(get_msg, &reply));
+  third_party::SArray<int> vals(reply.data[1]);
+  ASSERT_EQ(vals.size(), 1);
+  EXPECT_EQ(vals[0], 3);
+}
+
 }  // namespace
 }  // namespace csci5570
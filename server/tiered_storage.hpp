@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+#include "base/message.hpp"
+#include "server/abstract_storage.hpp"
+#include "server/block_layout.hpp"
+#include "server/updater.hpp"
+#include "server/util/block_log.hpp"
+#include "server/util/checkpoint.hpp"
+#include "server/util/flat_hash_map.hpp"
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+/*
+ * Storage for tables larger than the memory of a server, in two tiers:
+ * - up to max_hot_keys blocks in memory, in least recently used order
+ * - every other block in a BlockLog on the local disk
+ * A block evicted from memory is appended to the log only if it changed since it was read from the log.
+ *
+ * A Get missing keys in memory first asks the kernel to read all of their blocks in the background, and only then
+ * faults them in one by one, so the reads of a request overlap.
+ */
+template <typename Val>
+class TieredStorage : public AbstractStorage {
+ public:
+  /**
+   * @param updater         how incoming values are applied
+   * @param dim             the number of weights per key
+   * @param precision       how the values are kept and sent in Get replies
+   * @param max_hot_keys    the blocks kept in memory
+   * @param log_path        the file of the blocks on disk
+   */
+  TieredStorage(std::unique_ptr<AbstractUpdater<Val>>&& updater, size_t dim, Precision precision, size_t max_hot_keys,
+                const std::string& log_path)
+      : layout_(std::move(updater), dim, precision),
+        dim_(dim),
+        block_bytes_(layout_.BlockBytes()),
+        max_hot_keys_(max_hot_keys),
+        log_(log_path, block_bytes_) {
+    CHECK_GT(max_hot_keys_, 0);
+  }
+
+  virtual void SubAdd(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) override {
+    auto typed_vals = third_party::SArray<Val>(vals);
+    CHECK_EQ(typed_keys.size() * dim_, typed_vals.size());
+    for (int i = 0; i < typed_keys.size(); i++) {
+      uint32_t slot = FindOrFaultIn(typed_keys[i], true);
+      dirty_[slot] = true;
+      layout_.Update(&blocks_[slot * block_bytes_], &typed_vals[i * dim_]);
+    }
+  }
+
+  virtual third_party::SArray<char> SubGet(const third_party::SArray<Key>& typed_keys) override {
+    std::vector<Key> cold_keys;
+    for (int i = 0; i < typed_keys.size(); i++) {
+      if (slots_.Find(typed_keys[i]) == nullptr && log_.Contains(typed_keys[i]))
+        cold_keys.push_back(typed_keys[i]);
+    }
+    if (!cold_keys.empty())
+      log_.Prefetch(cold_keys);
+
+    size_t row_bytes = layout_.RowBytes();
+    third_party::SArray<char> reply_vals(typed_keys.size() * row_bytes);
+    for (int i = 0; i < typed_keys.size(); i++) {
+      // keys never added are read as zero
+      uint32_t slot = FindOrFaultIn(typed_keys[i], false);
+      if (slot != kNone)
+        layout_.CopyRow(&blocks_[slot * block_bytes_], &reply_vals[i * row_bytes]);
+    }
+    return reply_vals;
+  }
+
+  virtual std::function<void()> Snapshot(int model_id) override {
+    // write the changed blocks back, so the log holds every key
+    for (uint32_t slot = 0; slot < slot_keys_.size(); slot++) {
+      if (dirty_[slot]) {
+        log_.Append(slot_keys_[slot], &blocks_[slot * block_bytes_]);
+        dirty_[slot] = false;
+      }
+    }
+    // the blocks are read from the log by the task, so only the keys are copied here
+    std::shared_ptr<BlockLogView> view = log_.View();
+    std::string path = schedule_.Next(CheckpointPath(model_id), true);
+    uint64_t epoch = schedule_.Epoch();
+    size_t block_bytes = block_bytes_;
+    return [view, path, epoch, block_bytes]() {
+      WriteKVCheckpoint<char>(path, view->keys, block_bytes, [&view](size_t i) { return view->Read(i); }, epoch);
+    };
+  }
+
+  virtual void Recovery(int model_id) override {
+    std::string path = CheckpointPath(model_id);
+    schedule_.Replay<char, Key>(path, block_bytes_, [this](const Key* keys, const char* blocks, int64_t num_keys,
+                                                           bool full) {
+      for (int64_t i = 0; i < num_keys; i++) {
+        const uint32_t* slot = slots_.Find(keys[i]);
+        if (slot != nullptr) {
+          std::copy_n(blocks + i * block_bytes_, block_bytes_, &blocks_[*slot * block_bytes_]);
+          dirty_[*slot] = true;
+        } else {
+          log_.Append(keys[i], blocks + i * block_bytes_);
+        }
+      }
+    });
+  }
+
+  virtual void FinishIter() override {}
+
+  virtual std::unique_ptr<AbstractAggregator> CreateAggregator() override {
+    if (!layout_.IsLinear())
+      return nullptr;
+    return std::unique_ptr<AbstractAggregator>(new UpdateAggregator<Val>(dim_));
+  }
+
+  // the keys in memory
+  size_t HotSize() const { return slots_.Size(); }
+  // the keys on disk, some of which may be in memory as well
+  size_t ColdSize() const { return log_.Size(); }
+
+ private:
+  static const uint32_t kNone = UINT32_MAX;
+
+  // Return the slot of the key in memory, reading its block from the log or, if insert, creating a zero block
+  // when it is not in memory. Return kNone if the key is absent and not to be inserted.
+  uint32_t FindOrFaultIn(Key key, bool insert) {
+    const uint32_t* found = slots_.Find(key);
+    if (found != nullptr) {
+      MoveToFront(*found);
+      return *found;
+    }
+    if (!insert && !log_.Contains(key))
+      return kNone;
+    uint32_t slot = AllocateSlot();
+    char* block = &blocks_[slot * block_bytes_];
+    if (log_.Read(key, block)) {
+      dirty_[slot] = false;
+    } else {
+      std::fill(block, block + block_bytes_, 0);
+      dirty_[slot] = true;
+    }
+    slot_keys_[slot] = key;
+    *slots_.FindOrInsert(key) = slot;
+    PushFront(slot);
+    return slot;
+  }
+
+  // Return a free slot, evicting the least recently used block if memory is full
+  uint32_t AllocateSlot() {
+    if (slot_keys_.size() < max_hot_keys_) {
+      slot_keys_.push_back(0);
+      blocks_.resize(blocks_.size() + block_bytes_);
+      dirty_.push_back(false);
+      prev_.push_back(kNone);
+      next_.push_back(kNone);
+      return slot_keys_.size() - 1;
+    }
+    uint32_t slot = tail_;
+    Unlink(slot);
+    if (dirty_[slot])
+      log_.Append(slot_keys_[slot], &blocks_[slot * block_bytes_]);
+    slots_.Erase(slot_keys_[slot]);
+    return slot;
+  }
+
+  void MoveToFront(uint32_t slot) {
+    if (slot == head_)
+      return;
+    Unlink(slot);
+    PushFront(slot);
+  }
+
+  void PushFront(uint32_t slot) {
+    prev_[slot] = kNone;
+    next_[slot] = head_;
+    if (head_ != kNone)
+      prev_[head_] = slot;
+    head_ = slot;
+    if (tail_ == kNone)
+      tail_ = slot;
+  }
+
+  void Unlink(uint32_t slot) {
+    if (prev_[slot] != kNone)
+      next_[prev_[slot]] = next_[slot];
+    else
+      head_ = next_[slot];
+    if (next_[slot] != kNone)
+      prev_[next_[slot]] = prev_[slot];
+    else
+      tail_ = prev_[slot];
+  }
+
+  BlockLayout<Val> layout_;
+  size_t dim_;          // number of weights per key
+  size_t block_bytes_;  // see BlockLayout
+  size_t max_hot_keys_;
+
+  // the memory tier: blocks in slots, linked from the most to the least recently used
+  FlatHashMap<Key, uint32_t> slots_;  // {key: slot}
+  std::vector<char> blocks_;          // the block of slot i starts at i * block_bytes_
+  std::vector<Key> slot_keys_;
+  std::vector<bool> dirty_;           // {slot: changed since read from the log}
+  std::vector<uint32_t> prev_;
+  std::vector<uint32_t> next_;
+  uint32_t head_ = kNone;
+  uint32_t tail_ = kNone;
+
+  BlockLog log_;  // the disk tier
+  CheckpointSchedule schedule_;
+};
+
+template <typename Val>
+const uint32_t TieredStorage<Val>::kNone;
+
+}  // namespace csci5570
@@ -0,0 +1,74 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/tiered_storage.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestTieredStorage : public testing::Test {
+ public:
+  TestTieredStorage() {}
+  ~TestTieredStorage() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+
+  std::unique_ptr<AbstractUpdater<double>> SGD() {
+    UpdaterConfig config;
+    config.type = UpdaterType::SGD;
+    config.learning_rate = 1.0;
+    return CreateUpdater<double>(config);
+  }
+};
+
+TEST_F(TestTieredStorage, SpillAndFaultIn) {
+  TieredStorage<double> s(SGD(), 2, Precision::Full, 2, "/tmp/csci5570_tiered_test.blocks");
+
+  third_party::SArray<Key> s_keys({1, 2, 3, 4, 5});
+  third_party::SArray<double> s_grads({1, 2, 3, 4, 5, 6, 7, 8, 9, 10});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+  EXPECT_EQ(s.HotSize(), 2);
+  EXPECT_EQ(s.ColdSize(), 5);
+
+  third_party::SArray<double> ret =
+      third_party::SArray<double>(s.SubGet(third_party::SArray<Key>({5, 6, 1, 3})));
+  std::vector<double> expected{-18, -20, 0, 0, -2, -4, -10, -12};
+  EXPECT_EQ(std::vector<double>(ret.begin(), ret.end()), expected);
+  // a key never added is not brought into memory
+  EXPECT_EQ(s.HotSize(), 2);
+  EXPECT_EQ(s.ColdSize(), 5);
+}
+
+TEST_F(TestTieredStorage, Checkpoint) {
+  const int model_id = 60;
+  std::vector<double> expected;
+  {
+    TieredStorage<double> s(SGD(), 1, Precision::Full, 3, "/tmp/csci5570_tiered_test.blocks");
+    third_party::SArray<Key> s_keys;
+    third_party::SArray<double> s_grads;
+    for (Key key = 0; key < 100; key++) {
+      s_keys.push_back(key * 3);
+      s_grads.push_back(key);
+      expected.push_back(-static_cast<double>(key));
+    }
+    s.SubAdd(s_keys, third_party::SArray<char>(s_grads));
+    s.Backup(model_id);
+  }
+  TieredStorage<double> recovered(SGD(), 1, Precision::Full, 3, "/tmp/csci5570_tiered_test.blocks");
+  recovered.Recovery(model_id);
+  EXPECT_EQ(recovered.ColdSize(), 100);
+  third_party::SArray<Key> s_keys;
+  for (Key key = 0; key < 100; key++) {
+    s_keys.push_back(key * 3);
+  }
+  third_party::SArray<double> ret = third_party::SArray<double>(recovered.SubGet(s_keys));
+  EXPECT_EQ(std::vector<double>(ret.begin(), ret.end()), expected);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,172 @@
+#pragma once
+
+#include <cmath>
+#include <memory>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+enum class UpdaterType { Assign, SGD, Adagrad, Adam, FTRL };
+
+/*
+ * The hyper-parameters of the updater of a table. Each updater only reads the fields it needs.
+ */
+struct UpdaterConfig {
+  UpdaterType type = UpdaterType::Assign;
+  double learning_rate = 0.01;  // SGD, Adagrad, Adam, and the alpha of FTRL
+  double beta1 = 0.9;           // Adam
+  double beta2 = 0.999;         // Adam
+  double epsilon = 1e-8;        // Adagrad, Adam
+  double ftrl_beta = 1.0;       // FTRL
+  double l1 = 0.0;              // FTRL
+  double l2 = 0.0;              // FTRL
+};
+
+/*
+ * An updater applies the values pushed by workers to the parameters in a storage.
+ * The storage keeps GetStateSize() optimizer states next to each weight and hands both to Update.
+ */
+template <typename Val>
+class AbstractUpdater {
+ public:
+  virtual ~AbstractUpdater() {}
+  /**
+   * Return the number of optimizer states kept per weight
+   */
+  virtual size_t GetStateSize() const = 0;
+  /**
+   * Apply an incoming value to a weight
+   *
+   * @param weight    the weight to update
+   * @param state     the GetStateSize() optimizer states of the weight
+   * @param val       the incoming value, a gradient for all updaters but Assign
+   */
+  virtual void Update(Val* weight, Val* state, Val val) = 0;
+  /**
+   * Return whether applying the sum of some values equals applying them one by one, so the updates of a clock
+   * can be summed before reaching the storage
+   */
+  virtual bool IsLinear() const { return false; }
+};
+
+/*
+ * Overwrite the weight with the incoming value
+ */
+template <typename Val>
+class AssignUpdater : public AbstractUpdater<Val> {
+ public:
+  virtual size_t GetStateSize() const override { return 0; }
+  virtual void Update(Val* weight, Val* state, Val val) override { *weight = val; }
+};
+
+template <typename Val>
+class SGDUpdater : public AbstractUpdater<Val> {
+ public:
+  explicit SGDUpdater(const UpdaterConfig& config) : lr_(config.learning_rate) {}
+  virtual size_t GetStateSize() const override { return 0; }
+  virtual void Update(Val* weight, Val* state, Val grad) override { *weight -= lr_ * grad; }
+  virtual bool IsLinear() const override { return true; }
+
+ private:
+  double lr_;
+};
+
+/*
+ * state: [sum of squared gradients]
+ */
+template <typename Val>
+class AdagradUpdater : public AbstractUpdater<Val> {
+ public:
+  explicit AdagradUpdater(const UpdaterConfig& config) : lr_(config.learning_rate), eps_(config.epsilon) {}
+  virtual size_t GetStateSize() const override { return 1; }
+  virtual void Update(Val* weight, Val* state, Val grad) override {
+    state[0] += grad * grad;
+    *weight -= lr_ * grad / (std::sqrt(state[0]) + eps_);
+  }
+
+ private:
+  double lr_;
+  double eps_;
+};
+
+/*
+ * state: [first moment, second moment, number of updates]
+ */
+template <typename Val>
+class AdamUpdater : public AbstractUpdater<Val> {
+ public:
+  explicit AdamUpdater(const UpdaterConfig& config)
+      : lr_(config.learning_rate), beta1_(config.beta1), beta2_(config.beta2), eps_(config.epsilon) {}
+  virtual size_t GetStateSize() const override { return 3; }
+  virtual void Update(Val* weight, Val* state, Val grad) override {
+    state[2] += 1;
+    state[0] = beta1_ * state[0] + (1 - beta1_) * grad;
+    state[1] = beta2_ * state[1] + (1 - beta2_) * grad * grad;
+    double m_hat = state[0] / (1 - std::pow(beta1_, state[2]));
+    double v_hat = state[1] / (1 - std::pow(beta2_, state[2]));
+    *weight -= lr_ * m_hat / (std::sqrt(v_hat) + eps_);
+  }
+
+ private:
+  double lr_;
+  double beta1_;
+  double beta2_;
+  double eps_;
+};
+
+/*
+ * FTRL-Proximal (McMahan et al., 2013)
+ * state: [z, n]
+ */
+template <typename Val>
+class FTRLUpdater : public AbstractUpdater<Val> {
+ public:
+  explicit FTRLUpdater(const UpdaterConfig& config)
+      : alpha_(config.learning_rate), beta_(config.ftrl_beta), l1_(config.l1), l2_(config.l2) {}
+  virtual size_t GetStateSize() const override { return 2; }
+  virtual void Update(Val* weight, Val* state, Val grad) override {
+    double n = state[1];
+    double sigma = (std::sqrt(n + grad * grad) - std::sqrt(n)) / alpha_;
+    state[0] += grad - sigma * *weight;
+    state[1] += grad * grad;
+    double z = state[0];
+    if (std::abs(z) <= l1_) {
+      *weight = 0;
+    } else {
+      double sign = z < 0 ? -1 : 1;
+      *weight = -(z - sign * l1_) / ((beta_ + std::sqrt(state[1])) / alpha_ + l2_);
+    }
+  }
+
+ private:
+  double alpha_;
+  double beta_;
+  double l1_;
+  double l2_;
+};
+
+template <typename Val>
+std::unique_ptr<AbstractUpdater<Val>> CreateUpdater(const UpdaterConfig& config) {
+  std::unique_ptr<AbstractUpdater<Val>> updater;
+  switch (config.type) {
+  case UpdaterType::SGD:
+    updater.reset(new SGDUpdater<Val>(config));
+    break;
+  case UpdaterType::Adagrad:
+    updater.reset(new AdagradUpdater<Val>(config));
+    break;
+  case UpdaterType::Adam:
+    updater.reset(new AdamUpdater<Val>(config));
+    break;
+  case UpdaterType::FTRL:
+    updater.reset(new FTRLUpdater<Val>(config));
+    break;
+  case UpdaterType::Assign:
+  default:
+    updater.reset(new AssignUpdater<Val>());
+  }
+  return updater;
+}
+
+}  // namespace csci5570
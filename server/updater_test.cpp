@@ -0,0 +1,91 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/updater.hpp"
+
+#include <cmath>
+
+namespace csci5570 {
+namespace {
+
+class TestUpdater : public testing::Test {
+ public:
+  TestUpdater() {}
+  ~TestUpdater() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestUpdater, Assign) {
+  auto updater = CreateUpdater<double>(UpdaterConfig());
+  EXPECT_EQ(updater->GetStateSize(), 0);
+  double weight = 1.0;
+  updater->Update(&weight, nullptr, 0.5);
+  EXPECT_DOUBLE_EQ(weight, 0.5);
+}
+
+TEST_F(TestUpdater, SGD) {
+  UpdaterConfig config;
+  config.type = UpdaterType::SGD;
+  config.learning_rate = 0.1;
+  auto updater = CreateUpdater<double>(config);
+  EXPECT_EQ(updater->GetStateSize(), 0);
+  double weight = 1.0;
+  updater->Update(&weight, nullptr, 2.0);
+  EXPECT_DOUBLE_EQ(weight, 0.8);
+}
+
+TEST_F(TestUpdater, Adagrad) {
+  UpdaterConfig config;
+  config.type = UpdaterType::Adagrad;
+  config.learning_rate = 0.1;
+  config.epsilon = 0;
+  auto updater = CreateUpdater<double>(config);
+  ASSERT_EQ(updater->GetStateSize(), 1);
+  double block[2] = {1.0, 0.0};
+  updater->Update(block, block + 1, 3.0);  // n = 9
+  EXPECT_DOUBLE_EQ(block[1], 9.0);
+  EXPECT_DOUBLE_EQ(block[0], 0.9);
+  updater->Update(block, block + 1, 4.0);  // n = 25
+  EXPECT_DOUBLE_EQ(block[0], 0.9 - 0.1 * 4.0 / 5.0);
+}
+
+TEST_F(TestUpdater, Adam) {
+  UpdaterConfig config;
+  config.type = UpdaterType::Adam;
+  config.learning_rate = 0.1;
+  auto updater = CreateUpdater<double>(config);
+  ASSERT_EQ(updater->GetStateSize(), 3);
+  double block[4] = {1.0, 0.0, 0.0, 0.0};
+  // the bias-corrected first step moves the weight by the learning rate
+  updater->Update(block, block + 1, 0.5);
+  EXPECT_NEAR(block[0], 0.9, 1e-6);
+  EXPECT_DOUBLE_EQ(block[3], 1.0);
+  updater->Update(block, block + 1, 0.5);
+  EXPECT_NEAR(block[0], 0.8, 1e-6);
+}
+
+TEST_F(TestUpdater, FTRL) {
+  UpdaterConfig config;
+  config.type = UpdaterType::FTRL;
+  config.learning_rate = 1.0;
+  config.ftrl_beta = 1.0;
+  config.l1 = 1.0;
+  auto updater = CreateUpdater<double>(config);
+  ASSERT_EQ(updater->GetStateSize(), 2);
+  double block[3] = {0.0, 0.0, 0.0};
+  // |z| stays under l1, so the weight is kept sparse
+  updater->Update(block, block + 1, 0.5);
+  EXPECT_DOUBLE_EQ(block[1], 0.5);
+  EXPECT_DOUBLE_EQ(block[2], 0.25);
+  EXPECT_DOUBLE_EQ(block[0], 0.0);
+  // the weight is still 0, so z = 0.5 + 3
+  updater->Update(block, block + 1, 3.0);
+  EXPECT_DOUBLE_EQ(block[1], 3.5);
+  EXPECT_DOUBLE_EQ(block[0], -(3.5 - 1.0) / (1.0 + std::sqrt(9.25)));
+}
+
+}  // namespace
+}  // namespace csci5570
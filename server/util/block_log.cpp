@@ -0,0 +1,141 @@
+#include "server/util/block_log.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+const size_t BlockLog::kBufferBytes;
+const uint64_t BlockLog::kMinCompactRecords;
+
+namespace {
+
+void PWriteAll(int fd, const char* data, size_t size, off_t offset) {
+  while (size != 0) {
+    ssize_t n = pwrite(fd, data, size, offset);
+    CHECK(n > 0) << "failed to write block log";
+    data += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+void PReadAll(int fd, char* data, size_t size, off_t offset) {
+  while (size != 0) {
+    ssize_t n = pread(fd, data, size, offset);
+    CHECK(n > 0) << "failed to read block log";
+    data += n;
+    size -= n;
+    offset += n;
+  }
+}
+
+}  // namespace
+
+BlockLogView::~BlockLogView() { close(fd_); }
+
+const char* BlockLogView::Read(size_t i) {
+  PReadAll(fd_, block_.data(), block_bytes_, records[i] * block_bytes_);
+  return block_.data();
+}
+
+BlockLog::BlockLog(const std::string& path, size_t block_bytes) : path_(path), block_bytes_(block_bytes) {
+  fd_ = open(path_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CHECK(fd_ != -1) << "cannot open block log " << path_;
+  buffer_.reserve(std::max(kBufferBytes / block_bytes_, size_t(1)) * block_bytes_);
+}
+
+BlockLog::~BlockLog() {
+  close(fd_);
+  std::remove(path_.c_str());
+}
+
+void BlockLog::Append(Key key, const char* block) {
+  *records_.FindOrInsert(key) = num_records_++;
+  buffer_.insert(buffer_.end(), block, block + block_bytes_);
+  if (buffer_.size() == buffer_.capacity())
+    Flush();
+  if (num_records_ >= kMinCompactRecords && num_records_ > 2 * records_.Size())
+    Compact();
+}
+
+bool BlockLog::Read(Key key, char* block) {
+  const uint64_t* record = records_.Find(key);
+  if (record == nullptr)
+    return false;
+  if (*record >= num_flushed_)
+    std::memcpy(block, &buffer_[(*record - num_flushed_) * block_bytes_], block_bytes_);
+  else
+    PReadAll(fd_, block, block_bytes_, *record * block_bytes_);
+  return true;
+}
+
+void BlockLog::Prefetch(const std::vector<Key>& keys) {
+  for (Key key : keys) {
+    const uint64_t* record = records_.Find(key);
+    if (record != nullptr && *record < num_flushed_)
+      posix_fadvise(fd_, *record * block_bytes_, block_bytes_, POSIX_FADV_WILLNEED);
+  }
+}
+
+std::shared_ptr<BlockLogView> BlockLog::View() {
+  Flush();
+  int fd = dup(fd_);
+  CHECK(fd != -1) << "cannot duplicate the descriptor of block log " << path_;
+  std::shared_ptr<BlockLogView> view(new BlockLogView(fd, block_bytes_));
+  std::vector<std::pair<Key, uint64_t>> entries;
+  entries.reserve(records_.Size());
+  records_.ForEach([&entries](Key key, const uint64_t* record) { entries.push_back(std::make_pair(key, *record)); });
+  std::sort(entries.begin(), entries.end());
+  view->keys.reserve(entries.size());
+  view->records.reserve(entries.size());
+  for (const auto& entry : entries) {
+    view->keys.push_back(entry.first);
+    view->records.push_back(entry.second);
+  }
+  return view;
+}
+
+void BlockLog::Flush() {
+  PWriteAll(fd_, buffer_.data(), buffer_.size(), num_flushed_ * block_bytes_);
+  num_flushed_ = num_records_;
+  buffer_.clear();
+}
+
+void BlockLog::Compact() {
+  Flush();
+  std::string tmp_path = path_ + ".compact";
+  int fd = open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  CHECK(fd != -1) << "cannot open block log " << tmp_path;
+  // copy the live records in file order, so the old file is read sequentially
+  std::vector<uint64_t*> live;
+  live.reserve(records_.Size());
+  records_.ForEach([&live](Key, uint64_t* record) { live.push_back(record); });
+  std::sort(live.begin(), live.end(), [](const uint64_t* a, const uint64_t* b) { return *a < *b; });
+  std::vector<char> block(block_bytes_);
+  uint64_t num_records = 0;
+  for (uint64_t* record : live) {
+    PReadAll(fd_, block.data(), block_bytes_, *record * block_bytes_);
+    buffer_.insert(buffer_.end(), block.begin(), block.end());
+    if (buffer_.size() == buffer_.capacity()) {
+      PWriteAll(fd, buffer_.data(), buffer_.size(), (num_records + 1) * block_bytes_ - buffer_.size());
+      buffer_.clear();
+    }
+    *record = num_records++;
+  }
+  PWriteAll(fd, buffer_.data(), buffer_.size(), num_records * block_bytes_ - buffer_.size());
+  buffer_.clear();
+  // views taken before keep reading the old file through their own descriptors
+  CHECK(std::rename(tmp_path.c_str(), path_.c_str()) == 0) << "cannot move block log " << tmp_path;
+  close(fd_);
+  fd_ = fd;
+  num_records_ = num_flushed_ = num_records;
+}
+
+}  // namespace csci5570
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/magic.hpp"
+#include "server/util/flat_hash_map.hpp"
+
+namespace csci5570 {
+
+/*
+ * The blocks of a BlockLog at one point in time, sorted by key, readable while the log goes on.
+ * Holds its own descriptor of the file, so it stays valid when the log is compacted into a new file.
+ */
+class BlockLogView {
+ public:
+  BlockLogView(int fd, size_t block_bytes) : fd_(fd), block_bytes_(block_bytes), block_(block_bytes) {}
+  ~BlockLogView();
+
+  /**
+   * Return the block of keys[i], valid until the next call
+   */
+  const char* Read(size_t i);
+
+  std::vector<Key> keys;
+  std::vector<uint64_t> records;  // the record number of keys[i] in the file
+
+ private:
+  int fd_;
+  size_t block_bytes_;
+  std::vector<char> block_;
+};
+
+/*
+ * A log-structured file of fixed-size blocks, the cold tier of the TieredStorage.
+ *
+ * Blocks are appended through a write buffer and a block written again supersedes its older records. An index in
+ * memory maps each key to its latest record. Once dead records outnumber the live ones, the live records are
+ * copied to a new file, so the file stays within twice the size of the live blocks. The file is scratch space and
+ * is removed with the log; durability comes from the checkpoints.
+ */
+class BlockLog {
+ public:
+  static const size_t kBufferBytes = 1 << 20;
+  static const uint64_t kMinCompactRecords = 4096;
+
+  /**
+   * @param path          the file, truncated if it exists
+   * @param block_bytes   the size of a block
+   */
+  BlockLog(const std::string& path, size_t block_bytes);
+  ~BlockLog();
+
+  void Append(Key key, const char* block);
+  /**
+   * Copy the latest block of the key and return true, or return false if the key was never appended
+   */
+  bool Read(Key key, char* block);
+  bool Contains(Key key) { return records_.Find(key) != nullptr; }
+  /**
+   * Ask the kernel to read the blocks of the keys in the background, so the Reads that follow find them cached
+   */
+  void Prefetch(const std::vector<Key>& keys);
+
+  size_t Size() const { return records_.Size(); }
+  // the records in the file, live or dead
+  uint64_t NumRecords() const { return num_records_; }
+
+  /**
+   * Flush the write buffer and return a view of every block
+   */
+  std::shared_ptr<BlockLogView> View();
+
+ private:
+  void Flush();
+  void Compact();
+
+  std::string path_;
+  size_t block_bytes_;
+  int fd_;
+  FlatHashMap<Key, uint64_t> records_;  // {key: the record number of its latest block}
+  uint64_t num_records_ = 0;
+  uint64_t num_flushed_ = 0;  // the records in the file, the others are in buffer_
+  std::vector<char> buffer_;
+};
+
+}  // namespace csci5570
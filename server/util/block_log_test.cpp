@@ -0,0 +1,68 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/block_log.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestBlockLog : public testing::Test {
+ public:
+  TestBlockLog() {}
+  ~TestBlockLog() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+
+  const std::string path_ = "/tmp/csci5570_block_log_test.blocks";
+};
+
+TEST_F(TestBlockLog, AppendRead) {
+  BlockLog log(path_, sizeof(uint64_t));
+  uint64_t block = 7;
+  log.Append(3, reinterpret_cast<const char*>(&block));
+  block = 8;
+  log.Append(3, reinterpret_cast<const char*>(&block));
+  EXPECT_EQ(log.Size(), 1);
+  EXPECT_TRUE(log.Contains(3));
+  EXPECT_FALSE(log.Contains(4));
+  uint64_t read = 0;
+  EXPECT_TRUE(log.Read(3, reinterpret_cast<char*>(&read)));
+  EXPECT_EQ(read, 8);
+  EXPECT_FALSE(log.Read(4, reinterpret_cast<char*>(&read)));
+}
+
+TEST_F(TestBlockLog, Compact) {
+  BlockLog log(path_, sizeof(uint64_t));
+  // more than the write buffer holds, so the blocks are read from the file
+  for (uint64_t round = 0; round < 100; round++) {
+    for (uint64_t key = 0; key < 2000; key++) {
+      uint64_t block = key * 1000 + round;
+      log.Append(key, reinterpret_cast<const char*>(&block));
+    }
+    if (round == 50) {
+      auto view = log.View();
+      ASSERT_EQ(view->keys.size(), 2000);
+      EXPECT_EQ(view->keys[1234], 1234);
+      // the view reads the blocks as of its creation, even once the log is compacted
+      for (uint64_t key = 0; key < 2000; key++) {
+        uint64_t more = 0;
+        log.Append(key, reinterpret_cast<const char*>(&more));
+      }
+      EXPECT_EQ(*reinterpret_cast<const uint64_t*>(view->Read(1234)), 1234050);
+    }
+  }
+  EXPECT_EQ(log.Size(), 2000);
+  EXPECT_LE(log.NumRecords(), 4000);
+  for (uint64_t key = 0; key < 2000; key++) {
+    uint64_t read;
+    ASSERT_TRUE(log.Read(key, reinterpret_cast<char*>(&read)));
+    EXPECT_EQ(read, key * 1000 + 99);
+  }
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,192 @@
+#include "server/util/checkpoint.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "glog/logging.h"
+#include "server/util/hash.hpp"
+
+namespace csci5570 {
+
+const uint32_t CheckpointHeader::kMagic;
+const uint32_t CheckpointHeader::kVersion;
+const size_t CheckpointWriter::kBufferSize;
+const int CheckpointSchedule::kMaxDeltas;
+
+namespace {
+
+const uint64_t kMul1 = 0x87c37b91114253d5ULL;
+const uint64_t kMul2 = 0x4cf5ad432745937fULL;
+
+uint64_t Rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+// write(2) may write less than asked, e.g. at most 2 GB on Linux
+void WriteAll(int fd, const char* data, size_t size, const std::string& path) {
+  while (size != 0) {
+    ssize_t n = write(fd, data, size);
+    CHECK(n > 0) << "failed to write checkpoint " << path;
+    data += n;
+    size -= n;
+  }
+}
+
+}  // namespace
+
+void Checksum::Mix(uint64_t word) {
+  word *= kMul1;
+  word = Rotl(word, 31);
+  word *= kMul2;
+  hash_ ^= word;
+  hash_ = Rotl(hash_, 27) * 5 + 0x52dce729;
+}
+
+void Checksum::Update(const char* data, size_t size) {
+  length_ += size;
+  // complete the pending word first
+  while (num_pending_ != 0 && size != 0) {
+    pending_ |= static_cast<uint64_t>(static_cast<unsigned char>(*data)) << (8 * num_pending_);
+    data++;
+    size--;
+    if (++num_pending_ == 8) {
+      Mix(pending_);
+      pending_ = 0;
+      num_pending_ = 0;
+    }
+  }
+  for (; size >= 8; data += 8, size -= 8) {
+    uint64_t word;
+    std::memcpy(&word, data, 8);
+    Mix(word);
+  }
+  for (; size != 0; data++, size--) {
+    pending_ |= static_cast<uint64_t>(static_cast<unsigned char>(*data)) << (8 * num_pending_++);
+  }
+}
+
+uint64_t Checksum::Digest() const {
+  uint64_t h = hash_ ^ length_;
+  if (num_pending_ != 0)
+    h ^= Rotl(pending_ * kMul1, 31) * kMul2;
+  return Mix64(h);
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path) : path_(path), buffer_(kBufferSize) {
+  std::string tmp_path = path_ + ".tmp";
+  fd_ = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  CHECK(fd_ != -1) << "cannot open checkpoint file " << tmp_path;
+  Write(CheckpointHeader());
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  if (fd_ != -1)
+    Close();
+}
+
+void CheckpointWriter::Write(const void* data, size_t size) {
+  const char* bytes = static_cast<const char*>(data);
+  checksum_.Update(bytes, size);
+  while (size != 0) {
+    if (buffered_ == 0 && size >= kBufferSize) {
+      // large writes bypass the buffer
+      WriteAll(fd_, bytes, size, path_);
+      return;
+    }
+    size_t n = std::min(size, kBufferSize - buffered_);
+    std::memcpy(&buffer_[buffered_], bytes, n);
+    buffered_ += n;
+    bytes += n;
+    size -= n;
+    if (buffered_ == kBufferSize)
+      Flush();
+  }
+}
+
+void CheckpointWriter::Flush() {
+  WriteAll(fd_, buffer_.data(), buffered_, path_);
+  buffered_ = 0;
+}
+
+void CheckpointWriter::Close() {
+  uint64_t digest = checksum_.Digest();
+  if (buffered_ + sizeof(digest) > kBufferSize)
+    Flush();
+  std::memcpy(&buffer_[buffered_], &digest, sizeof(digest));
+  buffered_ += sizeof(digest);
+  Flush();
+  fsync(fd_);
+  close(fd_);
+  fd_ = -1;
+  std::string tmp_path = path_ + ".tmp";
+  CHECK(std::rename(tmp_path.c_str(), path_.c_str()) == 0) << "cannot move checkpoint " << tmp_path << " to "
+                                                           << path_;
+}
+
+CheckpointReader::CheckpointReader(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd == -1)
+    return;
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size >= static_cast<off_t>(sizeof(CheckpointHeader) + sizeof(uint64_t))) {
+    void* addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (addr != MAP_FAILED) {
+      data_ = static_cast<const char*>(addr);
+      size_ = st.st_size;
+      madvise(addr, size_, MADV_SEQUENTIAL);
+    }
+  }
+  close(fd);
+  if (data_ == nullptr)
+    return;
+
+  CheckpointHeader header;
+  std::memcpy(&header, data_, sizeof(header));
+  if (header.magic != CheckpointHeader::kMagic || header.version != CheckpointHeader::kVersion) {
+    LOG(ERROR) << "unknown checkpoint format in " << path;
+    return;
+  }
+  payload_end_ = size_ - sizeof(uint64_t);
+  Checksum checksum;
+  checksum.Update(data_, payload_end_);
+  uint64_t digest;
+  std::memcpy(&digest, data_ + payload_end_, sizeof(digest));
+  if (checksum.Digest() != digest) {
+    LOG(ERROR) << "checksum mismatch in checkpoint " << path;
+    return;
+  }
+  pos_ = sizeof(CheckpointHeader);
+  ok_ = true;
+}
+
+CheckpointReader::~CheckpointReader() {
+  if (data_ != nullptr)
+    munmap(const_cast<char*>(data_), size_);
+}
+
+const char* CheckpointReader::Read(size_t size) {
+  if (!ok_ || size > payload_end_ - pos_)
+    return nullptr;
+  const char* ret = data_ + pos_;
+  pos_ += size;
+  return ret;
+}
+
+std::string CheckpointSchedule::Next(const std::string& path, bool full) {
+  if (!full)
+    return DeltaPath(path, ++num_deltas_);
+  // Take the time as the epoch, so it stays unique even when a storage restarts without its checkpoints
+  uint64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+                     std::chrono::system_clock::now().time_since_epoch()).count();
+  epoch_ = std::max(epoch_ + 1, now);
+  num_deltas_ = 0;
+  require_full_ = false;
+  return path;
+}
+
+}  // namespace csci5570
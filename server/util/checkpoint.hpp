@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace csci5570 {
+
+/*
+ * Binary checkpoint files.
+ *
+ * A file is laid out as
+ *   [CheckpointHeader][payload][uint64_t checksum of header and payload]
+ * and is written to <path>.tmp and renamed over <path> on Close(), so a crash while checkpointing leaves the
+ * previous checkpoint intact. Values are stored in their in-memory representation, so nothing is lost to
+ * formatting and a restore is a bulk copy out of the mapped file.
+ *
+ * The payload of the key-value checkpoints of the storages and progress trackers is
+ *   [KVCheckpointHeader][num_keys sorted keys][padding to 8 bytes][num_keys * width values]
+ *
+ * A storage checkpoint is either full or a delta holding only the keys changed since the previous checkpoint.
+ * The k-th delta after a full checkpoint at <path> is written to <path>.delta<k> and carries the epoch of that
+ * full checkpoint, so deltas left over from an older full checkpoint are never replayed.
+ */
+struct CheckpointHeader {
+  static const uint32_t kMagic = 0x4b435350;  // "PSCK" in a little-endian file
+  static const uint32_t kVersion = 1;
+
+  uint32_t magic = kMagic;
+  uint32_t version = kVersion;
+};
+
+struct KVCheckpointHeader {
+  uint32_t key_size;
+  uint32_t val_size;
+  uint64_t width;  // number of values per key
+  uint64_t num_keys;
+  uint64_t epoch;  // identifies the full checkpoint, shared by its deltas
+};
+
+/*
+ * A fast streaming checksum over 8-byte words, in the style of the MurmurHash mixing steps
+ */
+class Checksum {
+ public:
+  void Update(const char* data, size_t size);
+  uint64_t Digest() const;
+
+ private:
+  void Mix(uint64_t word);
+
+  uint64_t hash_ = 0;
+  uint64_t length_ = 0;
+  uint64_t pending_ = 0;  // the trailing bytes not forming a whole word yet
+  size_t num_pending_ = 0;
+};
+
+class CheckpointWriter {
+ public:
+  /**
+   * @param path    the checkpoint file to (re)place once Close() is called
+   */
+  explicit CheckpointWriter(const std::string& path);
+  ~CheckpointWriter();
+
+  void Write(const void* data, size_t size);
+  template <typename T>
+  void Write(const T& pod) {
+    Write(&pod, sizeof(T));
+  }
+  /**
+   * Append the checksum, flush the file and move it in place of the previous checkpoint
+   */
+  void Close();
+
+ private:
+  void Flush();
+
+  static const size_t kBufferSize = 4 << 20;
+
+  std::string path_;
+  int fd_ = -1;
+  std::vector<char> buffer_;
+  size_t buffered_ = 0;
+  Checksum checksum_;
+};
+
+class CheckpointReader {
+ public:
+  /**
+   * Map the checkpoint file and verify its header and checksum. Ok() is false if the file is missing or
+   * corrupted.
+   *
+   * @param path    the checkpoint file
+   */
+  explicit CheckpointReader(const std::string& path);
+  ~CheckpointReader();
+
+  bool Ok() const { return ok_; }
+  /**
+   * Return the next size bytes of the payload, or nullptr if the payload is exhausted
+   */
+  const char* Read(size_t size);
+  template <typename T>
+  const T* Read(size_t n = 1) {
+    return reinterpret_cast<const T*>(Read(n * sizeof(T)));
+  }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;     // the size of the mapping
+  size_t payload_end_ = 0;
+  size_t pos_ = 0;
+  bool ok_ = false;
+};
+
+// the values start at an 8-byte boundary of the file
+inline size_t KeyPadding(size_t keys_bytes) { return (8 - keys_bytes % 8) % 8; }
+
+/**
+ * Write a key-value checkpoint. keys must be sorted and block(i) must return the width values of keys[i].
+ */
+template <typename Val, typename Key, typename BlockFunc>
+void WriteKVCheckpoint(const std::string& path, const std::vector<Key>& keys, size_t width, BlockFunc block,
+                       uint64_t epoch = 0) {
+  CheckpointWriter writer(path);
+  KVCheckpointHeader header;
+  header.key_size = sizeof(Key);
+  header.val_size = sizeof(Val);
+  header.width = width;
+  header.num_keys = keys.size();
+  header.epoch = epoch;
+  writer.Write(header);
+  writer.Write(keys.data(), keys.size() * sizeof(Key));
+  const uint64_t zeros = 0;
+  writer.Write(&zeros, KeyPadding(keys.size() * sizeof(Key)));
+  for (size_t i = 0; i < keys.size(); i++) {
+    writer.Write(block(i), width * sizeof(Val));
+  }
+  writer.Close();
+}
+
+/*
+ * A copy of the blocks of a storage, to be written as a key-value checkpoint possibly by another thread
+ */
+template <typename Key, typename Val>
+struct KVSnapshot {
+  explicit KVSnapshot(size_t width) : width(width) {}
+
+  void Add(Key key, const Val* block) {
+    keys.push_back(key);
+    vals.insert(vals.end(), block, block + width);
+  }
+
+  /**
+   * Write the snapshot as a key-value checkpoint, sorting the keys first if they are not sorted yet
+   */
+  void Write(const std::string& path) const {
+    if (std::is_sorted(keys.begin(), keys.end())) {
+      WriteKVCheckpoint<Val>(path, keys, width, [this](size_t i) { return &vals[i * width]; }, epoch);
+      return;
+    }
+    std::vector<size_t> order(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return keys[a] < keys[b]; });
+    std::vector<Key> sorted_keys(keys.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      sorted_keys[i] = keys[order[i]];
+    }
+    WriteKVCheckpoint<Val>(path, sorted_keys, width, [this, &order](size_t i) { return &vals[order[i] * width]; },
+                           epoch);
+  }
+
+  size_t width;        // number of values per key
+  uint64_t epoch = 0;  // see KVCheckpointHeader
+  std::vector<Key> keys;
+  std::vector<Val> vals;  // the block of keys[i] starts at i * width
+};
+
+/**
+ * Map a key-value checkpoint written by WriteKVCheckpoint and point keys and vals into the mapping.
+ * Return the number of keys, or -1 if the file is missing, corrupted or of another key type, value type or width.
+ */
+template <typename Val, typename Key>
+int64_t ReadKVCheckpoint(CheckpointReader* reader, size_t width, const Key** keys, const Val** vals,
+                         uint64_t* epoch = nullptr) {
+  if (!reader->Ok())
+    return -1;
+  const KVCheckpointHeader* header = reader->Read<KVCheckpointHeader>();
+  if (header == nullptr || header->key_size != sizeof(Key) || header->val_size != sizeof(Val) ||
+      header->width != width)
+    return -1;
+  int64_t num_keys = header->num_keys;
+  if (epoch != nullptr)
+    *epoch = header->epoch;
+  *keys = reader->Read<Key>(num_keys);
+  reader->Read(KeyPadding(num_keys * sizeof(Key)));
+  *vals = reader->Read<Val>(num_keys * width);
+  if (*keys == nullptr || *vals == nullptr)
+    return -1;
+  return num_keys;
+}
+
+/*
+ * Decides whether the next checkpoint of a storage is full or a delta, and where it goes
+ */
+class CheckpointSchedule {
+ public:
+  static const int kMaxDeltas = 9;  // so at least every 10th checkpoint is full
+
+  /**
+   * @param num_dirty   the number of keys changed since the last checkpoint
+   * @param num_keys    the number of keys in the storage
+   */
+  bool NextIsFull(size_t num_dirty, size_t num_keys) const {
+    // a delta holding most keys saves little and lengthens the recovery
+    return epoch_ == 0 || require_full_ || num_deltas_ >= kMaxDeltas || num_dirty * 2 > num_keys;
+  }
+
+  // Make the next checkpoint full, e.g. after keys are erased, which deltas cannot express
+  void RequireFull() { require_full_ = true; }
+
+  /**
+   * Account for the next checkpoint and return the file to write it to
+   *
+   * @param path    the path of the full checkpoint
+   * @param full    whether the next checkpoint is full
+   */
+  std::string Next(const std::string& path, bool full);
+
+  // the epoch of the last full checkpoint
+  uint64_t Epoch() const { return epoch_; }
+
+  /**
+   * Replay the full checkpoint at path and then its deltas in order, calling
+   * restore(const Key* keys, const Val* vals, int64_t num_keys, bool full) for each. The schedule continues
+   * after the last delta replayed.
+   */
+  template <typename Val, typename Key, typename RestoreFunc>
+  void Replay(const std::string& path, size_t width, RestoreFunc restore) {
+    uint64_t epoch;
+    const Key* keys;
+    const Val* vals;
+    {
+      CheckpointReader reader(path);
+      int64_t num_keys = ReadKVCheckpoint(&reader, width, &keys, &vals, &epoch);
+      if (num_keys == -1)
+        return;
+      restore(keys, vals, num_keys, true);
+    }
+    epoch_ = epoch;
+    num_deltas_ = 0;
+    while (true) {
+      CheckpointReader reader(DeltaPath(path, num_deltas_ + 1));
+      uint64_t delta_epoch;
+      int64_t num_keys = ReadKVCheckpoint(&reader, width, &keys, &vals, &delta_epoch);
+      if (num_keys == -1 || delta_epoch != epoch)
+        return;
+      restore(keys, vals, num_keys, false);
+      num_deltas_++;
+    }
+  }
+
+  static std::string DeltaPath(const std::string& path, int k) { return path + ".delta" + std::to_string(k); }
+
+ private:
+  uint64_t epoch_ = 0;  // 0 before the first full checkpoint
+  int num_deltas_ = 0;  // the deltas written since the last full checkpoint
+  bool require_full_ = false;
+};
+
+}  // namespace csci5570
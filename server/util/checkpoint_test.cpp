@@ -0,0 +1,107 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/checkpoint.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestCheckpoint : public testing::Test {
+ public:
+  TestCheckpoint() {}
+  ~TestCheckpoint() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() { std::remove(path_.c_str()); }
+
+  const std::string path_ = "/tmp/csci5570_checkpoint_test.ckpt";
+};
+
+TEST_F(TestCheckpoint, ChecksumIgnoresChunking) {
+  std::string data = "the checksum is computed over 8-byte words";
+  Checksum whole;
+  whole.Update(data.data(), data.size());
+  Checksum pieces;
+  pieces.Update(data.data(), 3);
+  pieces.Update(data.data() + 3, 10);
+  pieces.Update(data.data() + 13, data.size() - 13);
+  EXPECT_EQ(whole.Digest(), pieces.Digest());
+  Checksum shorter;
+  shorter.Update(data.data(), data.size() - 1);
+  EXPECT_NE(whole.Digest(), shorter.Digest());
+}
+
+TEST_F(TestCheckpoint, KVRoundTrip) {
+  std::vector<uint32_t> keys = {3, 5, 9};
+  std::vector<double> vals = {0.1, 1.0 / 3, 2.5, -1e-300, 7, 8};
+  WriteKVCheckpoint<double>(path_, keys, 2, [&vals](size_t i) { return &vals[i * 2]; });
+
+  CheckpointReader reader(path_);
+  ASSERT_TRUE(reader.Ok());
+  const uint32_t* read_keys;
+  const double* read_vals;
+  ASSERT_EQ(ReadKVCheckpoint(&reader, 2, &read_keys, &read_vals), 3);
+  EXPECT_EQ(std::vector<uint32_t>(read_keys, read_keys + 3), keys);
+  // the values are restored bit for bit
+  EXPECT_EQ(std::vector<double>(read_vals, read_vals + 6), vals);
+}
+
+TEST_F(TestCheckpoint, Mismatch) {
+  std::vector<uint32_t> keys = {1};
+  std::vector<float> vals = {1.5};
+  WriteKVCheckpoint<float>(path_, keys, 1, [&vals](size_t i) { return &vals[i]; });
+  {
+    CheckpointReader reader(path_);
+    const uint32_t* read_keys;
+    const double* read_vals;
+    EXPECT_EQ(ReadKVCheckpoint(&reader, 1, &read_keys, &read_vals), -1);  // another value type
+  }
+  {
+    CheckpointReader reader(path_);
+    const uint32_t* read_keys;
+    const float* read_vals;
+    EXPECT_EQ(ReadKVCheckpoint(&reader, 2, &read_keys, &read_vals), -1);  // another width
+  }
+  CheckpointReader missing("/tmp/csci5570_checkpoint_test_missing.ckpt");
+  EXPECT_FALSE(missing.Ok());
+}
+
+TEST_F(TestCheckpoint, Corrupted) {
+  std::vector<uint32_t> keys = {1, 2};
+  std::vector<int> vals = {10, 20};
+  WriteKVCheckpoint<int>(path_, keys, 1, [&vals](size_t i) { return &vals[i]; });
+  {
+    std::fstream file(path_, std::ios::in | std::ios::out | std::ios::binary);
+    file.seekp(sizeof(CheckpointHeader) + sizeof(KVCheckpointHeader));
+    file.put(7);
+  }
+  CheckpointReader reader(path_);
+  EXPECT_FALSE(reader.Ok());
+}
+
+TEST_F(TestCheckpoint, LargeWrite) {
+  // larger than the write buffer
+  std::vector<uint32_t> keys(1 << 20);
+  std::vector<double> vals(keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    keys[i] = i;
+    vals[i] = i * 0.5;
+  }
+  WriteKVCheckpoint<double>(path_, keys, 1, [&vals](size_t i) { return &vals[i]; });
+
+  CheckpointReader reader(path_);
+  const uint32_t* read_keys;
+  const double* read_vals;
+  ASSERT_EQ(ReadKVCheckpoint(&reader, 1, &read_keys, &read_vals), keys.size());
+  EXPECT_EQ(read_keys[12345], 12345);
+  EXPECT_EQ(read_vals[keys.size() - 1], (keys.size() - 1) * 0.5);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,36 @@
+#include "server/util/checkpointer.hpp"
+
+#include <chrono>
+#include <utility>
+
+namespace csci5570 {
+
+Checkpointer::Checkpointer() : io_thread_([this] { Main(); }) {}
+
+Checkpointer::~Checkpointer() {
+  tasks_.Push(std::packaged_task<void()>());
+  io_thread_.join();
+}
+
+std::future<void> Checkpointer::Submit(std::function<void()> task) {
+  std::packaged_task<void()> packaged(std::move(task));
+  std::future<void> future = packaged.get_future();
+  tasks_.Push(std::move(packaged));
+  return future;
+}
+
+bool Checkpointer::IsPending(const std::future<void>& checkpoint) {
+  return checkpoint.valid() && checkpoint.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void Checkpointer::Main() {
+  while (true) {
+    std::packaged_task<void()> task;
+    tasks_.WaitAndPop(&task);
+    if (!task.valid())
+      return;
+    task();
+  }
+}
+
+}  // namespace csci5570
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <functional>
+#include <future>
+#include <thread>
+
+#include "base/threadsafe_queue.hpp"
+
+namespace csci5570 {
+
+/*
+ * Runs checkpoint tasks on a dedicated I/O thread.
+ *
+ * A model takes a snapshot of its storage on the server thread, which is a memory copy, and submits the task
+ * writing it here, so the server thread keeps serving requests while the checkpoint goes to disk.
+ */
+class Checkpointer {
+ public:
+  Checkpointer();
+  /**
+   * Finish the queued tasks and stop the I/O thread
+   */
+  ~Checkpointer();
+
+  /**
+   * Queue a checkpoint task
+   *
+   * @param task    the task writing a snapshot
+   * @return        a future that is ready once the task is done
+   */
+  std::future<void> Submit(std::function<void()> task);
+
+  /**
+   * Check whether the checkpoint of a future returned by Submit is still queued or being written
+   */
+  static bool IsPending(const std::future<void>& checkpoint);
+
+ private:
+  void Main();
+
+  ThreadsafeQueue<std::packaged_task<void()>> tasks_;  // an empty task stops the I/O thread
+  std::thread io_thread_;
+};
+
+}  // namespace csci5570
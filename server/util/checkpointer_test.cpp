@@ -0,0 +1,65 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/checkpointer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestCheckpointer : public testing::Test {
+ public:
+  TestCheckpointer() {}
+  ~TestCheckpointer() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestCheckpointer, RunInOrder) {
+  std::vector<int> done;
+  std::future<void> first, second;
+  {
+    Checkpointer checkpointer;
+    first = checkpointer.Submit([&done]() { done.push_back(1); });
+    second = checkpointer.Submit([&done]() { done.push_back(2); });
+    second.wait();
+    EXPECT_FALSE(Checkpointer::IsPending(first));
+    EXPECT_FALSE(Checkpointer::IsPending(second));
+  }
+  EXPECT_EQ(done, std::vector<int>({1, 2}));
+}
+
+TEST_F(TestCheckpointer, Pending) {
+  std::future<void> none;
+  EXPECT_FALSE(Checkpointer::IsPending(none));
+
+  std::atomic<bool> release(false);
+  Checkpointer checkpointer;
+  auto blocked = checkpointer.Submit([&release]() {
+    while (!release)
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  });
+  EXPECT_TRUE(Checkpointer::IsPending(blocked));
+  release = true;
+  blocked.wait();
+  EXPECT_FALSE(Checkpointer::IsPending(blocked));
+}
+
+TEST_F(TestCheckpointer, FinishQueuedTasksOnDestruction) {
+  std::atomic<int> count(0);
+  {
+    Checkpointer checkpointer;
+    for (int i = 0; i < 10; i++) {
+      checkpointer.Submit([&count]() { count++; });
+    }
+  }
+  EXPECT_EQ(count, 10);
+}
+
+}  // namespace
+}  // namespace csci5570
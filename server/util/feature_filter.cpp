@@ -0,0 +1,68 @@
+#include "server/util/feature_filter.hpp"
+
+#include "glog/logging.h"
+#include "server/util/hash.hpp"
+
+namespace csci5570 {
+
+const int CountMinSketch::kDepth;
+const uint64_t CountMinSketch::kResetFactor;
+
+CountMinSketch::CountMinSketch(size_t width) {
+  size_t capacity = 1;
+  while (capacity < width)
+    capacity *= 2;
+  mask_ = capacity - 1;
+  counters_.resize(kDepth * capacity);
+}
+
+size_t CountMinSketch::Index(int row, Key key) const {
+  // an independent hash per row, from the finalizer of MurmurHash3 on a row-specific seed
+  uint64_t h = Mix64(static_cast<uint64_t>(key) + (static_cast<uint64_t>(row) + 1) * 0x9e3779b97f4a7c15ULL);
+  return row * (mask_ + 1) + (h & mask_);
+}
+
+uint32_t CountMinSketch::Estimate(Key key) const {
+  uint32_t estimate = UINT16_MAX;
+  for (int row = 0; row < kDepth; row++) {
+    estimate = std::min<uint32_t>(estimate, counters_[Index(row, key)]);
+  }
+  return estimate;
+}
+
+uint32_t CountMinSketch::Increment(Key key) {
+  // conservative update: only the counters at the minimum grow, which keeps collisions from inflating counts
+  uint32_t estimate = Estimate(key);
+  if (estimate != UINT16_MAX) {
+    estimate++;
+    for (int row = 0; row < kDepth; row++) {
+      uint16_t& counter = counters_[Index(row, key)];
+      counter = std::max<uint16_t>(counter, estimate);
+    }
+  }
+  if (++num_increments_ == kResetFactor * (mask_ + 1))
+    Reset();
+  return estimate;
+}
+
+void CountMinSketch::Reset() {
+  for (uint16_t& counter : counters_) {
+    counter /= 2;
+  }
+  num_increments_ = 0;
+}
+
+FeatureFilter::FeatureFilter(const FeatureConfig& config)
+    : config_(config), sketch_(config.min_count > 1 ? 1 << 18 : 1) {
+  CHECK_LT(config.min_count, UINT16_MAX) << "the sketch counts up to " << UINT16_MAX;
+}
+
+bool FeatureFilter::Admit(Key key) {
+  if (config_.min_count > 1 && sketch_.Increment(key) < config_.min_count)
+    return false;
+  if (config_.admit_probability < 1.0)
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng_) < config_.admit_probability;
+  return true;
+}
+
+}  // namespace csci5570
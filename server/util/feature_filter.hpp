@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "base/magic.hpp"
+
+namespace csci5570 {
+
+/*
+ * How a table admits new keys and evicts old ones, so tail features of an unbounded sparse key space do not grow
+ * the servers without bound. The defaults disable every rule.
+ */
+struct FeatureConfig {
+  // admit a key once it has been added min_count times, as counted by a sketch, 0 or 1 to admit at once
+  uint32_t min_count = 0;
+  // admit a new key with this probability at each Add, 1 to always admit and 0 to admit no new key
+  double admit_probability = 1.0;
+  uint32_t ttl = 0;       // evict keys neither added nor read in the last ttl clocks, 0 to never expire keys
+  uint64_t max_keys = 0;  // keep at most max_keys keys per storage, evicting the least frequently used, 0 for no cap
+};
+
+/*
+ * The access statistics a storage keeps in the block of each key when eviction is enabled
+ */
+struct KeyStats {
+  uint32_t last_clock;  // the clock of the last Add or Get
+  uint32_t count;       // the accesses, halved at each clock so old accesses fade out
+};
+
+/*
+ * A count-min sketch of kDepth rows of saturating 16-bit counters with conservative update. All counters are
+ * halved after every kResetFactor * width insertions, so the counts follow the recent key frequencies.
+ */
+class CountMinSketch {
+ public:
+  static const int kDepth = 4;
+  static const uint64_t kResetFactor = 10;
+
+  /**
+   * @param width   the counters per row, rounded up to a power of two
+   */
+  explicit CountMinSketch(size_t width = 1 << 18);
+
+  /**
+   * Count an occurrence of the key and return its estimated count, including this one
+   */
+  uint32_t Increment(Key key);
+  uint32_t Estimate(Key key) const;
+
+ private:
+  size_t Index(int row, Key key) const;
+  void Reset();
+
+  size_t mask_;
+  std::vector<uint16_t> counters_;  // row i at [i * (mask_ + 1), (i + 1) * (mask_ + 1))
+  uint64_t num_increments_ = 0;
+};
+
+/*
+ * Applies the FeatureConfig of a table to a storage. The storage asks Admit() before inserting a key on Add,
+ * touches the KeyStats of the keys it serves and calls Clock() and Evict() when the min clock advances.
+ */
+class FeatureFilter {
+ public:
+  explicit FeatureFilter(const FeatureConfig& config = FeatureConfig());
+
+  // whether the storage keeps KeyStats and evicts keys
+  bool Evicts() const { return config_.ttl != 0 || config_.max_keys != 0; }
+  // whether Admit depends on how many Adds of a key arrive, so they must not be summed before reaching the storage
+  bool CountsAdds() const { return config_.min_count > 1 || config_.admit_probability < 1.0; }
+
+  /**
+   * Return whether an Add of a key absent from the storage inserts it
+   */
+  bool Admit(Key key);
+
+  void Touch(KeyStats* stats) const {
+    stats->last_clock = clock_;
+    if (stats->count != UINT32_MAX)
+      stats->count++;
+  }
+
+  void Clock() { clock_++; }
+  /**
+   * Continue the clock of restored keys, so their ttl is not reset by a recovery
+   */
+  void Restore(const KeyStats& stats) { clock_ = std::max(clock_, stats.last_clock); }
+
+  /**
+   * Select the keys to evict and halve the counts of the others
+   *
+   * @param num_keys    the number of keys in the storage
+   * @param for_each    for_each(func) calls func(key, stats) on every key of the storage, where func is a
+   *                    std::function<void(Key, KeyStats*)>
+   * @return            the keys to evict
+   */
+  template <typename ForEachFunc>
+  std::vector<Key> Evict(size_t num_keys, ForEachFunc for_each) const {
+    std::vector<Key> victims;
+    std::vector<std::pair<uint32_t, Key>> candidates;  // {count: key} of the keys surviving the ttl
+    bool over = config_.max_keys != 0 && num_keys > config_.max_keys;
+    std::function<void(Key, KeyStats*)> visit = [this, over, &victims, &candidates](Key key, KeyStats* stats) {
+      if (config_.ttl != 0 && clock_ - stats->last_clock >= config_.ttl) {
+        victims.push_back(key);
+        return;
+      }
+      if (over)
+        candidates.push_back(std::make_pair(stats->count, key));
+      stats->count /= 2;
+    };
+    for_each(visit);
+    if (over && candidates.size() > config_.max_keys) {
+      auto nth = candidates.end() - config_.max_keys;
+      std::nth_element(candidates.begin(), nth, candidates.end());
+      for (auto it = candidates.begin(); it != nth; ++it) {
+        victims.push_back(it->second);
+      }
+    }
+    return victims;
+  }
+
+ private:
+  FeatureConfig config_;
+  uint32_t clock_ = 0;
+  CountMinSketch sketch_;
+  std::mt19937 rng_;
+};
+
+}  // namespace csci5570
@@ -0,0 +1,96 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/feature_filter.hpp"
+
+#include <algorithm>
+#include <map>
+
+namespace csci5570 {
+namespace {
+
+class TestFeatureFilter : public testing::Test {
+ public:
+  TestFeatureFilter() {}
+  ~TestFeatureFilter() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestFeatureFilter, CountMinSketch) {
+  CountMinSketch sketch(1024);
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(sketch.Increment(7), i + 1);
+  }
+  // collisions may only overestimate
+  for (Key key = 100; key < 600; key++) {
+    sketch.Increment(key);
+  }
+  EXPECT_GE(sketch.Estimate(7), 5);
+  EXPECT_LE(sketch.Estimate(7), 6);
+  EXPECT_EQ(sketch.Estimate(100000), 0);
+}
+
+TEST_F(TestFeatureFilter, AdmitByCount) {
+  FeatureConfig config;
+  config.min_count = 3;
+  FeatureFilter filter(config);
+  EXPECT_FALSE(filter.Admit(5));
+  EXPECT_FALSE(filter.Admit(5));
+  EXPECT_TRUE(filter.Admit(5));
+  EXPECT_FALSE(filter.Admit(6));
+  EXPECT_TRUE(FeatureFilter().Admit(6));
+}
+
+TEST_F(TestFeatureFilter, AdmitByProbability) {
+  FeatureConfig config;
+  config.admit_probability = 0.25;
+  FeatureFilter filter(config);
+  int admitted = 0;
+  for (Key key = 0; key < 10000; key++) {
+    admitted += filter.Admit(key);
+  }
+  EXPECT_NEAR(admitted, 2500, 300);
+}
+
+TEST_F(TestFeatureFilter, Evict) {
+  FeatureConfig config;
+  config.ttl = 3;
+  config.max_keys = 2;
+  FeatureFilter filter(config);
+  EXPECT_TRUE(filter.Evicts());
+  EXPECT_FALSE(FeatureFilter().Evicts());
+  std::map<Key, KeyStats> stats;
+  for (Key key = 1; key <= 4; key++) {
+    stats[key] = KeyStats();
+    for (Key i = 0; i < key * 2; i++) {
+      filter.Touch(&stats[key]);
+    }
+  }
+  filter.Clock();
+  filter.Clock();
+  filter.Touch(&stats[1]);
+  auto for_each = [&stats](const std::function<void(Key, KeyStats*)>& func) {
+    for (auto& kv : stats) {
+      func(kv.first, &kv.second);
+    }
+  };
+  // no key is past the ttl yet, so the two least frequently used keys go
+  std::vector<Key> victims = filter.Evict(stats.size(), for_each);
+  std::sort(victims.begin(), victims.end());
+  EXPECT_EQ(victims, (std::vector<Key>{1, 2}));
+  EXPECT_EQ(stats[3].count, 3);  // halved
+
+  stats.erase(1);
+  stats.erase(2);
+  filter.Clock();
+  filter.Touch(&stats[4]);
+  // key 3 is untouched for 3 clocks
+  victims = filter.Evict(stats.size(), for_each);
+  EXPECT_EQ(victims, std::vector<Key>{3});
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "server/util/hash.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace csci5570 {
+
+/*
+ * Open-addressing hash map for the server storages.
+ *
+ * Slots are organized in groups of kGroupWidth. Each slot has one control byte holding kEmpty, kDeleted or the
+ * low 7 bits of the key hash, so a whole group is probed with one SIMD compare before any key is touched.
+ * The capacity is always a power of two and the load factor, counting the slots of erased keys, is kept under
+ * 7/8. When the table is full, a new table is allocated, of twice the capacity unless most slots are erased ones,
+ * and the entries are migrated a few groups per insertion, so no single insertion pays for the whole rehash.
+ *
+ * A key maps to a block of <width> values stored next to each other.
+ */
+template <typename K, typename V>
+class FlatHashMap {
+ public:
+  explicit FlatHashMap(size_t width = 1) : width_(width), table_(new Table(kGroupWidth, width)) {}
+
+  /**
+   * Return the block of the key, or nullptr if the key is absent
+   */
+  V* Find(K key) {
+    uint64_t hash = Hash(key);
+    int slot = Lookup(*table_, key, hash);
+    if (slot != -1)
+      return &table_->vals[slot * width_];
+    if (old_table_) {
+      slot = Lookup(*old_table_, key, hash);
+      if (slot != -1)
+        return &old_table_->vals[slot * width_];
+    }
+    return nullptr;
+  }
+
+  /**
+   * Return the block of the key, inserting a value-initialized one if the key is absent.
+   * The pointer is invalidated by the next insertion.
+   */
+  V* FindOrInsert(K key) {
+    if (old_table_)
+      MigrateStep();
+    V* block = Find(key);
+    if (block != nullptr)
+      return block;
+    if ((table_->size + table_->num_deleted + 1) * 8 > Capacity() * 7)
+      Grow();
+    size_++;
+    return &table_->vals[InsertNew(table_.get(), key, Hash(key)) * width_];
+  }
+
+  /**
+   * Remove the key and return whether it was present
+   */
+  bool Erase(K key) {
+    // migrated entries are left in the old table, so finish the migration rather than erase from both tables
+    while (old_table_)
+      MigrateStep();
+    int slot = Lookup(*table_, key, Hash(key));
+    if (slot == -1)
+      return false;
+    // keep probing past the slot, and reset its block for the next insertion
+    table_->ctrl[slot] = kDeleted;
+    std::fill(&table_->vals[slot * width_], &table_->vals[(slot + 1) * width_], V());
+    table_->size--;
+    table_->num_deleted++;
+    size_--;
+    return true;
+  }
+
+  /**
+   * Invoke func(key, block) on every entry, in no particular order
+   */
+  template <typename Func>
+  void ForEach(Func func) {
+    ForEachInGroups(*table_, 0, func);
+    if (old_table_)
+      ForEachInGroups(*old_table_, migrate_group_, func);
+  }
+  template <typename Func>
+  void ForEach(Func func) const {
+    ForEachInGroups(static_cast<const Table&>(*table_), 0, func);
+    if (old_table_)
+      ForEachInGroups(static_cast<const Table&>(*old_table_), migrate_group_, func);
+  }
+
+  /**
+   * Remove every key, keeping the capacity for the next insertions
+   */
+  void Clear() {
+    old_table_.reset();
+    std::fill(table_->ctrl.begin(), table_->ctrl.end(), kEmpty);
+    std::fill(table_->vals.begin(), table_->vals.end(), V());
+    table_->size = 0;
+    table_->num_deleted = 0;
+    size_ = 0;
+  }
+
+  size_t Size() const { return size_; }
+  size_t Capacity() const { return table_->ctrl.size(); }
+
+ private:
+  static const size_t kGroupWidth = 16;
+  static const int8_t kEmpty = -128;
+  static const int8_t kDeleted = -2;  // both are negative, unlike the hash bits
+  static const size_t kMigrateGroupsPerInsert = 4;
+
+  struct Table {
+    Table(size_t capacity, size_t width)
+        : ctrl(capacity, kEmpty), keys(capacity), vals(capacity * width), group_mask(capacity / kGroupWidth - 1) {}
+    std::vector<int8_t> ctrl;
+    std::vector<K> keys;
+    std::vector<V> vals;
+    size_t group_mask;
+    size_t size = 0;
+    size_t num_deleted = 0;  // the slots of erased keys
+  };
+
+  static uint64_t Hash(K key) { return Mix64(static_cast<uint64_t>(key)); }
+
+  static int8_t H2(uint64_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+  // bit i is set if the i-th control byte of the group equals b
+  static uint32_t MatchByte(const int8_t* group, int8_t b) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(b))));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; i++) {
+      if (group[i] == b)
+        mask |= 1u << i;
+    }
+    return mask;
+#endif
+  }
+
+  // bit i is set if the i-th slot of the group is empty or deleted
+  static uint32_t MatchFree(const int8_t* group) {
+#ifdef __SSE2__
+    __m128i ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+    return static_cast<uint32_t>(_mm_movemask_epi8(ctrl));
+#else
+    uint32_t mask = 0;
+    for (size_t i = 0; i < kGroupWidth; i++) {
+      if (group[i] < 0)
+        mask |= 1u << i;
+    }
+    return mask;
+#endif
+  }
+
+  // triangular probing over the groups, which visits every group as the group count is a power of two
+  static int Lookup(const Table& table, K key, uint64_t hash) {
+    size_t group = (hash >> 7) & table.group_mask;
+    for (size_t probe = 0; probe <= table.group_mask; probe++) {
+      const int8_t* ctrl = &table.ctrl[group * kGroupWidth];
+      for (uint32_t match = MatchByte(ctrl, H2(hash)); match != 0; match &= match - 1) {
+        size_t slot = group * kGroupWidth + __builtin_ctz(match);
+        if (table.keys[slot] == key)
+          return slot;
+      }
+      if (MatchByte(ctrl, kEmpty) != 0)
+        return -1;
+      group = (group + probe + 1) & table.group_mask;
+    }
+    return -1;
+  }
+
+  // the key must be absent from the table
+  static size_t InsertNew(Table* table, K key, uint64_t hash) {
+    size_t group = (hash >> 7) & table->group_mask;
+    for (size_t probe = 0;; probe++) {
+      uint32_t available = MatchFree(&table->ctrl[group * kGroupWidth]);
+      if (available != 0) {
+        size_t slot = group * kGroupWidth + __builtin_ctz(available);
+        if (table->ctrl[slot] == kDeleted)
+          table->num_deleted--;
+        table->ctrl[slot] = H2(hash);
+        table->keys[slot] = key;
+        table->size++;
+        return slot;
+      }
+      group = (group + probe + 1) & table->group_mask;
+    }
+  }
+
+  template <typename TableType, typename Func>
+  void ForEachInGroups(TableType& table, size_t first_group, Func& func) const {
+    for (size_t slot = first_group * kGroupWidth; slot < table.ctrl.size(); slot++) {
+      if (table.ctrl[slot] >= 0)
+        func(table.keys[slot], &table.vals[slot * width_]);
+    }
+  }
+
+  void Grow() {
+    while (old_table_)
+      MigrateStep();
+    old_table_ = std::move(table_);
+    // a table filled up by erased keys is only cleaned
+    size_t capacity = old_table_->ctrl.size();
+    table_.reset(new Table((old_table_->size + 1) * 16 > capacity * 7 ? capacity * 2 : capacity, width_));
+    migrate_group_ = 0;
+  }
+
+  // Move the next groups of the old table to the new one. Migrated entries are left in the old table, which is
+  // only probed after the new one, so they are never observed twice.
+  void MigrateStep() {
+    size_t num_groups = old_table_->group_mask + 1;
+    size_t end = std::min(migrate_group_ + kMigrateGroupsPerInsert, num_groups);
+    for (size_t slot = migrate_group_ * kGroupWidth; slot < end * kGroupWidth; slot++) {
+      if (old_table_->ctrl[slot] < 0)
+        continue;
+      K key = old_table_->keys[slot];
+      size_t new_slot = InsertNew(table_.get(), key, Hash(key));
+      std::move(&old_table_->vals[slot * width_], &old_table_->vals[(slot + 1) * width_],
+                &table_->vals[new_slot * width_]);
+    }
+    migrate_group_ = end;
+    if (migrate_group_ == num_groups)
+      old_table_.reset();
+  }
+
+  size_t width_;
+  std::unique_ptr<Table> table_;
+  std::unique_ptr<Table> old_table_;  // the table being migrated, if any
+  size_t migrate_group_ = 0;          // groups of old_table_ before this one are migrated
+  size_t size_ = 0;
+};
+
+template <typename K, typename V>
+const size_t FlatHashMap<K, V>::kGroupWidth;
+template <typename K, typename V>
+const int8_t FlatHashMap<K, V>::kEmpty;
+template <typename K, typename V>
+const int8_t FlatHashMap<K, V>::kDeleted;
+template <typename K, typename V>
+const size_t FlatHashMap<K, V>::kMigrateGroupsPerInsert;
+
+}  // namespace csci5570
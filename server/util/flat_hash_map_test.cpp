@@ -0,0 +1,114 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/flat_hash_map.hpp"
+
+#include <map>
+
+namespace csci5570 {
+namespace {
+
+class TestFlatHashMap : public testing::Test {
+ public:
+  TestFlatHashMap() {}
+  ~TestFlatHashMap() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestFlatHashMap, FindOrInsert) {
+  FlatHashMap<uint32_t, int> map;
+  EXPECT_EQ(map.Find(3), nullptr);
+  *map.FindOrInsert(3) = 7;
+  EXPECT_EQ(*map.FindOrInsert(5), 0);
+  EXPECT_EQ(map.Size(), 2);
+  ASSERT_NE(map.Find(3), nullptr);
+  EXPECT_EQ(*map.Find(3), 7);
+}
+
+TEST_F(TestFlatHashMap, GrowWithIncrementalRehash) {
+  FlatHashMap<uint32_t, int> map;
+  // check the content at every step, including those in the middle of a migration
+  for (uint32_t i = 0; i < 5000; i++) {
+    *map.FindOrInsert(i * 7919) = i;
+    ASSERT_NE(map.Find(i / 2 * 7919), nullptr);
+    EXPECT_EQ(*map.Find(i / 2 * 7919), i / 2);
+  }
+  EXPECT_EQ(map.Size(), 5000);
+  EXPECT_GE(map.Capacity() * 7, map.Size() * 8);
+  EXPECT_EQ(map.Capacity() & (map.Capacity() - 1), 0);
+  for (uint32_t i = 0; i < 5000; i++) {
+    ASSERT_NE(map.Find(i * 7919), nullptr);
+    EXPECT_EQ(*map.Find(i * 7919), i);
+  }
+  EXPECT_EQ(map.Find(1), nullptr);
+}
+
+TEST_F(TestFlatHashMap, ForEach) {
+  FlatHashMap<uint32_t, int> map;
+  std::map<uint32_t, int> expected;
+  for (uint32_t i = 0; i < 100; i++) {
+    *map.FindOrInsert(i * 3) = i;
+    expected[i * 3] = i;
+  }
+  std::map<uint32_t, int> visited;
+  map.ForEach([&visited](uint32_t key, const int* block) { visited[key] = *block; });
+  EXPECT_EQ(visited, expected);
+}
+
+TEST_F(TestFlatHashMap, Erase) {
+  FlatHashMap<uint32_t, int> map;
+  // insert and erase far more keys than the capacity, so erased slots are reused and cleaned
+  for (uint32_t i = 0; i < 10000; i++) {
+    *map.FindOrInsert(i) = i + 1;
+    if (i >= 100)
+      ASSERT_TRUE(map.Erase(i - 100));
+  }
+  EXPECT_FALSE(map.Erase(5));
+  EXPECT_EQ(map.Size(), 100);
+  EXPECT_LE(map.Capacity(), 256);
+  for (uint32_t i = 0; i < 10000; i++) {
+    if (i < 9900) {
+      EXPECT_EQ(map.Find(i), nullptr);
+    } else {
+      ASSERT_NE(map.Find(i), nullptr);
+      EXPECT_EQ(*map.Find(i), i + 1);
+    }
+  }
+  // a key inserted again starts from zero
+  EXPECT_EQ(*map.FindOrInsert(3), 0);
+}
+
+TEST_F(TestFlatHashMap, Clear) {
+  FlatHashMap<uint32_t, int> map;
+  for (uint32_t i = 0; i < 1000; i++) {
+    *map.FindOrInsert(i) = i + 1;
+  }
+  size_t capacity = map.Capacity();
+  map.Clear();
+  EXPECT_EQ(map.Size(), 0);
+  EXPECT_EQ(map.Capacity(), capacity);
+  EXPECT_EQ(map.Find(5), nullptr);
+  EXPECT_EQ(*map.FindOrInsert(5), 0);
+}
+
+TEST_F(TestFlatHashMap, Blocks) {
+  FlatHashMap<uint32_t, int> map(3);
+  for (uint32_t i = 0; i < 1000; i++) {
+    int* block = map.FindOrInsert(i);
+    block[0] = i;
+    block[2] = i * 2;
+  }
+  for (uint32_t i = 0; i < 1000; i++) {
+    int* block = map.Find(i);
+    ASSERT_NE(block, nullptr);
+    EXPECT_EQ(block[0], i);
+    EXPECT_EQ(block[1], 0);
+    EXPECT_EQ(block[2], i * 2);
+  }
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+namespace csci5570 {
+
+// The finalizer of MurmurHash3, which spreads every bit of h over the whole result
+inline uint64_t Mix64(uint64_t h) {
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+}  // namespace csci5570
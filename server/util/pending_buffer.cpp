@@ -1,38 +1,82 @@
-#include "base/message.hpp"
-
-#include <unordered_map>
 #include "server/util/pending_buffer.hpp"
 
+#include "glog/logging.h"
+
 namespace csci5570 {
+
+const int PendingBuffer::kNoClock;
+
+PendingBuffer::PendingBuffer(int num_slots) : slots_(num_slots), slot_clocks_(num_slots, kNoClock) {
+  CHECK_GT(num_slots, 0);
+}
+
 std::vector<Message> PendingBuffer::Pop(const int clock) {
-  auto pos = buffer_.find(clock);
-  if ( pos == buffer_.end() ) {
-    printf("the pending buffer does not has this clock\n");
-  } else {
-    auto msgs = pos->second;
-    buffer_.erase(clock);
-    return msgs;
+  std::vector<Message> msgs;
+  Pop(clock, &msgs);
+  return msgs;
+}
+
+void PendingBuffer::Pop(const int clock, std::vector<Message>* msgs) {
+  int slot = SlotOf(clock);
+  if (slot_clocks_[slot] != clock) {  // no such clock in the buffer
+    return;
   }
+  CHECK(msgs->empty());
+  msgs->swap(slots_[slot]);
+  slot_clocks_[slot] = kNoClock;
+  total_size_ -= msgs->size();
 }
 
-void PendingBuffer::Push(const int clock, Message& msg) {
-  auto pos = buffer_.find(clock);
-  if ( pos == buffer_.end() ) { // no such clock in the buffer
-    std::vector<Message> tmp;
-    tmp.push_back(msg);
-    buffer_.insert(std::make_pair(clock, tmp));
-  } else {
-    (pos->second).push_back(msg);
+void PendingBuffer::Push(const int clock, Message&& msg) {
+  CHECK_GE(clock, 0);
+  int slot = SlotOf(clock);
+  if (slot_clocks_[slot] != kNoClock && slot_clocks_[slot] != clock) {
+    Grow(clock);
+    slot = SlotOf(clock);
   }
+  slot_clocks_[slot] = clock;
+  slots_[slot].push_back(std::move(msg));
+  total_size_ += 1;
+}
+
+int PendingBuffer::Size(const int progress) {  // this would return the pending buffer size of the specific progress clock
+  int slot = SlotOf(progress);
+  return slot_clocks_[slot] == progress ? slots_[slot].size() : 0;
 }
 
-int PendingBuffer::Size(const int progress) { // this would return the pending buffer size of the specific progress clock
-  auto pos = buffer_.find(progress);
-  if ( pos == buffer_.end() ) { // no such clock in the buffer
-    return 0;
-  } else {
-    std::vector<Message> msgs = pos->second;
-    return msgs.size();
+int PendingBuffer::SlotOf(int clock) const {
+  int num_slots = slots_.size();
+  return (clock % num_slots + num_slots) % num_slots;
+}
+
+void PendingBuffer::Grow(int clock) {
+  std::vector<std::vector<Message>> slots;
+  std::vector<int> slot_clocks;
+  slots.swap(slots_);
+  slot_clocks.swap(slot_clocks_);
+  int num_slots = slots.size();
+  bool fits = false;
+  while (!fits) {
+    num_slots *= 2;
+    std::vector<bool> used(num_slots, false);
+    used[(clock % num_slots + num_slots) % num_slots] = true;
+    fits = true;
+    for (int c : slot_clocks) {
+      if (c == kNoClock)
+        continue;
+      int slot = c % num_slots;
+      fits = fits && !used[slot];
+      used[slot] = true;
+    }
+  }
+  slots_.resize(num_slots);
+  slot_clocks_.assign(num_slots, kNoClock);
+  for (size_t i = 0; i < slots.size(); i++) {
+    if (slot_clocks[i] == kNoClock)
+      continue;
+    int slot = SlotOf(slot_clocks[i]);
+    slots_[slot].swap(slots[i]);
+    slot_clocks_[slot] = slot_clocks[i];
   }
 }
 
@@ -2,26 +2,60 @@
 
 #include "base/message.hpp"
 
-#include <unordered_map>
+#include <vector>
 
 namespace csci5570 {
 
+/**
+ * The requests waiting for the min clock to reach a clock, in a ring of slots indexed by the clock modulo the number
+ * of slots. Under SSP the requests wait for at most staleness + 1 clocks ahead of the min clock, so staleness + 2
+ * slots hold them all. A clock falling on a slot still holding another clock doubles the ring.
+ *
+ * The messages are moved in and out, and a slot keeps its capacity when popped with Pop(clock, msgs), so the
+ * requests deferred clock after clock are neither copied nor allocated for once the slots are large enough.
+ */
 class PendingBuffer {
  public:
+  /**
+   * @param num_slots   the clocks held at once before the ring grows
+   */
+  explicit PendingBuffer(int num_slots = 2);
+
   /**
    * Return the pending requests at the specific progress clock
    */
   virtual std::vector<Message> Pop(const int clock);
+  /**
+   * Swap the pending requests at the specific progress clock with msgs, which should be empty and whose capacity
+   * is kept for the later requests of the slot
+   */
+  virtual void Pop(const int clock, std::vector<Message>* msgs);
   /**
    * Add the pending requests at the specific progress clock
    */
-  virtual void Push(const int clock, Message& message);
+  virtual void Push(const int clock, Message&& message);
   /**
    * Return the number of pending requests at the specific progress
    */
   virtual int Size(const int progress);
-private:
-  std::map<int, std::vector<Message>> buffer_; // This should be a thread safe mapper
+  /**
+   * Return the number of pending requests at all clocks
+   */
+  int TotalSize() const { return total_size_; }
+
+  // the clocks held at once before the ring grows
+  int NumSlots() const { return slots_.size(); }
+
+ private:
+  static const int kNoClock = -1;
+
+  int SlotOf(int clock) const;
+  // Double the slots, until the clock and every clock held fall on different slots
+  void Grow(int clock);
+
+  std::vector<std::vector<Message>> slots_;
+  std::vector<int> slot_clocks_;  // the clock of the requests in each slot, kNoClock if none
+  int total_size_ = 0;
 };
 
 }  // namespace csci5570
@@ -43,9 +43,9 @@ TEST_F(TestPendingBuffer, PushAndPop) {
   m2.AddData(m1_keys);
   m2.AddData(m1_vals);
 
-  pending_buffer.Push(0, m1);
-  pending_buffer.Push(0, m1);
-  pending_buffer.Push(1, m2);
+  pending_buffer.Push(0, Message(m1));
+  pending_buffer.Push(0, Message(m1));
+  pending_buffer.Push(1, std::move(m2));
 
   EXPECT_EQ(pending_buffer.Size(0), 2);
   EXPECT_EQ(pending_buffer.Size(1), 1);
@@ -57,5 +57,43 @@ TEST_F(TestPendingBuffer, PushAndPop) {
   EXPECT_EQ(messages_1.size(), 1);
 }
 
+TEST_F(TestPendingBuffer, Ring) {
+  PendingBuffer pending_buffer(3);
+  Message msg;
+  msg.meta.flag = Flag::kGet;
+
+  // clocks 1 to 3 fall on different slots
+  for (int clock : {1, 2, 3, 3}) {
+    pending_buffer.Push(clock, Message(msg));
+  }
+  EXPECT_EQ(pending_buffer.NumSlots(), 3);
+  EXPECT_EQ(pending_buffer.Size(0), 0);
+  EXPECT_EQ(pending_buffer.Size(3), 2);
+  EXPECT_EQ(pending_buffer.Size(6), 0);
+
+  // a popped slot is reused by a later clock, and keeps the capacity given to it
+  std::vector<Message> msgs;
+  msgs.reserve(8);
+  pending_buffer.Pop(1, &msgs);
+  EXPECT_EQ(msgs.size(), 1);
+  EXPECT_EQ(pending_buffer.Size(1), 0);
+  msgs.clear();
+  pending_buffer.Pop(1, &msgs);
+  EXPECT_EQ(msgs.size(), 0);
+  pending_buffer.Push(4, Message(msg));
+  EXPECT_EQ(pending_buffer.NumSlots(), 3);
+  pending_buffer.Pop(4, &msgs);
+  EXPECT_EQ(msgs.size(), 1);
+  EXPECT_EQ(msgs.capacity(), 8);
+
+  // a clock beyond the slots grows the ring, keeping the requests held
+  pending_buffer.Push(5, Message(msg));
+  EXPECT_EQ(pending_buffer.NumSlots(), 6);
+  EXPECT_EQ(pending_buffer.Size(2), 1);
+  EXPECT_EQ(pending_buffer.Size(3), 2);
+  EXPECT_EQ(pending_buffer.Size(5), 1);
+  EXPECT_EQ(pending_buffer.Pop(3).size(), 2);
+}
+
 }  // namespace
 }  // namespace csci5570
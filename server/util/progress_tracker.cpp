@@ -1,92 +1,133 @@
 #include "server/util/progress_tracker.hpp"
 
-#include <fstream>
+#include <algorithm>
+#include <memory>
+#include <string>
+
+#include "server/util/checkpoint.hpp"
+
 #include "glog/logging.h"
 
 namespace csci5570 {
 
+const int ProgressTracker::kInvalid;
+
+ProgressTracker::ProgressTracker(int window) : counts_(window, 0) { CHECK_GT(window, 0); }
+
 void ProgressTracker::Init(const std::vector<uint32_t>& tids) {
-  // TODO
-  for (auto tid : tids) {
-    progresses_[tid] = 0;
-  }
-  min_clock_ = 0;
+  std::vector<int> int_tids(tids.begin(), tids.end());
+  std::vector<int> clocks(tids.size(), 0);
+  Reset(int_tids.data(), clocks.data(), tids.size());
 }
 
 int ProgressTracker::AdvanceAndGetChangedMinClock(int tid) {
-  // TODO
-  int rst;
-  if (IsUniqueMin(tid)) {
-    min_clock_++;
-    rst = min_clock_;
-  } else {
-    rst = -1;
-  }
-  progresses_[tid]++;
-  return rst;
+  CHECK(CheckThreadValid(tid)) << "thread " << tid << " is not tracked";
+  return AdvanceToAndGetChangedMinClock(tid, progresses_[tid - base_tid_] + 1);
 }
 
-int ProgressTracker::GetNumThreads() const {
-  // TODO
-  return progresses_.size();
+int ProgressTracker::AdvanceToAndGetChangedMinClock(int tid, int clock) {
+  CHECK(CheckThreadValid(tid)) << "thread " << tid << " is not tracked";
+  int& progress = progresses_[tid - base_tid_];
+  CHECK_GE(clock, progress) << "thread " << tid << " cannot go back";
+  if (clock == progress)
+    return -1;
+  Reserve(clock);
+  CountAt(progress) -= 1;
+  CountAt(clock) += 1;
+  progress = clock;
+  max_clock_ = std::max(max_clock_, progress);
+  if (CountAt(min_clock_) != 0)
+    return -1;
+  // the slowest workers moved on, and the min clock with them up to the next clock with a worker, this one at worst
+  while (CountAt(min_clock_) == 0) {
+    min_clock_ += 1;
+  }
+  return min_clock_;
 }
 
-int ProgressTracker::GetProgress(int tid) const {
-  // TODO
-  return progresses_.find(tid)->second;
-}
+int ProgressTracker::GetNumThreads() const { return num_threads_; }
 
-int ProgressTracker::GetMinClock() const {
-  // TODO
-  return min_clock_;
+int ProgressTracker::GetProgress(int tid) const { return progresses_[tid - base_tid_]; }
+
+int ProgressTracker::GetMinClock() const { return min_clock_; }
+
+int ProgressTracker::GetMaxClock() const { return max_clock_; }
+
+int ProgressTracker::GetNumAhead(int clock) const {
+  if (clock < min_clock_)
+    return num_threads_;
+  int num_ahead = 0;
+  for (int c = clock + 1; c <= max_clock_; c++) {
+    num_ahead += counts_[c % counts_.size()];
+  }
+  return num_ahead;
 }
 
 bool ProgressTracker::IsUniqueMin(int tid) const {
-  // TODO
-  for (auto pair : progresses_) {
-    if (pair.second == min_clock_ && pair.first != tid)
-      return false;
-  }
-  return true;
+  int others = counts_[min_clock_ % counts_.size()];
+  if (CheckThreadValid(tid) && GetProgress(tid) == min_clock_)
+    others -= 1;
+  return others == 0;
 }
 
 bool ProgressTracker::CheckThreadValid(int tid) const {
-  // TODO
-  return progresses_.find(tid) != progresses_.end();
+  return tid >= base_tid_ && tid - base_tid_ < static_cast<int64_t>(progresses_.size()) &&
+         progresses_[tid - base_tid_] != kInvalid;
 }
 
-void ProgressTracker::Backup(int model_id) {
-  std::ofstream outfile;
-  std::string path = "/data/tracker" + std::to_string(model_id) + ".txt";
-  outfile.open(path);
-  outfile << min_clock_ << "\n";
-  for (auto iter = progresses_.begin(); iter != progresses_.end(); ++iter) {
-    outfile << iter->first << " " << iter->second << "\n";
+std::function<void()> ProgressTracker::Snapshot(int model_id) const {
+  std::shared_ptr<KVSnapshot<int, int>> snapshot(new KVSnapshot<int, int>(1));
+  for (size_t i = 0; i < progresses_.size(); i++) {
+    if (progresses_[i] != kInvalid)
+      snapshot->Add(base_tid_ + i, &progresses_[i]);
   }
-  outfile.close();
+  std::string path = checkpoint_prefix_ + "tracker" + std::to_string(model_id) + ".ckpt";
+  return [snapshot, path]() { snapshot->Write(path); };
 }
 
+void ProgressTracker::Backup(int model_id) { Snapshot(model_id)(); }
+
 int ProgressTracker::Recovery(int model_id) {
-  std::ifstream ifs;
-  std::string path = "/data/tracker" + std::to_string(model_id) + ".txt";
-  ifs.open(path, std::ifstream::in);
-  std::string s;
-  ifs >> s;
-  min_clock_ = std::stoi(s);
-  int count = 0;
-  int tid;
-  int clock;
-  while (ifs >> s) {
-    if (count % 2 == 0) {
-      tid = std::stoi(s);
-    } else {
-      clock = std::stoi(s);
-      progresses_[tid] = clock;
-    }
-    count++;
-  }
-  ifs.close();
+  CheckpointReader reader(checkpoint_prefix_ + "tracker" + std::to_string(model_id) + ".ckpt");
+  const int* tids;
+  const int* clocks;
+  int64_t num_tids = ReadKVCheckpoint(&reader, 1, &tids, &clocks);
+  if (num_tids == -1)
+    return min_clock_;
+  Reset(tids, clocks, num_tids);
   return min_clock_;
 }
 
+void ProgressTracker::Reset(const int* tids, const int* clocks, int64_t num_tids) {
+  progresses_.clear();
+  num_threads_ = num_tids;
+  std::fill(counts_.begin(), counts_.end(), 0);
+  // the min clock is the slowest progress
+  min_clock_ = num_tids == 0 ? 0 : *std::min_element(clocks, clocks + num_tids);
+  max_clock_ = num_tids == 0 ? 0 : *std::max_element(clocks, clocks + num_tids);
+  if (num_tids == 0)
+    return;
+  base_tid_ = *std::min_element(tids, tids + num_tids);
+  progresses_.assign(*std::max_element(tids, tids + num_tids) - base_tid_ + 1, kInvalid);
+  for (int64_t i = 0; i < num_tids; i++) {
+    progresses_[tids[i] - base_tid_] = clocks[i];
+    Reserve(clocks[i]);
+    CountAt(clocks[i]) += 1;
+  }
+}
+
+void ProgressTracker::Reserve(int clock) {
+  size_t window = counts_.size();
+  if (clock - min_clock_ < static_cast<int>(window))
+    return;
+  while (clock - min_clock_ >= static_cast<int>(window)) {
+    window *= 2;
+  }
+  std::vector<int> counts(window, 0);
+  for (int c = min_clock_; c < min_clock_ + static_cast<int>(counts_.size()); c++) {
+    counts[c % window] = CountAt(c);
+  }
+  counts_.swap(counts);
+}
+
 }  // namespace csci5570
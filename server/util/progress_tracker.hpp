@@ -1,12 +1,28 @@
 #pragma once
 
-#include <map>
+#include <cstdint>
+#include <functional>
+#include <string>
 #include <vector>
 
 namespace csci5570 {
 
+/**
+ * Tracks the progress of each worker thread of a model, and the min clock.
+ *
+ * The progresses are kept in an array indexed by the tid minus the smallest tid, the worker threads of a job having
+ * close ids, and the workers at each clock from the min clock on are counted in a ring indexed by the clock modulo
+ * its size. Under SSP the progresses stay within staleness + 1 of the min clock, so staleness + 2 counts cover them,
+ * and the ring doubles if a worker goes further. Advancing a worker and every query are then O(1) whatever the
+ * number of workers.
+ */
 class ProgressTracker {
  public:
+  /**
+   * @param window    the clocks from the min clock counted before the ring grows
+   */
+  explicit ProgressTracker(int window = 2);
+
   void Init(const std::vector<uint32_t>& tids);
   /**
    * Advance the progress of a worker thread
@@ -16,6 +32,15 @@ class ProgressTracker {
    * @param tid worker thread id
    */
   int AdvanceAndGetChangedMinClock(int tid);
+  /**
+   * Advance the progress of a worker thread to a clock not before it, skipping the clocks in between
+   * Return -1 if min_clock_ does not change,
+   * return min_clock_ otherwise, which may have moved by more than one.
+   *
+   * @param tid worker thread id
+   * @param clock the new progress
+   */
+  int AdvanceToAndGetChangedMinClock(int tid, int clock);
   /**
    * Get the progress of a worker thread
    *
@@ -26,6 +51,16 @@ class ProgressTracker {
    * Get the progress of the slowest worker
    */
   int GetMinClock() const;
+  /**
+   * Get the progress of the fastest worker
+   */
+  int GetMaxClock() const;
+  /**
+   * Get the number of workers whose progress is beyond a clock
+   *
+   * @param clock the clock
+   */
+  int GetNumAhead(int clock) const;
   /**
    * Get the number of workers in the trace
    */
@@ -43,13 +78,39 @@ class ProgressTracker {
    */
   bool CheckThreadValid(int tid) const;
 
+  /**
+   * Copy the progresses and return a task writing the copy to a binary checkpoint
+   */
+  std::function<void()> Snapshot(int model_id) const;
+  /**
+   * Write the progresses to a binary checkpoint
+   */
   void Backup(int model_id);
-
+  /**
+   * Restore the progresses from the checkpoint written by Backup and return the min clock
+   */
   int Recovery(int model_id);
+  /**
+   * Write the checkpoints to <prefix>tracker<model_id>.ckpt
+   */
+  void SetCheckpointPrefix(const std::string& prefix) { checkpoint_prefix_ = prefix; }
 
  private:
-  std::map<int, int> progresses_;  // {tid: progress}
-  int min_clock_;                  // the slowest progress
+  static const int kInvalid = -1;
+
+  // Reset the progresses of the tids to their clocks
+  void Reset(const int* tids, const int* clocks, int64_t num_tids);
+  int& CountAt(int clock) { return counts_[clock % counts_.size()]; }
+  // Make room in the ring for the clock
+  void Reserve(int clock);
+
+  int base_tid_ = 0;
+  std::vector<int> progresses_;  // the progress of tid base_tid_ + i, kInvalid if not tracked
+  int num_threads_ = 0;
+  std::vector<int> counts_;  // the workers at each clock from min_clock_ on, at the clock modulo the size
+  int min_clock_ = 0;        // the slowest progress
+  int max_clock_ = 0;        // the fastest progress
+  std::string checkpoint_prefix_ = "/data/";
 };
 
 }  // namespace csci5570
@@ -46,5 +46,53 @@ TEST_F(TestProgressTracker, Advance) {
   EXPECT_EQ(tracker.GetProgress(7), 3);
 }
 
+TEST_F(TestProgressTracker, IsUniqueMin) {
+  ProgressTracker tracker;
+  tracker.Init({2, 7});
+  EXPECT_FALSE(tracker.IsUniqueMin(2));
+  tracker.AdvanceAndGetChangedMinClock(2);  // [1,0]
+  EXPECT_FALSE(tracker.IsUniqueMin(2));
+  EXPECT_TRUE(tracker.IsUniqueMin(7));
+}
+
+TEST_F(TestProgressTracker, GrowWindow) {
+  // a worker running further ahead than the window from the min clock
+  ProgressTracker tracker(2);
+  tracker.Init({100, 101, 102});
+  for (int i = 0; i < 5; i++) {
+    EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(100), -1);
+  }
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(101), -1);
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(102), 1);  // [5,1,1]
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(101), -1);
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(102), 2);  // [5,2,2]
+  for (int i = 0; i < 3; i++) {
+    EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(101), -1);
+  }
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(102), 3);  // [5,5,3]
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(102), 4);
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(102), 5);
+  EXPECT_EQ(tracker.GetMinClock(), 5);
+  EXPECT_EQ(tracker.GetNumThreads(), 3);
+  EXPECT_FALSE(tracker.CheckThreadValid(99));
+  EXPECT_FALSE(tracker.CheckThreadValid(103));
+}
+
+TEST_F(TestProgressTracker, AdvanceTo) {
+  ProgressTracker tracker(2);
+  tracker.Init({100, 101, 102});
+  EXPECT_EQ(tracker.AdvanceToAndGetChangedMinClock(100, 3), -1);  // [3,0,0]
+  EXPECT_EQ(tracker.AdvanceAndGetChangedMinClock(101), -1);        // [3,1,0]
+  EXPECT_EQ(tracker.GetNumAhead(0), 2);
+  EXPECT_EQ(tracker.GetNumAhead(1), 1);
+  EXPECT_EQ(tracker.GetNumAhead(3), 0);
+  EXPECT_EQ(tracker.AdvanceToAndGetChangedMinClock(102, 3), 1);  // [3,1,3]
+  // the min clock skips the clock 2 no worker is at
+  EXPECT_EQ(tracker.AdvanceToAndGetChangedMinClock(101, 3), 3);  // [3,3,3]
+  EXPECT_EQ(tracker.AdvanceToAndGetChangedMinClock(101, 3), -1);
+  EXPECT_EQ(tracker.GetNumAhead(2), 3);
+  EXPECT_EQ(tracker.GetMaxClock(), 3);
+}
+
 }  // namespace
 }  // namespace csci5570
@@ -0,0 +1,64 @@
+#include "server/util/refresher.hpp"
+
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+Refresher::Refresher(uint32_t model_id, ThreadsafeQueue<Message>* reply_queue, int ttl)
+    : model_id_(model_id), reply_queue_(reply_queue), ttl_(ttl) {
+  CHECK_GT(ttl, 0);
+}
+
+void Refresher::Subscribe(const Message& get) {
+  sid_ = get.meta.recver;
+  auto& subscribed = keys_[get.meta.sender];
+  for (Key key : third_party::SArray<Key>(get.data[0])) {
+    subscribed[key] = num_refreshes_;
+  }
+}
+
+std::vector<Key> Refresher::GetKeys(uint32_t tid) const {
+  std::vector<Key> keys;
+  for (const auto& key : keys_.at(tid)) {
+    keys.push_back(key.first);
+  }
+  return keys;
+}
+
+void Refresher::CountUpdate(const Message& update) { num_updates_[update.meta.sender] += 1; }
+
+void Refresher::Refresh(AbstractStorage* storage, int max_clock) {
+  for (auto subscriber = keys_.begin(); subscriber != keys_.end();) {
+    third_party::SArray<Key> keys;
+    auto& subscribed = subscriber->second;
+    for (auto key = subscribed.begin(); key != subscribed.end();) {
+      if (num_refreshes_ - key->second >= ttl_) {
+        key = subscribed.erase(key);
+      } else {
+        keys.push_back(key->first);
+        ++key;
+      }
+    }
+    if (keys.empty()) {
+      subscriber = keys_.erase(subscriber);
+      continue;
+    }
+    Message get;
+    get.meta.sender = subscriber->first;
+    get.meta.recver = sid_;
+    get.meta.model_id = model_id_;
+    get.meta.flag = Flag::kGet;
+    get.AddData(keys);
+    Message msg = storage->Get(get);
+    msg.meta.flag = Flag::kRefresh;
+    msg.meta.round = max_clock;
+    msg.AddData(third_party::SArray<uint64_t>(1, num_updates_[subscriber->first]));
+    reply_queue_->Push(msg);
+    ++subscriber;
+  }
+  num_refreshes_ += 1;
+}
+
+}  // namespace csci5570
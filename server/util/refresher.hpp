@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include "base/magic.hpp"
+#include "base/message.hpp"
+#include "base/third_party/sarray.h"
+#include "base/threadsafe_queue.hpp"
+#include "server/abstract_storage.hpp"
+
+namespace csci5570 {
+
+/*
+ * Pushes the rows each worker reads from a shard of an eager SSP model to the worker whenever the min clock
+ * advances, so the worker finds fresh rows in its cache at its next Get instead of waiting for a reply.
+ *
+ * A worker subscribes to the keys of the Gets it makes to the shard, and a key is pushed for ttl advances after
+ * its last Get only, so the pushes follow the keys the worker currently reads rather than every key it ever read.
+ * The reads a worker serves from its cache do not reach the shard: a key read that way only is dropped after ttl
+ * advances, and subscribed again at the Get of the next miss. Each kRefresh carries the largest clock of the
+ * worker still allowed to read the rows, and the number of updates of the worker the rows hold: the worker uses
+ * them only while its clock is within the bound and once they hold every update it sent, so it reads its own writes.
+ */
+class Refresher {
+ public:
+  /**
+   * @param model_id      the model
+   * @param reply_queue   where the kRefresh are put
+   * @param ttl           the refreshes a key is pushed for after its last Get
+   */
+  Refresher(uint32_t model_id, ThreadsafeQueue<Message>* reply_queue, int ttl = 4);
+
+  /**
+   * Subscribe the sender of a Get to its keys
+   */
+  void Subscribe(const Message& get);
+  /**
+   * Count an Add or Push applied to the storage
+   */
+  void CountUpdate(const Message& update);
+  /**
+   * Send each subscriber the rows of its keys, after dropping those not read for ttl refreshes
+   *
+   * @param storage     the storage of the shard
+   * @param max_clock   the largest clock of a worker allowed to read the rows
+   */
+  void Refresh(AbstractStorage* storage, int max_clock);
+
+  size_t NumSubscribers() const { return keys_.size(); }
+  // the keys the worker subscribed to, sorted
+  std::vector<Key> GetKeys(uint32_t tid) const;
+
+ private:
+  uint32_t model_id_;
+  uint32_t sid_ = 0;                       // the server thread of the shard, the receiver of the Gets
+  ThreadsafeQueue<Message>* reply_queue_;  // not owned
+
+  int ttl_;
+  int num_refreshes_ = 0;
+
+  std::map<uint32_t, std::map<Key, int>> keys_;         // {worker: {key it read: num_refreshes_ at the last Get}}
+  std::unordered_map<uint32_t, uint64_t> num_updates_;  // {worker: its updates applied}
+};
+
+}  // namespace csci5570
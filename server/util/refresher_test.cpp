@@ -0,0 +1,106 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/map_storage.hpp"
+#include "server/util/refresher.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestRefresher : public testing::Test {
+ public:
+  TestRefresher() {}
+  ~TestRefresher() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+Message MakeGet(const std::vector<Key>& keys, int sender, int recver) {
+  Message msg;
+  msg.meta.sender = sender;
+  msg.meta.recver = recver;
+  msg.meta.model_id = 0;
+  msg.meta.flag = Flag::kGet;
+  msg.AddData(third_party::SArray<Key>(keys));
+  return msg;
+}
+
+TEST_F(TestRefresher, MergeSubscriptions) {
+  ThreadsafeQueue<Message> queue;
+  Refresher refresher(0, &queue);
+  refresher.Subscribe(MakeGet({5, 1}, 100, 1));
+  refresher.Subscribe(MakeGet({1}, 100, 1));
+  refresher.Subscribe(MakeGet({3, 5}, 100, 1));
+  refresher.Subscribe(MakeGet({2}, 101, 1));
+  EXPECT_EQ(refresher.NumSubscribers(), 2);
+  EXPECT_EQ(refresher.GetKeys(100), std::vector<Key>({1, 3, 5}));
+}
+
+TEST_F(TestRefresher, DropStaleKeys) {
+  ThreadsafeQueue<Message> queue;
+  Refresher refresher(0, &queue, 2);
+  MapStorage<int> storage;
+  // the minibatches of a sparse model read different keys at each clock
+  refresher.Subscribe(MakeGet({1, 2}, 100, 1));
+  refresher.Refresh(&storage, 0);
+  refresher.Subscribe(MakeGet({3}, 100, 1));
+  refresher.Subscribe(MakeGet({4}, 101, 1));
+  refresher.Refresh(&storage, 1);
+  EXPECT_EQ(refresher.GetKeys(100), std::vector<Key>({1, 2, 3}));
+  refresher.Subscribe(MakeGet({2}, 100, 1));
+  refresher.Refresh(&storage, 2);
+  // 1 was last read two refreshes ago
+  EXPECT_EQ(refresher.GetKeys(100), std::vector<Key>({2, 3}));
+  refresher.Refresh(&storage, 3);
+  refresher.Refresh(&storage, 4);
+  // a worker without keys left is dropped
+  EXPECT_EQ(refresher.NumSubscribers(), 0);
+
+  std::vector<std::vector<Key>> expected_keys = {{1, 2}, {1, 2, 3}, {4}, {2, 3}, {4}, {2}};
+  ASSERT_EQ(queue.Size(), expected_keys.size());
+  for (const auto& keys : expected_keys) {
+    Message msg;
+    queue.WaitAndPop(&msg);
+    auto pushed = third_party::SArray<Key>(msg.data[0]);
+    EXPECT_EQ(std::vector<Key>(pushed.begin(), pushed.end()), keys);
+  }
+}
+
+TEST_F(TestRefresher, Refresh) {
+  ThreadsafeQueue<Message> queue;
+  Refresher refresher(0, &queue);
+  MapStorage<int> storage;
+  Message add;
+  add.meta.sender = 101;
+  add.AddData(third_party::SArray<Key>({4, 5}));
+  add.AddData(third_party::SArray<int>({40, 50}));
+  storage.Add(add);
+  refresher.CountUpdate(add);
+  refresher.CountUpdate(add);
+  refresher.Subscribe(MakeGet({4}, 100, 1));
+  refresher.Subscribe(MakeGet({5, 4}, 101, 1));
+
+  refresher.Refresh(&storage, 3);
+  ASSERT_EQ(queue.Size(), 2);
+  std::vector<std::vector<int>> expected_vals = {{40}, {40, 50}};
+  std::vector<uint64_t> expected_updates = {0, 2};
+  for (int i = 0; i < 2; i++) {
+    Message msg;
+    queue.WaitAndPop(&msg);
+    EXPECT_EQ(msg.meta.flag, Flag::kRefresh);
+    EXPECT_EQ(msg.meta.sender, 1);
+    EXPECT_EQ(msg.meta.recver, 100 + i);
+    EXPECT_EQ(msg.meta.round, 3);
+    ASSERT_EQ(msg.data.size(), 3);
+    auto vals = third_party::SArray<int>(msg.data[1]);
+    EXPECT_EQ(std::vector<int>(vals.begin(), vals.end()), expected_vals[i]);
+    EXPECT_EQ(third_party::SArray<uint64_t>(msg.data[2])[0], expected_updates[i]);
+  }
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,163 @@
+#include "server/util/replicator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+const size_t Replicator::kSketchWidth;
+
+Replicator::Replicator(const ReplicationConfig& config, uint32_t model_id, uint32_t sid,
+                       const std::vector<uint32_t>& replica_sids, ThreadsafeQueue<Message>* reply_queue)
+    : config_(config),
+      model_id_(model_id),
+      sid_(sid),
+      replica_sids_(replica_sids),
+      reply_queue_(reply_queue),
+      sketch_(kSketchWidth) {
+  CHECK_GT(config_.min_count, 0);
+  CHECK_LT(config_.min_count, UINT16_MAX) << "the sketch counts up to " << UINT16_MAX;
+}
+
+void Replicator::Record(const Message& get, Message* reply) {
+  auto typed_keys = third_party::SArray<Key>(get.data[0]);
+  third_party::SArray<Key> hot_keys;
+  for (Key key : typed_keys) {
+    if (hot_.Find(key) != nullptr) {
+      hot_keys.push_back(key);
+    } else if (hot_.Size() + candidates_.size() < config_.max_keys && sketch_.Increment(key) == config_.min_count) {
+      candidates_.push_back(key);
+    }
+  }
+  if (!hot_keys.empty()) {
+    reply->AddData(hot_keys);
+    reply->AddData(replica_sids_);
+  }
+}
+
+void Replicator::CountUpdate(const Message& update) { num_updates_[update.meta.sender] += 1; }
+
+void Replicator::Refresh(AbstractStorage* storage, int min_clock) {
+  for (Key key : candidates_) {
+    if (hot_.Find(key) == nullptr) {
+      *hot_.FindOrInsert(key) = 1;
+      hot_keys_.push_back(key);
+    }
+  }
+  if (!candidates_.empty())
+    std::sort(hot_keys_.begin(), hot_keys_.end());
+  candidates_.clear();
+  if (hot_keys_.empty())
+    return;
+
+  Message get;
+  get.meta.sender = sid_;
+  get.meta.recver = sid_;
+  get.meta.model_id = model_id_;
+  get.meta.flag = Flag::kGet;
+  get.AddData(third_party::SArray<Key>(hot_keys_));
+  Message rows = storage->Get(get);
+  third_party::SArray<uint32_t> tids;
+  third_party::SArray<uint64_t> num_updates;
+  for (const auto& worker : num_updates_) {
+    tids.push_back(worker.first);
+    num_updates.push_back(worker.second);
+  }
+  rows.AddData(tids);
+  rows.AddData(num_updates);
+  for (uint32_t sid : replica_sids_) {
+    Message msg;
+    msg.meta.sender = sid_;
+    msg.meta.recver = sid;
+    msg.meta.model_id = model_id_;
+    msg.meta.flag = Flag::kReplicate;
+    msg.meta.round = min_clock;
+    msg.data = rows.data;
+    reply_queue_->Push(msg);
+  }
+}
+
+void Replicator::Update(const Message& msg) {
+  CHECK(msg.data.size() == 4);
+  auto typed_keys = third_party::SArray<Key>(msg.data[0]);
+  const auto& vals = msg.data[1];
+  auto tids = third_party::SArray<uint32_t>(msg.data[2]);
+  auto num_updates = third_party::SArray<uint64_t>(msg.data[3]);
+  CHECK_EQ(tids.size(), num_updates.size());
+  auto& applied = applied_[msg.meta.sender];
+  for (size_t i = 0; i < tids.size(); i++) {
+    applied[tids[i]] = num_updates[i];
+  }
+  if (typed_keys.empty())
+    return;
+  if (row_bytes_ == 0)
+    row_bytes_ = vals.size() / typed_keys.size();
+  CHECK_EQ(vals.size(), typed_keys.size() * row_bytes_);
+  for (size_t i = 0; i < typed_keys.size(); i++) {
+    uint32_t* row = rows_.FindOrInsert(typed_keys[i]);
+    if (*row == 0) {
+      versions_.push_back(0);
+      replica_rows_.resize(replica_rows_.size() + row_bytes_);
+      *row = versions_.size();
+    }
+    std::memcpy(&replica_rows_[(*row - 1) * row_bytes_], &vals[i * row_bytes_], row_bytes_);
+    versions_[*row - 1] = msg.meta.round;
+  }
+
+  std::vector<PendingGet> waiting;
+  waiting.swap(pending_);
+  for (auto& get : waiting) {
+    if (!TryServe(get))
+      pending_.push_back(std::move(get));
+  }
+}
+
+void Replicator::Get(const Message& msg, int min_version, int round, bool own_updates) {
+  PendingGet get{min_version, round, own_updates, msg};
+  if (!TryServe(get))
+    pending_.push_back(std::move(get));
+}
+
+bool Replicator::TryServe(const PendingGet& get) {
+  auto typed_keys = third_party::SArray<Key>(get.msg.data[0]);
+  // a key just turned hot may be read before its first rows arrive
+  for (Key key : typed_keys) {
+    const uint32_t* row = rows_.Find(key);
+    if (row == nullptr || versions_[*row - 1] < get.min_version)
+      return false;
+  }
+  // the updates of the worker to each primary of the keys: [primary sids][number of updates]
+  if (get.own_updates && get.msg.data.size() == 3) {
+    auto primaries = third_party::SArray<uint32_t>(get.msg.data[1]);
+    auto num_updates = third_party::SArray<uint64_t>(get.msg.data[2]);
+    for (size_t i = 0; i < primaries.size(); i++) {
+      if (num_updates[i] == 0)
+        continue;
+      auto applied = applied_.find(primaries[i]);
+      if (applied == applied_.end())
+        return false;
+      auto worker = applied->second.find(get.msg.meta.sender);
+      if (worker == applied->second.end() || worker->second < num_updates[i])
+        return false;
+    }
+  }
+  third_party::SArray<char> vals(typed_keys.size() * row_bytes_);
+  for (size_t i = 0; i < typed_keys.size(); i++) {
+    std::memcpy(&vals[i * row_bytes_], &replica_rows_[(*rows_.Find(typed_keys[i]) - 1) * row_bytes_], row_bytes_);
+  }
+  // answered like a Get from the primary
+  Message reply;
+  reply.meta.sender = get.msg.meta.recver;
+  reply.meta.recver = get.msg.meta.sender;
+  reply.meta.model_id = get.msg.meta.model_id;
+  reply.meta.flag = Flag::kGet;
+  reply.meta.round = get.round;
+  reply.AddData(typed_keys);
+  reply.AddData(vals);
+  reply_queue_->Push(reply);
+  return true;
+}
+
+}  // namespace csci5570
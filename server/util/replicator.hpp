@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "base/magic.hpp"
+#include "base/message.hpp"
+#include "base/threadsafe_queue.hpp"
+#include "server/abstract_storage.hpp"
+#include "server/util/feature_filter.hpp"
+#include "server/util/flat_hash_map.hpp"
+
+namespace csci5570 {
+
+/*
+ * How a table replicates its hot keys. 0 replicas disables the replication.
+ */
+struct ReplicationConfig {
+  uint32_t num_replicas = 0;  // the shards after the primary of a key, in server order, also serving its reads
+  uint32_t min_count = 64;    // a key turns hot once read min_count times, as counted by a sketch
+  uint32_t max_keys = 1024;   // the hot keys per shard, which stay hot once they are
+};
+
+/*
+ * Replicates the hot keys of a shard of a model to other shards, so the reads of a skewed workload spread over
+ * several server threads instead of making one of them the straggler. Updates still go to the primary shard.
+ *
+ * As the primary of its keys, the replicator counts the keys read from the shard and turns the most read ones
+ * hot. Each time the min clock advances, it sends the rows of the hot keys to the replicas, versioned by the min
+ * clock. The replies to Gets carry the hot keys among the requested ones and the replicas, so the workers learn
+ * where else to read them.
+ *
+ * As a replica, it keeps the rows of the hot keys of other shards and serves the kGetReplica of a worker once the
+ * rows are recent enough for the consistency of the model, so the reads get the same guarantee as at the primary.
+ * Where the primary applies the updates of a worker at once, as SSP does, the worker reads its own writes there,
+ * so the rows also carry the number of updates of each worker they hold, and a kGetReplica carrying the updates
+ * the worker sent to the primaries waits until the rows hold them all.
+ */
+class Replicator {
+ public:
+  static const size_t kSketchWidth = 1 << 16;
+
+  /**
+   * @param config        see ReplicationConfig
+   * @param model_id      the model
+   * @param sid           the server thread of this shard
+   * @param replica_sids  the server threads replicating the hot keys of this shard
+   * @param reply_queue   where the rows for the replicas and the replies to kGetReplica are put
+   */
+  Replicator(const ReplicationConfig& config, uint32_t model_id, uint32_t sid,
+             const std::vector<uint32_t>& replica_sids, ThreadsafeQueue<Message>* reply_queue);
+
+  // ========== as a primary ========== //
+  /**
+   * Count the keys of a Get served by the storage, and append the hot ones and the replicas to its reply
+   */
+  void Record(const Message& get, Message* reply);
+  /**
+   * Count an Add or Push applied to the storage, for the models whose workers read their own writes
+   */
+  void CountUpdate(const Message& update);
+  /**
+   * Turn the keys read often enough hot, and send the rows of every hot key to the replicas
+   *
+   * @param storage     the storage of the shard
+   * @param min_clock   the min clock of the model, all updates of the earlier clocks being in the storage
+   */
+  void Refresh(AbstractStorage* storage, int min_clock);
+
+  // ========== as a replica ========== //
+  /**
+   * Keep the rows of a kReplicate, and serve the waiting kGetReplica they make recent enough
+   */
+  void Update(const Message& msg);
+  /**
+   * Serve a kGetReplica, or keep it until the rows of all its keys are at least of min_version
+   *
+   * @param round         the progress of the worker, returned in the reply
+   * @param own_updates   also wait until the rows hold the updates the worker sent to their primaries
+   */
+  void Get(const Message& msg, int min_version, int round, bool own_updates = false);
+
+  size_t NumHotKeys() const { return hot_keys_.size(); }
+  size_t NumReplicaKeys() const { return rows_.Size(); }
+  size_t NumPending() const { return pending_.size(); }
+
+ private:
+  struct PendingGet {
+    int min_version;
+    int round;
+    bool own_updates;
+    Message msg;
+  };
+
+  // Reply to the kGetReplica and return true if its rows are recent enough
+  bool TryServe(const PendingGet& get);
+
+  ReplicationConfig config_;
+  uint32_t model_id_;
+  uint32_t sid_;
+  third_party::SArray<uint32_t> replica_sids_;
+  ThreadsafeQueue<Message>* reply_queue_;  // not owned
+
+  CountMinSketch sketch_;
+  FlatHashMap<Key, char> hot_;  // the set of hot keys
+  std::vector<Key> hot_keys_;   // the hot keys, sorted
+  std::vector<Key> candidates_;  // the keys read min_count times since the last refresh
+  std::unordered_map<uint32_t, uint64_t> num_updates_;  // {worker: its updates applied}, if counted
+
+  FlatHashMap<Key, uint32_t> rows_;  // {key of another shard: its row, plus one}
+  std::vector<char> replica_rows_;   // row i at i * row_bytes_
+  std::vector<int> versions_;        // the min clock of the primary when row i was sent
+  // {primary: {worker: its updates the rows of the primary hold}}, all rows of a primary being sent together
+  std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint64_t>> applied_;
+  size_t row_bytes_ = 0;
+  std::vector<PendingGet> pending_;
+};
+
+}  // namespace csci5570
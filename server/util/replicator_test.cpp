@@ -0,0 +1,170 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/map_storage.hpp"
+#include "server/util/replicator.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestReplicator : public testing::Test {
+ public:
+  TestReplicator() {}
+  ~TestReplicator() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+Message MakeGet(const std::vector<Key>& keys, int sender, int recver) {
+  Message msg;
+  msg.meta.sender = sender;
+  msg.meta.recver = recver;
+  msg.meta.model_id = 0;
+  msg.meta.flag = Flag::kGet;
+  msg.AddData(third_party::SArray<Key>(keys));
+  return msg;
+}
+
+TEST_F(TestReplicator, ReplicateHotKeys) {
+  ThreadsafeQueue<Message> queue;
+  ReplicationConfig config;
+  config.num_replicas = 2;
+  config.min_count = 2;
+  Replicator replicator(config, 0, 1, {2, 3}, &queue);
+  MapStorage<int> storage;
+  Message add;
+  add.AddData(third_party::SArray<Key>({4, 5}));
+  add.AddData(third_party::SArray<int>({40, 50}));
+  storage.Add(add);
+
+  // key 4 is read twice and turns hot at the next refresh
+  Message get = MakeGet({4, 5}, 100, 1);
+  Message reply;
+  replicator.Record(get, &reply);
+  replicator.Record(MakeGet({4}, 101, 1), &reply);
+  EXPECT_EQ(reply.data.size(), 0);
+  replicator.Refresh(&storage, 3);
+  EXPECT_EQ(replicator.NumHotKeys(), 1);
+
+  // the rows go to each replica, versioned by the min clock
+  ASSERT_EQ(queue.Size(), 2);
+  for (int sid : {2, 3}) {
+    Message msg;
+    queue.WaitAndPop(&msg);
+    EXPECT_EQ(msg.meta.flag, Flag::kReplicate);
+    EXPECT_EQ(msg.meta.sender, 1);
+    EXPECT_EQ(msg.meta.recver, sid);
+    EXPECT_EQ(msg.meta.round, 3);
+    auto keys = third_party::SArray<Key>(msg.data[0]);
+    auto vals = third_party::SArray<int>(msg.data[1]);
+    ASSERT_EQ(keys.size(), 1);
+    EXPECT_EQ(keys[0], 4);
+    EXPECT_EQ(vals[0], 40);
+  }
+
+  // the replies name the hot keys read and the replicas
+  Message tagged;
+  replicator.Record(get, &tagged);
+  ASSERT_EQ(tagged.data.size(), 2);
+  auto hot_keys = third_party::SArray<Key>(tagged.data[0]);
+  auto replica_sids = third_party::SArray<uint32_t>(tagged.data[1]);
+  EXPECT_EQ(std::vector<Key>(hot_keys.begin(), hot_keys.end()), std::vector<Key>({4}));
+  EXPECT_EQ(std::vector<uint32_t>(replica_sids.begin(), replica_sids.end()), std::vector<uint32_t>({2, 3}));
+}
+
+TEST_F(TestReplicator, ServeRecentRows) {
+  ThreadsafeQueue<Message> queue;
+  Replicator replicator(ReplicationConfig(), 0, 2, {3}, &queue);
+
+  // a read of a key with no rows yet waits
+  replicator.Get(MakeGet({4}, 100, 2), 0, 0);
+  EXPECT_EQ(replicator.NumPending(), 1);
+
+  Message update;
+  update.meta.sender = 1;
+  update.meta.flag = Flag::kReplicate;
+  update.meta.round = 3;
+  update.AddData(third_party::SArray<Key>({4, 6}));
+  update.AddData(third_party::SArray<int>({40, 60}));
+  update.AddData(third_party::SArray<uint32_t>());
+  update.AddData(third_party::SArray<uint64_t>());
+  replicator.Update(update);
+  EXPECT_EQ(replicator.NumReplicaKeys(), 2);
+  EXPECT_EQ(replicator.NumPending(), 0);
+  ASSERT_EQ(queue.Size(), 1);
+  Message reply;
+  queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.flag, Flag::kGet);
+  EXPECT_EQ(reply.meta.sender, 2);
+  EXPECT_EQ(reply.meta.recver, 100);
+
+  // a read needing the updates of clock 3 waits for the rows of version 4
+  replicator.Get(MakeGet({6, 4}, 101, 2), 4, 4);
+  EXPECT_EQ(replicator.NumPending(), 1);
+  update.meta.round = 4;
+  update.data[1] = third_party::SArray<char>(third_party::SArray<int>({41, 61}));
+  replicator.Update(update);
+  EXPECT_EQ(replicator.NumPending(), 0);
+  ASSERT_EQ(queue.Size(), 1);
+  queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.round, 4);
+  auto vals = third_party::SArray<int>(reply.data[1]);
+  EXPECT_EQ(std::vector<int>(vals.begin(), vals.end()), std::vector<int>({61, 41}));
+}
+
+TEST_F(TestReplicator, ServeOwnUpdates) {
+  ThreadsafeQueue<Message> queue;
+  ReplicationConfig config;
+  config.num_replicas = 1;
+  config.min_count = 1;
+  Replicator primary(config, 0, 1, {2}, &queue);
+  Replicator replica(config, 0, 2, {3}, &queue);
+  MapStorage<int> storage;
+  Message reply;
+  primary.Record(MakeGet({4}, 100, 1), &reply);
+
+  // worker 100 updates key 4 at the primary, after the rows of version 3 were sent
+  primary.Refresh(&storage, 3);
+  Message msg;
+  queue.WaitAndPop(&msg);
+  replica.Update(msg);
+  Message add;
+  add.meta.sender = 100;
+  add.AddData(third_party::SArray<Key>({4}));
+  add.AddData(third_party::SArray<int>({1}));
+  storage.Add(add);
+  primary.CountUpdate(add);
+
+  // its read of version 3 waits for the rows holding its update, another worker's does not
+  Message get = MakeGet({4}, 100, 2);
+  get.meta.flag = Flag::kGetReplica;
+  get.AddData(third_party::SArray<uint32_t>({1}));
+  get.AddData(third_party::SArray<uint64_t>({1}));
+  replica.Get(get, 3, 3, true);
+  EXPECT_EQ(replica.NumPending(), 1);
+  Message other = MakeGet({4}, 101, 2);
+  other.meta.flag = Flag::kGetReplica;
+  other.AddData(third_party::SArray<uint32_t>({1}));
+  other.AddData(third_party::SArray<uint64_t>({0}));
+  replica.Get(other, 3, 3, true);
+  ASSERT_EQ(queue.Size(), 1);
+  queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.recver, 101);
+  EXPECT_EQ(third_party::SArray<int>(reply.data[1])[0], 0);
+
+  primary.Refresh(&storage, 3);
+  queue.WaitAndPop(&msg);
+  replica.Update(msg);
+  EXPECT_EQ(replica.NumPending(), 0);
+  ASSERT_EQ(queue.Size(), 1);
+  queue.WaitAndPop(&reply);
+  EXPECT_EQ(reply.meta.recver, 100);
+  EXPECT_EQ(third_party::SArray<int>(reply.data[1])[0], 1);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,45 @@
+#include "server/util/staleness_controller.hpp"
+
+#include <algorithm>
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+const size_t StalenessController::kHistorySize;
+
+StalenessController::StalenessController(int staleness, const StalenessConfig& config)
+    : config_(config), staleness_(staleness) {
+  CHECK_GE(staleness_, 0);
+  if (config_.adaptive) {
+    CHECK_GE(config_.min_staleness, 0);
+    CHECK_LE(config_.min_staleness, config_.max_staleness);
+    CHECK_GT(config_.patience, 0);
+    staleness_ = std::max(config_.min_staleness, std::min(staleness_, config_.max_staleness));
+  }
+}
+
+int StalenessController::Update(int min_clock, int max_clock, int num_pending) {
+  if (config_.adaptive) {
+    if (num_deferred_ > 0) {
+      num_calm_ = 0;
+      if (staleness_ < config_.max_staleness)
+        staleness_ += 1;
+    } else if (num_pending == 0) {
+      num_calm_ += 1;
+      if (num_calm_ >= config_.patience && max_clock - min_clock < staleness_ &&
+          staleness_ > config_.min_staleness) {
+        staleness_ -= 1;
+        num_calm_ = 0;
+      }
+    }
+    history_.push_back(std::make_pair(min_clock, staleness_));
+    if (history_.size() > kHistorySize)
+      history_.pop_front();
+  }
+  num_deferred_ = 0;
+  VLOG(1) << "staleness " << staleness_ << " at min clock " << min_clock;
+  return staleness_;
+}
+
+}  // namespace csci5570
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <utility>
+
+namespace csci5570 {
+
+/*
+ * How an SSP table bounds and serves its stale reads. A fixed staleness is kept unless adaptive.
+ */
+struct StalenessConfig {
+  bool adaptive = false;     // move the staleness within [min_staleness, max_staleness] at each clock
+  int32_t min_staleness = 0;
+  int32_t max_staleness = 8;
+  int32_t patience = 4;      // the clocks without a request held back before the bound is narrowed by one
+  bool eager = false;        // push the rows each worker reads to it whenever the min clock advances
+  int32_t refresh_ttl = 4;   // the advances a row is still pushed for after the worker last read it from the shard
+};
+
+/*
+ * Chooses the staleness of an SSP shard at each advance of the min clock, from what it saw since the last one:
+ * - widens the bound by one if requests of fast workers were held back, so they stop waiting for the slow ones
+ * - narrows it by one after patience clocks without any held back while the progresses spread over less than the
+ *   bound, so the reads are as fresh as the slowest worker lets them
+ * Each shard chooses for itself, all within the limits of the table.
+ */
+class StalenessController {
+ public:
+  static const size_t kHistorySize = 64;
+
+  /**
+   * @param staleness   the staleness to start from, clamped into the limits if adaptive
+   * @param config      see StalenessConfig
+   */
+  StalenessController(int staleness, const StalenessConfig& config);
+
+  int GetStaleness() const { return staleness_; }
+  // the largest staleness it may choose
+  int GetMaxStaleness() const { return config_.adaptive ? config_.max_staleness : staleness_; }
+
+  // a request is held back by the bound
+  void RecordDeferred() { num_deferred_ += 1; }
+  /**
+   * Choose the staleness once the min clock advanced, and return it
+   *
+   * @param min_clock     the new min clock
+   * @param max_clock     the progress of the fastest worker
+   * @param num_pending   the requests still held back
+   */
+  int Update(int min_clock, int max_clock, int num_pending);
+
+  // (min clock, staleness chosen at it) at the last kHistorySize advances of the min clock, empty unless adaptive
+  const std::deque<std::pair<int, int>>& GetHistory() const { return history_; }
+
+ private:
+  StalenessConfig config_;
+  int staleness_;
+  int num_deferred_ = 0;  // the requests held back since the last advance
+  int num_calm_ = 0;      // the advances in a row without any held back
+  std::deque<std::pair<int, int>> history_;
+};
+
+}  // namespace csci5570
@@ -0,0 +1,73 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/staleness_controller.hpp"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestStalenessController : public testing::Test {
+ public:
+  TestStalenessController() {}
+  ~TestStalenessController() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestStalenessController, Fixed) {
+  StalenessController controller(2, StalenessConfig());
+  controller.RecordDeferred();
+  EXPECT_EQ(controller.Update(1, 3, 1), 2);
+  EXPECT_EQ(controller.Update(2, 2, 0), 2);
+  EXPECT_EQ(controller.GetMaxStaleness(), 2);
+  EXPECT_TRUE(controller.GetHistory().empty());
+}
+
+TEST_F(TestStalenessController, Adapt) {
+  StalenessConfig config;
+  config.adaptive = true;
+  config.min_staleness = 1;
+  config.max_staleness = 3;
+  config.patience = 2;
+  StalenessController controller(0, config);
+  EXPECT_EQ(controller.GetStaleness(), 1);  // clamped into the limits
+  EXPECT_EQ(controller.GetMaxStaleness(), 3);
+
+  // widened while requests are held back, up to the max
+  for (int clock = 1; clock <= 3; clock++) {
+    controller.RecordDeferred();
+    controller.RecordDeferred();
+    EXPECT_EQ(controller.Update(clock, clock + 3, 1), std::min(clock + 1, 3));
+  }
+  // not narrowed while requests still wait, nor while the progresses spread over the bound
+  EXPECT_EQ(controller.Update(4, 5, 1), 3);
+  EXPECT_EQ(controller.Update(5, 8, 0), 3);
+  EXPECT_EQ(controller.Update(6, 9, 0), 3);
+  // narrowed after patience calm clocks, down to the min
+  EXPECT_EQ(controller.Update(7, 8, 0), 2);
+  EXPECT_EQ(controller.Update(8, 9, 0), 2);
+  EXPECT_EQ(controller.Update(9, 9, 0), 1);
+  EXPECT_EQ(controller.Update(10, 10, 0), 1);
+  EXPECT_EQ(controller.Update(11, 11, 0), 1);
+
+  const auto& history = controller.GetHistory();
+  ASSERT_EQ(history.size(), 11);
+  EXPECT_EQ(history[0], std::make_pair(1, 2));
+  EXPECT_EQ(history[10], std::make_pair(11, 1));
+
+  // only the recent choices are kept
+  for (int clock = 12; clock < 12 + static_cast<int>(StalenessController::kHistorySize); clock++) {
+    controller.Update(clock, clock, 0);
+  }
+  ASSERT_EQ(history.size(), StalenessController::kHistorySize);
+  EXPECT_EQ(history.front().first, 12);
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "base/magic.hpp"
+#include "base/third_party/sarray.h"
+#include "server/util/flat_hash_map.hpp"
+
+#include "glog/logging.h"
+
+namespace csci5570 {
+
+/*
+ * Sums the values pushed for each key until they are applied to the storage at once, for the storages whose
+ * updater is linear. Created by AbstractStorage::CreateAggregator, which knows the type of the values.
+ */
+class AbstractAggregator {
+ public:
+  virtual ~AbstractAggregator() {}
+
+  /**
+   * Add the values of the keys to their sums
+   *
+   * @param typed_keys    the keys of an Add
+   * @param vals          the dim values per key of the Add
+   */
+  virtual void Add(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) = 0;
+
+  /**
+   * Move the sums out, sorted by key, ready for a SubAdd, and start over keeping the memory
+   */
+  virtual void Drain(third_party::SArray<Key>* typed_keys, third_party::SArray<char>* vals) = 0;
+
+  // the keys with a sum
+  virtual size_t Size() const = 0;
+};
+
+/*
+ * The sums are kept in one array in the order the keys first arrive, found through a FlatHashMap. Both keep
+ * their capacity across Drains, so after the first clock the aggregator is sized for the keys of a clock and
+ * only allocates again if the working set grows.
+ */
+template <typename Val>
+class UpdateAggregator : public AbstractAggregator {
+ public:
+  /**
+   * @param dim   the number of values per key
+   */
+  explicit UpdateAggregator(size_t dim) : dim_(dim) {}
+
+  virtual void Add(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) override {
+    auto typed_vals = third_party::SArray<Val>(vals);
+    CHECK_EQ(typed_keys.size() * dim_, typed_vals.size());
+    for (size_t i = 0; i < typed_keys.size(); i++) {
+      uint32_t* row = rows_.FindOrInsert(typed_keys[i]);
+      if (*row == 0) {
+        // rows are stored plus one, so a new entry reads 0
+        keys_.push_back(typed_keys[i]);
+        sums_.resize(sums_.size() + dim_, Val());
+        *row = keys_.size();
+      }
+      Val* sum = &sums_[(*row - 1) * dim_];
+      for (size_t j = 0; j < dim_; j++) {
+        sum[j] += typed_vals[i * dim_ + j];
+      }
+    }
+  }
+
+  virtual void Drain(third_party::SArray<Key>* typed_keys, third_party::SArray<char>* vals) override {
+    std::vector<uint32_t> order(keys_.size());
+    for (uint32_t i = 0; i < order.size(); i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return keys_[a] < keys_[b]; });
+    third_party::SArray<Key> sorted_keys(keys_.size());
+    third_party::SArray<Val> sorted_sums(sums_.size());
+    for (size_t i = 0; i < order.size(); i++) {
+      sorted_keys[i] = keys_[order[i]];
+      std::copy_n(&sums_[order[i] * dim_], dim_, &sorted_sums[i * dim_]);
+    }
+    *typed_keys = sorted_keys;
+    *vals = third_party::SArray<char>(sorted_sums);
+    rows_.Clear();
+    keys_.clear();
+    sums_.clear();
+  }
+
+  virtual size_t Size() const override { return keys_.size(); }
+
+ private:
+  size_t dim_;
+  FlatHashMap<Key, uint32_t> rows_;  // {key: its row in keys_ and sums_, plus one}
+  std::vector<Key> keys_;
+  std::vector<Val> sums_;  // the dim_ sums of keys_[i] start at i * dim_
+};
+
+}  // namespace csci5570
@@ -0,0 +1,47 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/util/update_aggregator.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestUpdateAggregator : public testing::Test {
+ public:
+  TestUpdateAggregator() {}
+  ~TestUpdateAggregator() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestUpdateAggregator, SumAndDrain) {
+  UpdateAggregator<float> aggregator(2);
+  aggregator.Add(third_party::SArray<Key>({7, 3}),
+                 third_party::SArray<char>(third_party::SArray<float>({1.0, 2.0, 3.0, 4.0})));
+  aggregator.Add(third_party::SArray<Key>({3, 5}),
+                 third_party::SArray<char>(third_party::SArray<float>({0.5, 0.5, -1.0, 1.0})));
+  EXPECT_EQ(aggregator.Size(), 3);
+
+  third_party::SArray<Key> keys;
+  third_party::SArray<char> vals;
+  aggregator.Drain(&keys, &vals);
+  // one sum per key, sorted by key
+  EXPECT_EQ(std::vector<Key>(keys.begin(), keys.end()), std::vector<Key>({3, 5, 7}));
+  auto sums = third_party::SArray<float>(vals);
+  EXPECT_EQ(std::vector<float>(sums.begin(), sums.end()), std::vector<float>({3.5, 4.5, -1.0, 1.0, 1.0, 2.0}));
+
+  // the next clock starts from zero
+  EXPECT_EQ(aggregator.Size(), 0);
+  aggregator.Add(third_party::SArray<Key>({7}), third_party::SArray<char>(third_party::SArray<float>({1.0, 1.0})));
+  aggregator.Drain(&keys, &vals);
+  sums = third_party::SArray<float>(vals);
+  EXPECT_EQ(std::vector<Key>(keys.begin(), keys.end()), std::vector<Key>({7}));
+  EXPECT_EQ(std::vector<float>(sums.begin(), sums.end()), std::vector<float>({1.0, 1.0}));
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <string>
+#include "base/message.hpp"
+#include "base/third_party/range.h"
+#include "server/abstract_storage.hpp"
+#include "server/block_layout.hpp"
+#include "server/updater.hpp"
+#include "server/util/checkpoint.hpp"
+
+#include "glog/logging.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+namespace csci5570 {
+
+/*
+ * Dense storage for the keys in [range.begin(), range.end()) owned by one server thread.
+ * The blocks are kept in one contiguous array and a key is located by its offset from range.begin().
+ */
+template <typename Val>
+class VectorStorage : public AbstractStorage {
+ public:
+  explicit VectorStorage(const third_party::Range& range)
+      : VectorStorage(range, std::unique_ptr<AbstractUpdater<Val>>(new AssignUpdater<Val>())) {}
+  VectorStorage(const third_party::Range& range, std::unique_ptr<AbstractUpdater<Val>>&& updater, size_t dim = 1,
+                Precision precision = Precision::Full)
+      : range_(range),
+        layout_(std::move(updater), dim, precision),
+        dim_(dim),
+        block_bytes_(layout_.BlockBytes()),
+        storage_(range.size() * block_bytes_, 0),
+        dirty_pages_((range.size() + kPageKeys - 1) / kPageKeys, false) {}
+
+  virtual void SubAdd(const third_party::SArray<Key>& typed_keys, const third_party::SArray<char>& vals) override {
+    auto typed_vals = third_party::SArray<Val>(vals);
+    CHECK_EQ(typed_keys.size() * dim_, typed_vals.size());
+    for (int i = 0; i < typed_keys.size(); i++) {
+      char* block = &storage_[Offset(typed_keys[i])];
+      size_t page = (typed_keys[i] - range_.begin()) / kPageKeys;
+      if (!dirty_pages_[page]) {
+        dirty_pages_[page] = true;
+        num_dirty_pages_++;
+      }
+      layout_.Update(block, &typed_vals[i * dim_]);
+    }
+  }
+
+  virtual third_party::SArray<char> SubGet(const third_party::SArray<Key>& typed_keys) override {
+    size_t row_bytes = layout_.RowBytes();
+    third_party::SArray<char> reply_vals(typed_keys.size() * row_bytes);
+    for (int i = 0; i < typed_keys.size(); i++) {
+      layout_.CopyRow(&storage_[Offset(typed_keys[i])], &reply_vals[i * row_bytes]);
+    }
+    return reply_vals;
+  }
+
+  virtual std::function<void()> Snapshot(int model_id) override {
+    std::shared_ptr<KVSnapshot<Key, char>> snapshot(new KVSnapshot<Key, char>(block_bytes_));
+    bool full = schedule_.NextIsFull(num_dirty_pages_ * kPageKeys, range_.size());
+    if (full) {
+      snapshot->keys.resize(range_.size());
+      for (size_t i = 0; i < range_.size(); i++) {
+        snapshot->keys[i] = range_.begin() + i;
+      }
+      snapshot->vals = storage_;
+    } else {
+      // only the pages changed since the last checkpoint
+      snapshot->keys.reserve(num_dirty_pages_ * kPageKeys);
+      snapshot->vals.reserve(num_dirty_pages_ * kPageKeys * block_bytes_);
+      for (size_t page = 0; page < dirty_pages_.size(); page++) {
+        if (!dirty_pages_[page])
+          continue;
+        size_t end = std::min((page + 1) * kPageKeys, range_.size());
+        for (size_t i = page * kPageKeys; i < end; i++) {
+          snapshot->keys.push_back(range_.begin() + i);
+        }
+        snapshot->vals.insert(snapshot->vals.end(), storage_.begin() + page * kPageKeys * block_bytes_,
+                              storage_.begin() + end * block_bytes_);
+      }
+    }
+    std::fill(dirty_pages_.begin(), dirty_pages_.end(), false);
+    num_dirty_pages_ = 0;
+    std::string path = schedule_.Next(CheckpointPath(model_id), full);
+    snapshot->epoch = schedule_.Epoch();
+    return [snapshot, path]() { snapshot->Write(path); };
+  }
+
+  virtual void Recovery(int model_id) override {
+    std::string path = CheckpointPath(model_id);
+    schedule_.Replay<char, Key>(path, block_bytes_, [this](const Key* keys, const char* blocks, int64_t num_keys,
+                                                           bool full) {
+      if (num_keys == static_cast<int64_t>(range_.size()) && (num_keys == 0 || keys[0] == range_.begin())) {
+        // the checkpoint covers exactly the range of the storage
+        std::copy_n(blocks, storage_.size(), storage_.begin());
+        return;
+      }
+      for (int64_t i = 0; i < num_keys; i++) {
+        std::copy_n(blocks + i * block_bytes_, block_bytes_, &storage_[Offset(keys[i])]);
+      }
+    });
+  }
+
+  virtual void FinishIter() override {}
+
+  virtual std::unique_ptr<AbstractAggregator> CreateAggregator() override {
+    if (!layout_.IsLinear())
+      return nullptr;
+    return std::unique_ptr<AbstractAggregator>(new UpdateAggregator<Val>(dim_));
+  }
+
+ private:
+  // Return the offset of the block of the key
+  size_t Offset(Key key) const {
+    CHECK(key >= range_.begin() && key < range_.end()) << "key " << key << " is out of the storage range";
+    return (key - range_.begin()) * block_bytes_;
+  }
+
+  static const size_t kPageKeys = 1024;  // the granularity of dirty tracking
+
+  third_party::Range range_;
+  BlockLayout<Val> layout_;
+  size_t dim_;          // number of weights per key
+  size_t block_bytes_;  // see BlockLayout
+  std::vector<char> storage_;
+  std::vector<bool> dirty_pages_;  // whether each page of kPageKeys keys changed since the last checkpoint
+  size_t num_dirty_pages_ = 0;
+  CheckpointSchedule schedule_;
+};
+
+template <typename Val>
+const size_t VectorStorage<Val>::kPageKeys;
+
+}  // namespace csci5570
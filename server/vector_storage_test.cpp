@@ -0,0 +1,80 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "server/vector_storage.hpp"
+
+namespace csci5570 {
+namespace {
+
+class TestVectorStorage : public testing::Test {
+ public:
+  TestVectorStorage() {}
+  ~TestVectorStorage() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestVectorStorage, AddGetInt) {
+  VectorStorage<int> s(third_party::Range(10, 20));
+
+  Message m;
+  third_party::SArray<Key> s_keys({13, 14, 15});
+  third_party::SArray<int> s_vals({1, 2, 3});
+  m.AddData(s_keys);
+  m.AddData(s_vals);
+  s.Add(m);
+
+  Message m2;
+  m2.AddData(s_keys);
+  Message rep = s.Get(m2);
+
+  EXPECT_EQ(rep.data.size(), 2);
+  auto rep_keys = third_party::SArray<Key>(rep.data[0]);
+  auto rep_vals = third_party::SArray<int>(rep.data[1]);
+  for (int index = 0; index < s_keys.size(); index++) {
+    EXPECT_EQ(rep_keys[index], s_keys[index]);
+    EXPECT_EQ(rep_vals[index], s_vals[index]);
+  }
+}
+
+TEST_F(TestVectorStorage, SubAddSubGetFloat) {
+  VectorStorage<float> s(third_party::Range(10, 20));
+
+  third_party::SArray<Key> s_keys({10, 14, 19});
+  third_party::SArray<float> s_vals({0.1, 0.2, 0.3});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_vals));
+  third_party::SArray<float> ret = third_party::SArray<float>(s.SubGet(s_keys));
+  for (int i = 0; i < s_keys.size(); ++ i) {
+    EXPECT_EQ(ret[i], s_vals[i]);
+  }
+}
+
+TEST_F(TestVectorStorage, GetUntouchedKey) {
+  VectorStorage<double> s(third_party::Range(10, 20));
+
+  third_party::SArray<Key> s_keys({11, 12});
+  third_party::SArray<double> ret = third_party::SArray<double>(s.SubGet(s_keys));
+  EXPECT_EQ(ret[0], 0.0);
+  EXPECT_EQ(ret[1], 0.0);
+}
+
+TEST_F(TestVectorStorage, Rows) {
+  std::unique_ptr<AbstractUpdater<float>> updater(new AssignUpdater<float>());
+  VectorStorage<float> s(third_party::Range(10, 20), std::move(updater), 2);
+
+  third_party::SArray<Key> s_keys({19, 10});
+  third_party::SArray<float> s_vals({0.1, 0.2, 0.3, 0.4});
+  s.SubAdd(s_keys, third_party::SArray<char>(s_vals));
+  third_party::SArray<Key> get_keys({10, 11, 19});
+  third_party::SArray<float> ret = third_party::SArray<float>(s.SubGet(get_keys));
+  ASSERT_EQ(ret.size(), 6);
+  std::vector<float> expected{0.3, 0.4, 0.0, 0.0, 0.1, 0.2};
+  for (int i = 0; i < expected.size(); ++ i) {
+    EXPECT_EQ(ret[i], expected[i]);
+  }
+}
+
+}  // namespace
+}  // namespace csci5570
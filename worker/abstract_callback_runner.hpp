@@ -37,6 +37,17 @@ namespace csci5570 {
      * Used by the worker threads on receival of messages and to invoke callbacks
      */
     virtual void AddResponse(uint32_t app_thread_id, uint32_t model_id, Message& msg) = 0;
+
+    /**
+     * Register callbacks for the messages pushed by the servers unrequested, such as kRefresh
+     */
+    virtual void RegisterPushHandle(uint32_t app_thread_id, uint32_t model_id,
+                                    const std::function<void(Message&)>& push_handle) {}
+
+    /**
+     * Used by the worker threads on receival of a pushed message, which is not part of any request
+     */
+    virtual void AddPush(uint32_t app_thread_id, uint32_t model_id, Message& msg) {}
   };  // class AbstractCallbackRunner
   
   class DefaultCallbackRunner: public AbstractCallbackRunner {
@@ -98,10 +109,26 @@ namespace csci5570 {
         }
       }
     }
+    void RegisterPushHandle(uint32_t app_thread_id, uint32_t model_id,
+                            const std::function<void(Message&)>& push_handle) {
+      std::lock_guard<std::mutex> lk(push_mu_);
+      push_handle_map_[app_thread_id][model_id] = push_handle;
+    }
+    void AddPush(uint32_t app_thread_id, uint32_t model_id, Message& msg) {
+      std::function<void(Message&)> push_handle;
+      {
+        std::lock_guard<std::mutex> lk(push_mu_);
+        push_handle = push_handle_map_[app_thread_id][model_id];
+      }
+      if (push_handle)
+        push_handle(msg);
+    }
   private:
     std::map<uint32_t, std::map<uint32_t, std::function<void(Message&)>>> recv_handle_map_;
     std::map<uint32_t, std::map<uint32_t, std::function<void()>>> recv_finish_handle_map_;
     std::map<uint32_t, std::map<uint32_t, std::map<int,int>>> trackers_;
+    std::map<uint32_t, std::map<uint32_t, std::function<void(Message&)>>> push_handle_map_;
+    std::mutex push_mu_;  // the push handles are registered by the user threads and called by the worker thread
     
     std::mutex mu_;
     std::condition_variable cond_;
@@ -3,44 +3,78 @@
 #include "gflags/gflags.h"
 #include "glog/logging.h"
 
+#include "base/abstract_local_servers.hpp"
 #include "base/abstract_partition_manager.hpp"
 #include "base/magic.hpp"
 #include "base/message.hpp"
+#include "base/row_codec.hpp"
 #include "base/third_party/sarray.h"
 #include "base/threadsafe_queue.hpp"
 #include "worker/abstract_callback_runner.hpp"
+#include "worker/row_cache.hpp"
 
+#include <algorithm>
 #include <cinttypes>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_set>
 #include <vector>
 #include <ctime>
 
 
 namespace csci5570 {
-  
+
   /**
    * Provides the API to users, and implements the worker-side abstraction of model
    * Each model in one application is uniquely handled by one KVClientTable
    *
+   * Each key holds a row of dim values. The vals of Add/Push and Get are the rows of the keys, one after another.
+   * The servers reply to Get with the rows encoded in the precision of the table, which are decoded back to Val here.
+   * A server replicating its hot keys names them in the replies, and the later Gets read them from the replicas.
+   * The server threads on the node of the worker are called directly: Clock, Add and Push are applied on the calling
+   * thread, and Get is served at once when the consistency allows it, or sent to wait in the server queue otherwise.
+   * Every message to a local server goes direct, so a direct Get sees the Clocks and Adds of the worker before it.
+   * The eager SSP servers push the rows the worker read to it at each min clock, and a Get reads them from the
+   * cache while the clock of the worker is within their bound and they hold every Add and Push it sent the server.
+   *
    * @param Val type of model parameter values
    */
   template <typename Val>
   class KVClientTable {
   public:
+    using KVRows = std::pair<third_party::SArray<Key>, third_party::SArray<Val>>;
+
     /**
      * @param app_thread_id       user thread id
      * @param model_id            model id
      * @param sender_queue        the work queue of a sender communication thread
      * @param partition_manager   model partition manager
      * @param callback_runner     callback runner to handle received replies from servers
+     * @param dim                 the number of values per key
+     * @param precision           the precision of the rows in Get replies
+     * @param local_servers       the server threads on this node, called directly, or nullptr to send everything
      */
     KVClientTable(uint32_t app_thread_id, uint32_t model_id, ThreadsafeQueue<Message>* const sender_queue,
-                  const AbstractPartitionManager* const partition_manager, AbstractCallbackRunner* const callback_runner)
+                  const AbstractPartitionManager* const partition_manager, AbstractCallbackRunner* const callback_runner,
+                  uint32_t dim = 1, Precision precision = Precision::Full,
+                  AbstractLocalServers* const local_servers = nullptr)
     : app_thread_id_(app_thread_id),
     model_id_(model_id),
+    dim_(dim),
+    codec_(precision, dim),
     sender_queue_(sender_queue),
     partition_manager_(partition_manager),
-    callback_runner_(callback_runner){};
-    
+    callback_runner_(callback_runner),
+    local_servers_(local_servers),
+    row_cache_(std::make_shared<RowCache>()) {
+      // the cache is shared with the handle, which the worker thread may call after the table is gone
+      std::shared_ptr<RowCache> row_cache = row_cache_;
+      callback_runner_->RegisterPushHandle(app_thread_id_, model_id_, [row_cache](Message& msg) {
+        row_cache->Update(msg);
+      });
+    }
+
     // ========== API ========== //
     void Clock() {
       Message msg;
@@ -50,21 +84,35 @@ namespace csci5570 {
       auto sids = partition_manager_->GetServerThreadIds();
       for (auto sid : sids) {
         msg.meta.recver = sid;
-        sender_queue_->Push(msg);
+        if (IsLocal(sid))
+          local_servers_->Serve(msg);
+        else
+          sender_queue_->Push(msg);
       }
+      clock_ += 1;
     }
     // vector version
     void Add(const std::vector<Key>& keys, const std::vector<Val>& vals) {
-      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> sliced;
-      third_party::SArray<Key> tmp1;
-      for (int i = 0; i< keys.size(); i++) {
-        tmp1.push_back(keys[i]);
-      }
-      third_party::SArray<Val> tmp2;
-      for (int i = 0; i< vals.size(); i++) {
-        tmp2.push_back(vals[i]);
-      }
-      partition_manager_->Slice(std::make_pair(tmp1, tmp2), &sliced);
+      Add(third_party::SArray<Key>(keys), third_party::SArray<Val>(vals));
+    }
+    void Get(const std::vector<Key>& keys, std::vector<Val>* vals) {
+      vals->resize(keys.size() * dim_);
+      GetRows(third_party::SArray<Key>(keys), vals->data());
+    }
+    // one-way version of Add for tables with server-side updaters: the servers apply the values, typically
+    // gradients, without acknowledgement, so the call returns at once and nothing is resent
+    void Push(const std::vector<Key>& keys, const std::vector<Val>& vals) {
+      Push(third_party::SArray<Key>(keys), third_party::SArray<Val>(vals));
+    }
+    // sarray version
+    void Add(const third_party::SArray<Key>& keys, const third_party::SArray<Val>& vals) {
+      std::vector<std::pair<int, KVRows>> sliced;
+      SliceRows(keys, vals, &sliced);
+      CountUpdates(sliced);
+      // the local servers apply their rows at once, only the remote ones acknowledge
+      PushLocal(&sliced);
+      if (sliced.empty())
+        return;
       std::map<int,int> indicator_; //cash if we receive the acknownledgement or not
       std::map<int,int> tracker_;
       for (int i = 0; i < sliced.size(); i++) {
@@ -104,7 +152,7 @@ namespace csci5570 {
         if (current_time - last_round_time < ttl_) {
           return;
         }
-        //expire, resend what we not get ack.
+        //expire, resend what we not get ack, update last round time.
         last_round_time = current_time;
         for (int i = 0; i < sliced.size(); i++) {
           if(indicator_[sliced[i].first] == 1){
@@ -124,146 +172,248 @@ namespace csci5570 {
         }
       });
     }
-    void Get(const std::vector<Key>& keys, std::vector<Val>* vals) {
-      std::vector<std::pair<int, AbstractPartitionManager::Keys>> sliced;
-      third_party::SArray<Key> tmp;
-      for (int i = 0; i< keys.size(); i++) {
-        tmp.push_back(keys[i]);
-      }
-      partition_manager_->Slice(tmp, &sliced);
-      std::map<int,int> indicator_; //cash if we receive the acknownledgement or not
-      std::map<int,int> tracker_;
-      for (int i = 0; i < sliced.size(); i++) {
-        indicator_[sliced[i].first] = 0;
-        tracker_[sliced[i].first] = 0;
-      }
-      time_t start_time = time(NULL);
-      time_t last_round_time = start_time;
+    void Get(const third_party::SArray<Key>& keys, third_party::SArray<Val>* vals) {
+      vals->resize(keys.size() * dim_);
+      GetRows(keys, vals->data());
+    }
+    void Push(const third_party::SArray<Key>& keys, const third_party::SArray<Val>& vals) {
+      std::vector<std::pair<int, KVRows>> sliced;
+      SliceRows(keys, vals, &sliced);
+      CountUpdates(sliced);
+      PushLocal(&sliced);
       for (int i = 0; i < sliced.size(); i++) {
-        if(indicator_[sliced[i].first] == 1){
-          continue;
-        }
         Message msg;
         msg.meta.sender = app_thread_id_;
         msg.meta.recver = sliced[i].first;
         msg.meta.model_id = model_id_;
-        msg.meta.flag = Flag::kGet;
-        msg.meta.timestamp = start_time;
-        third_party::SArray<Key> keys(sliced[i].second);
+        msg.meta.flag = Flag::kPush;
+        msg.meta.timestamp = time(NULL);
+        third_party::SArray<Key> keys(sliced[i].second.first);
+        third_party::SArray<Val> vals(sliced[i].second.second);
         msg.AddData(keys);
+        msg.AddData(vals);
         sender_queue_->Push(msg);
       }
-      callback_runner_->RegisterRecvHandle(app_thread_id_, model_id_, [vals, indicator_](Message& msg)mutable{
-        auto it = indicator_.find(msg.meta.sender);
-        if (it != indicator_.end()){
-          if(it->second == 0){
-            third_party::SArray<Val> tmp(msg.data[1]);
-            for (int i = 0; i< tmp.size(); i++) {
-              vals->push_back(tmp[i]);
-            }
-          }
-          it->second = 1;
+    }
+    // ========== API ========== //
+
+  private:
+    // slice the keys into <server_id, (keys, positions of the keys in the request)> pairs
+    void SliceWithPositions(const third_party::SArray<Key>& keys,
+                            std::vector<std::pair<int, AbstractPartitionManager::KVPairs>>* sliced) const {
+      third_party::SArray<double> positions(keys.size());
+      for (int i = 0; i < keys.size(); i++) {
+        positions[i] = i;
+      }
+      partition_manager_->Slice(std::make_pair(keys, positions), sliced);
+    }
+
+    // slice the keys and their rows into <server_id, (keys, rows)> pairs
+    void SliceRows(const third_party::SArray<Key>& keys, const third_party::SArray<Val>& vals,
+                   std::vector<std::pair<int, KVRows>>* sliced) const {
+      CHECK_EQ(keys.size() * dim_, vals.size());
+      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> sliced_positions;
+      SliceWithPositions(keys, &sliced_positions);
+      for (auto& slice : sliced_positions) {
+        const auto& positions = slice.second.second;
+        third_party::SArray<Val> rows(positions.size() * dim_);
+        for (int i = 0; i < positions.size(); i++) {
+          std::copy_n(vals.begin() + static_cast<size_t>(positions[i]) * dim_, dim_, rows.begin() + i * dim_);
         }
-      });
-      callback_runner_->RegisterRecvFinishHandle(app_thread_id_, model_id_, [](){
+        sliced->push_back(std::make_pair(slice.first, KVRows(slice.second.first, rows)));
+      }
+    }
+
+    // count the updates sent to each server, which the pushed and replicated rows must hold to be read
+    void CountUpdates(const std::vector<std::pair<int, KVRows>>& sliced) {
+      for (const auto& slice : sliced) {
+        updates_sent_[slice.first] += 1;
+        updated_at_[slice.first] = clock_;
+      }
+    }
+
+    // ask a replica for rows holding the updates sent to the primaries of its keys
+    void AddUpdatesSent(const std::set<int>& primary_sids, Message* msg) const {
+      third_party::SArray<uint32_t> sids;
+      third_party::SArray<uint64_t> num_updates;
+      for (int sid : primary_sids) {
+        auto sent = updates_sent_.find(sid);
+        sids.push_back(sid);
+        num_updates.push_back(sent == updates_sent_.end() ? 0 : sent->second);
+      }
+      msg->AddData(sids);
+      msg->AddData(num_updates);
+    }
+
+    // read the slices whose rows were pushed recently enough from the cache, and remove them
+    void GetCached(std::vector<std::pair<int, AbstractPartitionManager::KVPairs>>* sliced, Val* rows) const {
+      if (row_cache_->NumServers() == 0)
         return;
-      });
-      callback_runner_->NewRequest(app_thread_id_, model_id_, tracker_);
-      callback_runner_->WaitRequest(app_thread_id_, model_id_, [this, sliced, indicator_, start_time, last_round_time]()mutable{
-        time_t current_time = time(NULL);
-        //not expire, return.
-        if (current_time - last_round_time < ttl_) {
-          return;
-        }
-        //expire, resend what we not get ack, update last round time.
-        last_round_time = current_time;
-        for (int i = 0; i < sliced.size(); i++) {
-          if(indicator_[sliced[i].first] == 1){
-            continue;
-          }
-          Message msg;
-          msg.meta.sender = app_thread_id_;
-          msg.meta.recver = sliced[i].first;
-          msg.meta.model_id = model_id_;
-          msg.meta.flag = Flag::kGet;
-          msg.meta.timestamp = start_time;
-          third_party::SArray<Key> keys(sliced[i].second);
-          msg.AddData(keys);
-          sender_queue_->Push(msg);
+      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> remaining;
+      for (auto& slice : *sliced) {
+        auto sent = updates_sent_.find(slice.first);
+        uint64_t num_updates = sent == updates_sent_.end() ? 0 : sent->second;
+        Message msg;
+        msg.meta.sender = slice.first;
+        msg.AddData(slice.second.first);
+        msg.AddData(third_party::SArray<char>());
+        if (!row_cache_->Get(slice.first, slice.second.first, clock_, num_updates, &msg.data[1])) {
+          remaining.push_back(slice);
+          continue;
         }
-      });
-    }
-    // sarray version
-    void Add(const third_party::SArray<Key>& keys, const third_party::SArray<Val>& vals) {
-      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> sliced;
-      partition_manager_->Slice(std::make_pair(keys, vals), &sliced);
-      std::map<int,int> indicator_; //cash if we receive the acknownledgement or not
-      std::map<int,int> tracker_;
-      for (int i = 0; i < sliced.size(); i++) {
-        indicator_[sliced[i].first] = 0;
-        tracker_[sliced[i].first] = 0;
+        DecodeRows(msg, slice.second.second, rows);
       }
-      time_t start_time = time(NULL);
-      time_t last_round_time = start_time;
-      for (int i = 0; i < sliced.size(); i++) {
-        if(indicator_[sliced[i].first] == 1){
+      sliced->swap(remaining);
+    }
+
+    bool IsLocal(int sid) const { return local_servers_ != nullptr && local_servers_->IsLocal(sid); }
+
+    // apply the slices of the local servers directly as pushes, which are not acknowledged, and remove them
+    void PushLocal(std::vector<std::pair<int, KVRows>>* sliced) const {
+      if (local_servers_ == nullptr)
+        return;
+      std::vector<std::pair<int, KVRows>> remote;
+      for (auto& slice : *sliced) {
+        if (!IsLocal(slice.first)) {
+          remote.push_back(slice);
           continue;
         }
         Message msg;
         msg.meta.sender = app_thread_id_;
-        msg.meta.recver = sliced[i].first;
+        msg.meta.recver = slice.first;
         msg.meta.model_id = model_id_;
-        msg.meta.flag = Flag::kAdd;
-        msg.meta.timestamp = start_time;
-        third_party::SArray<Key> keys(sliced[i].second.first);
-        third_party::SArray<Val> vals(sliced[i].second.second);
-        msg.AddData(keys);
-        msg.AddData(vals);
-        sender_queue_->Push(msg);
+        msg.meta.flag = Flag::kPush;
+        msg.meta.timestamp = time(NULL);
+        msg.AddData(slice.second.first);
+        msg.AddData(slice.second.second);
+        local_servers_->Serve(msg);
       }
-      callback_runner_->RegisterRecvHandle(app_thread_id_, model_id_, [indicator_](Message& msg)mutable{
-        auto it = indicator_.find(msg.meta.sender);
-        if (it != indicator_.end())
-          it->second = 1;
-      });
-      callback_runner_->RegisterRecvFinishHandle(app_thread_id_, model_id_, [](){
+      sliced->swap(remote);
+    }
+
+    // read the slices of the local servers whose consistency allows it now, and remove them
+    void GetLocal(std::vector<std::pair<int, AbstractPartitionManager::KVPairs>>* sliced,
+                  const std::map<int, std::set<int>>& replica_sids, Val* rows) {
+      if (local_servers_ == nullptr)
         return;
-      });
-      callback_runner_->NewRequest(app_thread_id_, model_id_, tracker_);
-      callback_runner_->WaitRequest(app_thread_id_, model_id_, [this, sliced, indicator_, start_time, last_round_time]()mutable{
-        time_t current_time = time(NULL);
-        //not expire, return.
-        if (current_time - last_round_time < ttl_) {
-          return;
+      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> remaining;
+      for (auto& slice : *sliced) {
+        if (!IsLocal(slice.first) || replica_sids.count(slice.first)) {
+          remaining.push_back(slice);
+          continue;
         }
-        //expire, resend what we not get ack, update last round time.
-        last_round_time = current_time;
-        for (int i = 0; i < sliced.size(); i++) {
-          if(indicator_[sliced[i].first] == 1){
-            continue;
+        Message msg;
+        msg.meta.sender = app_thread_id_;
+        msg.meta.recver = slice.first;
+        msg.meta.model_id = model_id_;
+        msg.meta.flag = Flag::kGet;
+        msg.meta.timestamp = time(NULL);
+        msg.AddData(third_party::SArray<Key>(slice.second.first));
+        Message reply;
+        if (!local_servers_->TryGet(msg, &reply)) {
+          // the server queue keeps it until the consistency allows it
+          remaining.push_back(slice);
+          continue;
+        }
+        DecodeRows(reply, slice.second.second, rows);
+        if (reply.data.size() == 4)
+          LearnHotKeys(reply);
+      }
+      sliced->swap(remaining);
+    }
+
+    // decode each row of a Get reply to the position of its key in the request
+    void DecodeRows(const Message& msg, const third_party::SArray<double>& pos, Val* rows) const {
+      const auto& bytes = msg.data[1];
+      size_t row_bytes = codec_.RowBytes();
+      CHECK_EQ(bytes.size(), pos.size() * row_bytes);
+      for (int i = 0; i < pos.size(); i++) {
+        codec_.Decode(bytes.data() + i * row_bytes, rows + static_cast<size_t>(pos[i]) * codec_.GetDim());
+      }
+    }
+
+    // move the hot keys of each slice to a replica of its server which the request does not reach otherwise, picked
+    // from the thread id so the workers spread over the replicas, and return the replicas in replica_sids with the
+    // primaries of the keys moved to each. The slices of servers updated at this clock stay: the replicas only get
+    // those updates at the next advance of the min clock, which may be waiting for this worker
+    void RouteToReplicas(std::vector<std::pair<int, AbstractPartitionManager::KVPairs>>* sliced,
+                         std::map<int, std::set<int>>* replica_sids) const {
+      if (hot_keys_.empty())
+        return;
+      std::set<int> primary_sids;
+      for (const auto& slice : *sliced) {
+        primary_sids.insert(slice.first);
+      }
+      std::map<int, AbstractPartitionManager::KVPairs> moved;  // {replica sid: the hot keys and their positions}
+      std::map<int, std::set<int>> moved_from;                // {replica sid: the primaries of the hot keys}
+      for (auto& slice : *sliced) {
+        auto it = replicas_.find(slice.first);
+        if (it == replicas_.end())
+          continue;
+        auto updated = updated_at_.find(slice.first);
+        if (updated != updated_at_.end() && updated->second == clock_)
+          continue;
+        int replica = -1;
+        for (size_t i = 0; i < it->second.size(); i++) {
+          int sid = it->second[(app_thread_id_ + i) % it->second.size()];
+          if (primary_sids.count(sid) == 0) {
+            replica = sid;
+            break;
           }
-          Message msg;
-          msg.meta.sender = app_thread_id_;
-          msg.meta.recver = sliced[i].first;
-          msg.meta.model_id = model_id_;
-          msg.meta.flag = Flag::kAdd;
-          msg.meta.timestamp = start_time;
-          third_party::SArray<Key> keys(sliced[i].second.first);
-          third_party::SArray<Val> vals(sliced[i].second.second);
-          msg.AddData(keys);
-          msg.AddData(vals);
-          sender_queue_->Push(msg);
         }
-      });
+        if (replica == -1)
+          continue;
+        AbstractPartitionManager::KVPairs kept;
+        auto& hot = moved[replica];
+        for (int i = 0; i < slice.second.first.size(); i++) {
+          auto& to = hot_keys_.count(slice.second.first[i]) ? hot : kept;
+          to.first.push_back(slice.second.first[i]);
+          to.second.push_back(slice.second.second[i]);
+        }
+        if (kept.first.size() < slice.second.first.size())
+          moved_from[replica].insert(slice.first);
+        slice.second = kept;
+      }
+      sliced->erase(std::remove_if(sliced->begin(), sliced->end(),
+                                   [](const std::pair<int, AbstractPartitionManager::KVPairs>& slice) {
+                                     return slice.second.first.empty();
+                                   }),
+                    sliced->end());
+      for (auto& replica : moved) {
+        if (replica.second.first.empty())
+          continue;
+        sliced->push_back(replica);
+        (*replica_sids)[replica.first] = moved_from[replica.first];
+      }
     }
-    void Get(const third_party::SArray<Key>& keys, third_party::SArray<Val>* vals) {
-      std::vector<std::pair<int, AbstractPartitionManager::Keys>> sliced;
-      partition_manager_->Slice(keys, &sliced);
+
+    // remember the hot keys named in a Get reply and the replicas of the server
+    void LearnHotKeys(const Message& msg) {
+      auto keys = third_party::SArray<Key>(msg.data[2]);
+      auto sids = third_party::SArray<uint32_t>(msg.data[3]);
+      hot_keys_.insert(keys.begin(), keys.end());
+      replicas_[msg.meta.sender].assign(sids.begin(), sids.end());
+    }
+
+    // fetch the rows of the keys into rows, which has room for keys.size() * dim_ values
+    void GetRows(const third_party::SArray<Key>& keys, Val* rows) {
+      std::vector<std::pair<int, AbstractPartitionManager::KVPairs>> sliced;
+      SliceWithPositions(keys, &sliced);
+      GetCached(&sliced, rows);
+      if (sliced.empty())
+        return;
+      std::map<int, std::set<int>> replica_sids;  // {server read through kGetReplica: the primaries of its keys}
+      RouteToReplicas(&sliced, &replica_sids);
+      GetLocal(&sliced, replica_sids, rows);
+      if (sliced.empty())
+        return;
       std::map<int,int> indicator_; //cash if we receive the acknownledgement or not
       std::map<int,int> tracker_;
+      std::map<int, third_party::SArray<double>> positions;  // {server_id: positions of the keys sent to it}
       for (int i = 0; i < sliced.size(); i++) {
         indicator_[sliced[i].first] = 0;
         tracker_[sliced[i].first] = 0;
+        positions[sliced[i].first] = sliced[i].second.second;
       }
       time_t start_time = time(NULL);
       time_t last_round_time = start_time;
@@ -275,20 +425,21 @@ namespace csci5570 {
         msg.meta.sender = app_thread_id_;
         msg.meta.recver = sliced[i].first;
         msg.meta.model_id = model_id_;
-        msg.meta.flag = Flag::kGet;
+        msg.meta.flag = replica_sids.count(sliced[i].first) ? Flag::kGetReplica : Flag::kGet;
         msg.meta.timestamp = start_time;
-        third_party::SArray<Key> keys(sliced[i].second);
+        third_party::SArray<Key> keys(sliced[i].second.first);
         msg.AddData(keys);
+        if (msg.meta.flag == Flag::kGetReplica)
+          AddUpdatesSent(replica_sids[sliced[i].first], &msg);
         sender_queue_->Push(msg);
       }
-      callback_runner_->RegisterRecvHandle(app_thread_id_, model_id_, [vals, indicator_](Message& msg)mutable{
+      callback_runner_->RegisterRecvHandle(app_thread_id_, model_id_, [this, rows, positions, indicator_](Message& msg)mutable{
         auto it = indicator_.find(msg.meta.sender);
         if (it != indicator_.end()){
           if(it->second == 0){
-            third_party::SArray<Val> tmp(msg.data[1]);
-            for (int i = 0; i< tmp.size(); i++) {
-              vals->push_back(tmp[i]);
-            }
+            DecodeRows(msg, positions[msg.meta.sender], rows);
+            if (msg.data.size() == 4)
+              LearnHotKeys(msg);
           }
           it->second = 1;
         }
@@ -297,7 +448,7 @@ namespace csci5570 {
         return;
       });
       callback_runner_->NewRequest(app_thread_id_, model_id_, tracker_);
-      callback_runner_->WaitRequest(app_thread_id_, model_id_, [this, sliced, indicator_, start_time, last_round_time]()mutable{
+      callback_runner_->WaitRequest(app_thread_id_, model_id_, [this, sliced, replica_sids, indicator_, start_time, last_round_time]()mutable{
         time_t current_time = time(NULL);
         //not expire, return.
         if (current_time - last_round_time < ttl_) {
@@ -313,26 +464,35 @@ namespace csci5570 {
           msg.meta.sender = app_thread_id_;
           msg.meta.recver = sliced[i].first;
           msg.meta.model_id = model_id_;
-          msg.meta.flag = Flag::kGet;
+          msg.meta.flag = replica_sids.count(sliced[i].first) ? Flag::kGetReplica : Flag::kGet;
           msg.meta.timestamp = start_time;
-          third_party::SArray<Key> keys(sliced[i].second);
+          third_party::SArray<Key> keys(sliced[i].second.first);
           msg.AddData(keys);
+          if (msg.meta.flag == Flag::kGetReplica)
+            AddUpdatesSent(replica_sids[sliced[i].first], &msg);
           sender_queue_->Push(msg);
         }
       });
     }
-    // ========== API ========== //
-    
-  private:
+
     uint32_t app_thread_id_;  // identifies the user thread
     uint32_t model_id_;       // identifies the model on servers
+    uint32_t dim_;            // number of values per key
+    RowCodec<Val> codec_;     // decodes the rows of Get replies
     uint32_t sequence_number_ = 0;  //sequence number for add request
     double ttl_  = 10; //time to live
-    
+    std::unordered_set<Key> hot_keys_;                // the keys replicated by their servers
+    std::map<int, std::vector<uint32_t>> replicas_;  // {server id: the servers replicating its hot keys}
+    int clock_ = 0;                                  // the Clocks called
+    std::map<int, uint64_t> updates_sent_;           // {server id: the Adds and Pushes sent to it}
+    std::map<int, int> updated_at_;                  // {server id: the clock of the last Add or Push sent to it}
+
     ThreadsafeQueue<Message>* const sender_queue_;             // not owned
     AbstractCallbackRunner* const callback_runner_;            // not owned
     const AbstractPartitionManager* const partition_manager_;  // not owned
-    
+    AbstractLocalServers* const local_servers_;                // not owned, the server threads on this node
+    std::shared_ptr<RowCache> row_cache_;                      // the rows pushed by the eager servers
+
   };  // class KVClientTable
-  
+
 }  // namespace csci5570
@@ -1,6 +1,7 @@
 #include "glog/logging.h"
 #include "gtest/gtest.h"
 
+#include "base/abstract_local_servers.hpp"
 #include "base/abstract_partition_manager.hpp"
 #include "base/magic.hpp"
 #include "base/message.hpp"
@@ -8,6 +9,7 @@
 #include "base/threadsafe_queue.hpp"
 #include "worker/kv_client_table.hpp"
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 #include <thread>
@@ -112,6 +114,40 @@ class FakeCallbackRunner : public AbstractCallbackRunner {
   std::pair<uint32_t, uint32_t> tracker_;
 };
 
+// both server threads are local, and serve every Get at once
+class FakeLocalServers : public AbstractLocalServers {
+ public:
+  bool IsLocal(uint32_t sid) const override { return true; }
+  void Serve(Message& msg) override { served_.push_back(msg); }
+  bool TryGet(Message& msg, Message* reply) override {
+    served_.push_back(msg);
+    auto keys = third_party::SArray<Key>(msg.data[0]);
+    third_party::SArray<double> vals;
+    for (Key key : keys) {
+      vals.push_back(key);
+    }
+    reply->meta.sender = msg.meta.recver;
+    reply->AddData(keys);
+    reply->AddData(vals);
+    return true;
+  }
+
+  std::vector<Message> served_;
+};
+
+// server 0 replicates key 3 to server 2, which is read through the queue
+class HotLocalServers : public FakeLocalServers {
+ public:
+  bool TryGet(Message& msg, Message* reply) override {
+    FakeLocalServers::TryGet(msg, reply);
+    if (msg.meta.recver == 0) {
+      reply->AddData(third_party::SArray<Key>({3}));
+      reply->AddData(third_party::SArray<uint32_t>({2}));
+    }
+    return true;
+  }
+};
+
 class TestKVClientTable : public testing::Test {
  protected:
   void SetUp() {}
@@ -179,6 +215,66 @@ TEST_F(TestKVClientTable, Add) {
   EXPECT_DOUBLE_EQ(res_vals[2], double(0.1));
 }
 
+TEST_F(TestKVClientTable, Push) {
+  ThreadsafeQueue<Message> queue;
+  FakePartitionManager manager({0, 1}, 4);
+  DefaultCallbackRunner callback_runner;
+
+  KVClientTable<double> table(kTestAppThreadId, kTestModelId, &queue, &manager, &callback_runner);
+
+  std::vector<Key> keys = {3, 4, 5, 6};
+  std::vector<double> grads = {0.1, 0.2, 0.3, 0.4};
+  table.Push(keys, grads);  // returns without waiting for any reply
+  EXPECT_EQ(queue.Size(), 2);
+  Message m1, m2;
+  queue.WaitAndPop(&m1);
+  queue.WaitAndPop(&m2);
+
+  EXPECT_EQ(m1.meta.recver, 0);
+  EXPECT_EQ(m1.meta.flag, Flag::kPush);
+  ASSERT_EQ(m1.data.size(), 2);
+  third_party::SArray<Key> res_keys;
+  res_keys = m1.data[0];
+  ASSERT_EQ(res_keys.size(), 1);
+  EXPECT_EQ(res_keys[0], 3);
+
+  EXPECT_EQ(m2.meta.recver, 1);
+  EXPECT_EQ(m2.meta.flag, Flag::kPush);
+  third_party::SArray<double> res_vals;
+  res_vals = m2.data[1];
+  ASSERT_EQ(res_vals.size(), 3);
+  EXPECT_DOUBLE_EQ(res_vals[2], double(0.4));
+}
+
+TEST_F(TestKVClientTable, PushRows) {
+  ThreadsafeQueue<Message> queue;
+  FakePartitionManager manager({0, 1}, 4);
+  DefaultCallbackRunner callback_runner;
+
+  KVClientTable<float> table(kTestAppThreadId, kTestModelId, &queue, &manager, &callback_runner, 2);
+
+  std::vector<Key> keys = {3, 4, 5};
+  std::vector<float> rows = {0.1, 0.2, 0.3, 0.4, 0.5, 0.6};
+  table.Push(keys, rows);  // {3,4,5} -> {3}, {4,5}
+  Message m1, m2;
+  queue.WaitAndPop(&m1);
+  queue.WaitAndPop(&m2);
+
+  third_party::SArray<Key> res_keys;
+  third_party::SArray<float> res_vals;
+  res_keys = m1.data[0];
+  res_vals = m1.data[1];
+  ASSERT_EQ(res_keys.size(), 1);
+  ASSERT_EQ(res_vals.size(), 2);
+  EXPECT_EQ(res_vals[1], float(0.2));
+  res_keys = m2.data[0];
+  res_vals = m2.data[1];
+  ASSERT_EQ(res_keys.size(), 2);
+  ASSERT_EQ(res_vals.size(), 4);
+  EXPECT_EQ(res_vals[0], float(0.3));
+  EXPECT_EQ(res_vals[3], float(0.6));
+}
+
 TEST_F(TestKVClientTable, Get) {
   ThreadsafeQueue<Message> queue;
   FakePartitionManager manager({0, 1}, 4);
@@ -235,4 +331,121 @@ TEST_F(TestKVClientTable, Get) {
   th.join();
 }
 
+TEST_F(TestKVClientTable, LocalServers) {
+  ThreadsafeQueue<Message> queue;
+  FakePartitionManager manager({0, 1}, 4);
+  DefaultCallbackRunner callback_runner;
+  FakeLocalServers local_servers;
+  KVClientTable<double> table(kTestAppThreadId, kTestModelId, &queue, &manager, &callback_runner, 1, Precision::Full,
+                              &local_servers);
+
+  // served on this thread, the Adds as pushes as nothing acknowledges them
+  std::vector<Key> keys = {3, 4, 5, 6};
+  table.Add(keys, {0.1, 0.2, 0.3, 0.4});
+  table.Clock();
+  std::vector<double> vals;
+  table.Get(keys, &vals);  // {3,4,5,6} -> {3}, {4,5,6}
+  std::vector<double> expected{3, 4, 5, 6};
+  EXPECT_EQ(vals, expected);
+  EXPECT_EQ(queue.Size(), 0);
+
+  ASSERT_EQ(local_servers.served_.size(), 6);
+  std::vector<Flag> flags{Flag::kPush, Flag::kPush, Flag::kClock, Flag::kClock, Flag::kGet, Flag::kGet};
+  for (int i = 0; i < flags.size(); i++) {
+    EXPECT_EQ(local_servers.served_[i].meta.flag, flags[i]);
+    EXPECT_EQ(local_servers.served_[i].meta.recver, i % 2);
+  }
+  auto vals1 = third_party::SArray<double>(local_servers.served_[1].data[1]);
+  ASSERT_EQ(vals1.size(), 3);
+  EXPECT_DOUBLE_EQ(vals1[2], 0.4);
+}
+
+Message MakeRefresh(uint32_t sid, const std::vector<Key>& keys, const std::vector<double>& vals, int max_clock,
+                    uint64_t num_updates) {
+  Message msg;
+  msg.meta.sender = sid;
+  msg.meta.recver = kTestAppThreadId;
+  msg.meta.model_id = kTestModelId;
+  msg.meta.flag = Flag::kRefresh;
+  msg.meta.round = max_clock;
+  msg.AddData(third_party::SArray<Key>(keys));
+  msg.AddData(third_party::SArray<double>(vals));
+  msg.AddData(third_party::SArray<uint64_t>({num_updates}));
+  return msg;
+}
+
+TEST_F(TestKVClientTable, RefreshedRows) {
+  ThreadsafeQueue<Message> queue;
+  FakePartitionManager manager({0, 1}, 4);
+  DefaultCallbackRunner callback_runner;
+  KVClientTable<double> table(kTestAppThreadId, kTestModelId, &queue, &manager, &callback_runner);
+
+  // the rows pushed by both servers are read without a request
+  Message refresh0 = MakeRefresh(0, {3}, {30}, 0, 0);
+  Message refresh1 = MakeRefresh(1, {4, 5, 6}, {40, 50, 60}, 0, 0);
+  callback_runner.AddPush(kTestAppThreadId, kTestModelId, refresh0);
+  callback_runner.AddPush(kTestAppThreadId, kTestModelId, refresh1);
+  std::vector<Key> keys = {3, 5};
+  std::vector<double> vals;
+  table.Get(keys, &vals);
+  EXPECT_EQ(vals, std::vector<double>({30, 50}));
+  EXPECT_EQ(queue.Size(), 0);
+
+  // after a Push and a Clock, the rows are read again once they hold the Push and allow clock 1
+  table.Push(keys, {0.1, 0.2});
+  table.Clock();
+  EXPECT_EQ(queue.Size(), 4);
+  refresh0 = MakeRefresh(0, {3}, {31}, 1, 1);
+  refresh1 = MakeRefresh(1, {4, 5, 6}, {40, 51, 60}, 1, 1);
+  callback_runner.AddPush(kTestAppThreadId, kTestModelId, refresh0);
+  callback_runner.AddPush(kTestAppThreadId, kTestModelId, refresh1);
+  table.Get(keys, &vals);
+  EXPECT_EQ(vals, std::vector<double>({31, 51}));
+  EXPECT_EQ(queue.Size(), 4);
+}
+
+TEST_F(TestKVClientTable, ReplicaOwnUpdates) {
+  ThreadsafeQueue<Message> queue;
+  FakePartitionManager manager({0, 1}, 4);
+  DefaultCallbackRunner callback_runner;
+  HotLocalServers local_servers;
+  KVClientTable<double> table(kTestAppThreadId, kTestModelId, &queue, &manager, &callback_runner, 1, Precision::Full,
+                              &local_servers);
+  std::vector<Key> keys = {3};
+  std::vector<double> vals;
+  table.Get(keys, &vals);  // learns that key 3 is hot
+  table.Push(keys, {0.1});
+
+  // the replicas get the update of this clock at the next advance of the min clock, so the primary serves it
+  table.Get(keys, &vals);
+  EXPECT_EQ(queue.Size(), 0);
+  ASSERT_FALSE(local_servers.served_.empty());
+  EXPECT_EQ(local_servers.served_.back().meta.flag, Flag::kGet);
+  EXPECT_EQ(third_party::SArray<Key>(local_servers.served_.back().data[0]).size(), 1);
+
+  // at the next clock the replica serves it, once its rows hold the update sent to server 0
+  table.Clock();
+  std::thread th([&table, &keys]() {
+    std::vector<double> vals;
+    table.Get(keys, &vals);
+    EXPECT_EQ(vals, std::vector<double>({30}));
+  });
+  Message msg;
+  queue.WaitAndPop(&msg);
+  // the Get registers its handle after sending the request
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  Message reply;
+  reply.meta.sender = 2;
+  reply.meta.flag = Flag::kGet;
+  reply.AddData(third_party::SArray<Key>({3}));
+  reply.AddData(third_party::SArray<double>({30}));
+  callback_runner.AddResponse(kTestAppThreadId, kTestModelId, reply);
+  th.join();
+  EXPECT_EQ(msg.meta.flag, Flag::kGetReplica);
+  EXPECT_EQ(msg.meta.recver, 2);
+  ASSERT_EQ(msg.data.size(), 3);
+  EXPECT_EQ(third_party::SArray<uint32_t>(msg.data[1])[0], 0);
+  EXPECT_EQ(third_party::SArray<uint64_t>(msg.data[2])[0], 1);
+}
+
 }  // namespace csci5570
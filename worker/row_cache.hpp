@@ -0,0 +1,86 @@
+#pragma once
+
+#include "glog/logging.h"
+
+#include "base/magic.hpp"
+#include "base/message.hpp"
+#include "base/third_party/sarray.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace csci5570 {
+
+/**
+ * Keeps the rows pushed by the eager SSP servers to a worker, one kRefresh per server, until the next one replaces
+ * it. The rows stay encoded in the precision of the table.
+ *
+ * A kRefresh is filled in by the worker thread while the user thread reads, hence the lock.
+ */
+class RowCache {
+ public:
+  /**
+   * Keep the rows of a kRefresh: the keys, sorted, their rows, and the number of updates of the worker they hold.
+   * Its round is the largest clock of the worker allowed to read them.
+   */
+  void Update(const Message& msg) {
+    CHECK_EQ(msg.data.size(), 3);
+    Entry entry;
+    entry.keys = third_party::SArray<Key>(msg.data[0]);
+    entry.rows = msg.data[1];
+    entry.max_clock = msg.meta.round;
+    entry.num_updates = third_party::SArray<uint64_t>(msg.data[2])[0];
+    std::lock_guard<std::mutex> lk(mu_);
+    entries_[msg.meta.sender] = entry;
+  }
+
+  /**
+   * Copy the rows of the keys pushed by a server to rows, one row after another, if the worker may read them
+   *
+   * @param sid           the server
+   * @param keys          the keys
+   * @param clock         the clock of the worker
+   * @param num_updates   the updates the worker sent to the server, which the rows must all hold
+   * @param rows          filled with the encoded rows of the keys
+   * @return              false if a key was not pushed, or the rows are too stale for the clock or miss an update
+   */
+  bool Get(uint32_t sid, const third_party::SArray<Key>& keys, int clock, uint64_t num_updates,
+           third_party::SArray<char>* rows) const {
+    std::lock_guard<std::mutex> lk(mu_);
+    auto it = entries_.find(sid);
+    if (it == entries_.end())
+      return false;
+    const Entry& entry = it->second;
+    if (clock > entry.max_clock || num_updates > entry.num_updates || entry.keys.empty())
+      return false;
+    size_t row_bytes = entry.rows.size() / entry.keys.size();
+    rows->resize(keys.size() * row_bytes);
+    for (size_t i = 0; i < keys.size(); i++) {
+      auto pos = std::lower_bound(entry.keys.begin(), entry.keys.end(), keys[i]);
+      if (pos == entry.keys.end() || *pos != keys[i])
+        return false;
+      std::memcpy(rows->data() + i * row_bytes, entry.rows.data() + (pos - entry.keys.begin()) * row_bytes, row_bytes);
+    }
+    return true;
+  }
+
+  size_t NumServers() const {
+    std::lock_guard<std::mutex> lk(mu_);
+    return entries_.size();
+  }
+
+ private:
+  struct Entry {
+    third_party::SArray<Key> keys;  // sorted
+    third_party::SArray<char> rows;
+    int max_clock;
+    uint64_t num_updates;
+  };
+
+  mutable std::mutex mu_;
+  std::map<uint32_t, Entry> entries_;  // {server id: the rows it pushed last}
+};
+
+}  // namespace csci5570
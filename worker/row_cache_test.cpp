@@ -0,0 +1,52 @@
+#include "glog/logging.h"
+#include "gtest/gtest.h"
+
+#include "worker/row_cache.hpp"
+
+#include <vector>
+
+namespace csci5570 {
+namespace {
+
+class TestRowCache : public testing::Test {
+ public:
+  TestRowCache() {}
+  ~TestRowCache() {}
+
+ protected:
+  void SetUp() {}
+  void TearDown() {}
+};
+
+TEST_F(TestRowCache, Get) {
+  RowCache cache;
+  Message refresh;
+  refresh.meta.sender = 1;
+  refresh.meta.flag = Flag::kRefresh;
+  refresh.meta.round = 3;
+  refresh.AddData(third_party::SArray<Key>({2, 4, 6}));
+  refresh.AddData(third_party::SArray<int>({20, 40, 60}));
+  refresh.AddData(third_party::SArray<uint64_t>({5}));
+  cache.Update(refresh);
+  EXPECT_EQ(cache.NumServers(), 1);
+
+  third_party::SArray<char> rows;
+  ASSERT_TRUE(cache.Get(1, third_party::SArray<Key>({6, 2}), 3, 5, &rows));
+  auto vals = third_party::SArray<int>(rows);
+  EXPECT_EQ(std::vector<int>(vals.begin(), vals.end()), std::vector<int>({60, 20}));
+
+  // another server, a key not pushed, a clock beyond the bound, an update not held yet
+  EXPECT_FALSE(cache.Get(0, third_party::SArray<Key>({2}), 3, 5, &rows));
+  EXPECT_FALSE(cache.Get(1, third_party::SArray<Key>({2, 3}), 3, 5, &rows));
+  EXPECT_FALSE(cache.Get(1, third_party::SArray<Key>({2}), 4, 5, &rows));
+  EXPECT_FALSE(cache.Get(1, third_party::SArray<Key>({2}), 3, 6, &rows));
+
+  // the next push replaces the rows
+  refresh.meta.round = 4;
+  refresh.data[2] = third_party::SArray<char>(third_party::SArray<uint64_t>({6}));
+  cache.Update(refresh);
+  EXPECT_TRUE(cache.Get(1, third_party::SArray<Key>({2}), 4, 6, &rows));
+}
+
+}  // namespace
+}  // namespace csci5570
@@ -56,6 +56,10 @@ class WorkerHelperThread : public AbstractWorkerThread {
           //LOG(INFO) << "worker add message";
           this->OnReceive(m);
           break;
+        case Flag::kRefresh:
+          // pushed by an eager server, not a reply to a request
+          callback_runner_->AddPush(m.meta.recver, m.meta.model_id, m);
+          break;
       }
     }
   }